@@ -2,33 +2,64 @@
 
 #define KATWINDOW_X11 0
 #define KATWINDOW_WIN32 1
+// Same X servers as KATWINDOW_X11 through libxcb
+#define KATWINDOW_XCB 2
+// Native Wayland, needs the protocol headers the build generates
+#define KATWINDOW_WAYLAND 3
+// No windowing system at all: fake monitors, offscreen windows and injected events, for benchmarks and CI
+#define KATWINDOW_HEADLESS 4
 
-#ifndef KATWINDOW_TARGET
+// Every backend the build can compile is compiled in, and windowing_engine picks one at runtime (see
+// kat/window/backend.hpp). XCB and Wayland are opt-in through KATWINDOW_WITH_XCB and KATWINDOW_WITH_WAYLAND, which
+// the build sets when it links their libraries, and KATWINDOW_WITHOUT_X11 leaves Xlib out for builds that don't
+// link it. The headless backend needs nothing and is always there, but only runs when asked for by name (or when
+// nothing else was built). Setting KATWINDOW_TARGET builds that one backend and nothing else.
+#ifdef KATWINDOW_TARGET
+#if KATWINDOW_TARGET == KATWINDOW_X11
+#define KATWINDOW_TARGET_X11
+#elif KATWINDOW_TARGET == KATWINDOW_WIN32
+#define KATWINDOW_TARGET_WIN32
+#elif KATWINDOW_TARGET == KATWINDOW_XCB
+#define KATWINDOW_TARGET_XCB
+#elif KATWINDOW_TARGET == KATWINDOW_WAYLAND
+#define KATWINDOW_TARGET_WAYLAND
+#elif KATWINDOW_TARGET == KATWINDOW_HEADLESS
+#define KATWINDOW_TARGET_HEADLESS
+#else
+#error "Invalid value for KATWINDOW_TARGET preprocessor macro."
+#endif
+#else
 #if defined(WIN32) || defined(WIN32_) || defined(__WIN32__) || defined(__NT__)
-#define KATWINDOW_TARGET KATWINDOW_WIN32
+#define KATWINDOW_TARGET_WIN32
 #elif __APPLE__
 #error "Apple operating systems are currently unsupported"
 #elif __ANDROID__
 #error "Android is unsupported"
 #elif __linux__
-#if __has_include("X11/Xlib.h")
-#define KATWINDOW_TARGET KATWINDOW_X11
-#else
+#if !defined(KATWINDOW_WITHOUT_X11) && __has_include("X11/Xlib.h")
+#define KATWINDOW_TARGET_X11
+#endif
+// only when asked for, the build has to link libxcb to match
+#ifdef KATWINDOW_WITH_XCB
+#define KATWINDOW_TARGET_XCB
+#endif
+#ifdef KATWINDOW_WITH_WAYLAND
+#define KATWINDOW_TARGET_WAYLAND
+#endif
+// leaving X11 out on purpose may leave nothing but headless, which is what display-less CI machines want
+#if !defined(KATWINDOW_WITHOUT_X11) && !defined(KATWINDOW_TARGET_X11) && !defined(KATWINDOW_TARGET_XCB) && !defined(KATWINDOW_TARGET_WAYLAND)
 #error "Determined linux environment but cannot find development headers for a supported windowing system. Check build environment (might need to install dev libraries for your windowing system library)"
 #endif
 #else
 #error "Couldn't detect a valid system to build for. Try setting the KATWINDOW_TARGET preprocessor macro manually."
 #endif
-#endif
-
-#if KATWINDOW_TARGET == KATWINDOW_X11
-#define KATWINDOW_TARGET_X11
-#elif KATWINDOW_TARGET == KATWINDOW_WIN32
-#define KATWINDOW_TARGET_WIN32
-#else
-#error "Invalid value for KATWINDOW_TARGET preprocessor macro."
+#define KATWINDOW_TARGET_HEADLESS
 #endif
 
 #ifndef KAT_BASE_DPI
 #define KAT_BASE_DPI 96.f
-#endif
\ No newline at end of file
+#endif
+
+#ifndef KAT_EVENT_QUEUE_CAPACITY
+#define KAT_EVENT_QUEUE_CAPACITY 1024
+#endif
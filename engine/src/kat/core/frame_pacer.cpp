@@ -0,0 +1,82 @@
+#include "frame_pacer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace kat::core {
+    frame_pacer::frame_pacer(std::chrono::nanoseconds period) : m_period(period) {
+        m_last_frame = clock::now();
+        m_deadline = m_last_frame + m_period;
+    }
+
+    void frame_pacer::period(std::chrono::nanoseconds new_period) {
+        if (new_period.count() <= 0 || new_period == m_period) return;
+
+        m_deadline += new_period - m_period;
+        m_period = new_period;
+    }
+
+    std::chrono::nanoseconds frame_pacer::period() const {
+        return m_period;
+    }
+
+    void frame_pacer::wait() {
+        auto now = clock::now();
+
+        if (now > m_deadline) {
+            auto late = now - m_deadline;
+            auto skipped = static_cast<uint64_t>(late / m_period) + 1;
+            m_stats.missed_frames += skipped;
+            if (late > m_stats.worst_lateness) {
+                m_stats.worst_lateness = std::chrono::duration_cast<std::chrono::nanoseconds>(late);
+            }
+
+            // realign to the original grid so the schedule stays in phase with the display
+            m_deadline += m_period * skipped;
+        }
+
+        sleep_until(m_deadline);
+
+        now = clock::now();
+        auto frame_time = std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_last_frame);
+        m_last_frame = now;
+        m_deadline += m_period;
+
+        m_stats.frames++;
+        m_stats.last_frame_time = frame_time;
+        m_stats.average_frame_time += (frame_time - m_stats.average_frame_time) / static_cast<int64_t>(std::min<uint64_t>(m_stats.frames, 64));
+    }
+
+    const frame_stats &frame_pacer::stats() const {
+        return m_stats;
+    }
+
+    void frame_pacer::reset_stats() {
+        m_stats = {};
+    }
+
+    void frame_pacer::sleep_until(clock::time_point deadline) {
+        using namespace std::chrono_literals;
+
+        while (true) {
+            auto remaining = std::chrono::duration<double, std::nano>(deadline - clock::now()).count();
+
+            // sleep while even a pessimistic (mean + 2 sigma) sleep would still wake us before the deadline
+            if (remaining <= m_sleep_mean + 2.0 * std::sqrt(m_sleep_variance)) break;
+
+            auto start = clock::now();
+            std::this_thread::sleep_for(1ms);
+            double observed = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+
+            // exponentially weighted, so the estimate follows changes in system load
+            constexpr double alpha = 0.05;
+            double delta = observed - m_sleep_mean;
+            m_sleep_mean += alpha * delta;
+            m_sleep_variance = (1.0 - alpha) * (m_sleep_variance + alpha * delta * delta);
+        }
+
+        while (clock::now() < deadline) {
+            std::this_thread::yield();
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace kat::core {
+    struct frame_stats {
+        uint64_t frames = 0;
+
+        /**
+         * Deadlines that passed before wait() was called. A frame that overran by several periods counts each
+         * skipped deadline.
+         */
+        uint64_t missed_frames = 0;
+
+        std::chrono::nanoseconds last_frame_time{0};
+        std::chrono::nanoseconds average_frame_time{0};
+        std::chrono::nanoseconds worst_lateness{0};
+    };
+
+    /**
+     * Paces a loop to a fixed period (normally the refresh period of the monitor the window is on).
+     *
+     * wait() sleeps in short OS sleeps while the deadline is comfortably far away and spins for the last stretch,
+     * where "comfortably" is learned from how much the OS has been oversleeping. That keeps CPU use low without
+     * paying the OS scheduler's jitter at the deadline. When a frame misses its deadline the schedule skips ahead
+     * instead of trying to catch up with a burst of short frames.
+     */
+    class frame_pacer {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        explicit frame_pacer(std::chrono::nanoseconds period);
+
+        /**
+         * Changes the target period, keeping the current deadline.
+         */
+        void period(std::chrono::nanoseconds new_period);
+        [[nodiscard]] std::chrono::nanoseconds period() const;
+
+        /**
+         * Blocks until the next frame deadline. Call once per frame.
+         */
+        void wait();
+
+        [[nodiscard]] const frame_stats& stats() const;
+        void reset_stats();
+
+    private:
+        void sleep_until(clock::time_point deadline);
+
+        std::chrono::nanoseconds m_period;
+        clock::time_point m_deadline;
+        clock::time_point m_last_frame;
+
+        // running estimate of how long a 1ms sleep really takes, in ns
+        double m_sleep_mean = 1.5e6, m_sleep_variance = 0.0;
+
+        frame_stats m_stats;
+    };
+}
@@ -0,0 +1,213 @@
+#include "profiler.hpp"
+#include <spdlog/spdlog.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace kat::core::profiler {
+    namespace {
+        struct zone_record {
+            const char* name;
+            uint64_t begin, end;
+        };
+
+        // Records are only ever appended by the owning thread. `count` is published with release after a record is
+        // written, so a reader that loads it with acquire sees complete records up to that point.
+        struct chunk {
+            static constexpr uint32_t capacity = 4096;
+
+            std::array<zone_record, capacity> records;
+            std::atomic<uint32_t> count = 0;
+            std::atomic<chunk*> next = nullptr;
+        };
+
+        // 64 chunks of 24 byte records is 6MB and a few minutes of a busy thread at 60fps, after that the oldest
+        // chunk is reused so a long session keeps its most recent zones instead of growing without bound
+        constexpr uint32_t max_chunks_per_thread = 64;
+
+        struct thread_buffer {
+            uint32_t id;
+            std::atomic<const char*> name = nullptr;
+            chunk* head = nullptr; // changed under the registry mutex, the lock a trace being written holds
+            chunk* tail = nullptr; // only touched by the owning thread
+            uint32_t chunks = 0; // only touched by the owning thread
+            uint64_t overwritten = 0; // under the registry mutex
+            std::atomic<uint64_t> dropped = 0; // zones lost because a chunk couldn't be allocated
+
+            explicit thread_buffer(uint32_t id_) : id(id_) {}
+
+            ~thread_buffer() {
+                for (chunk* c = head ; c ;) {
+                    chunk* next = c->next.load();
+                    delete c;
+                    c = next;
+                }
+            }
+        };
+
+        struct registry;
+        bool write_trace(registry& r, const std::string& path);
+
+        struct registry {
+            std::mutex mutex;
+            std::vector<std::unique_ptr<thread_buffer>> buffers;
+            std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+            ~registry() {
+                // no logging here, spdlog may already be gone during static destruction
+                if (const char* path = std::getenv("KAT_PROFILE_OUTPUT")) {
+                    write_trace(*this, path);
+                }
+            }
+        };
+
+        registry& get_registry() {
+            static registry r;
+            return r;
+        }
+
+        // Buffers belong to the registry rather than the thread, so zones from threads that already exited
+        // still make it into the trace.
+        thread_buffer& local_buffer() {
+            thread_local thread_buffer* buffer = [] {
+                auto& r = get_registry();
+                std::lock_guard lock(r.mutex);
+                r.buffers.push_back(std::make_unique<thread_buffer>(static_cast<uint32_t>(r.buffers.size() + 1)));
+                return r.buffers.back().get();
+            }();
+            return *buffer;
+        }
+
+        void write_json_string(std::FILE* f, const char* s) {
+            std::fputc('"', f);
+            for (; *s ; s++) {
+                char c = *s;
+                if (c == '"' || c == '\\') {
+                    std::fputc('\\', f);
+                    std::fputc(c, f);
+                } else if (static_cast<unsigned char>(c) < 0x20) {
+                    std::fprintf(f, "\\u%04x", c);
+                } else {
+                    std::fputc(c, f);
+                }
+            }
+            std::fputc('"', f);
+        }
+    }
+
+    uint64_t now() noexcept {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - get_registry().epoch).count());
+    }
+
+    void record(const char *name, uint64_t begin, uint64_t end) noexcept {
+        auto& buffer = local_buffer();
+        chunk* c = buffer.tail;
+
+        // the first chunk is allocated by the first zone, the same way as every later one
+        uint32_t count = c ? c->count.load(std::memory_order_relaxed) : chunk::capacity;
+        if (count == chunk::capacity) {
+            chunk* fresh;
+            if (buffer.chunks < max_chunks_per_thread) {
+                // out of memory loses this zone rather than terminating from inside the profiler
+                fresh = new (std::nothrow) chunk();
+                if (!fresh) {
+                    buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                buffer.chunks++;
+            } else {
+                // a trace being written may be reading the oldest chunk, wait for it before reusing that
+                auto& r = get_registry();
+                std::lock_guard lock(r.mutex);
+                fresh = buffer.head;
+                buffer.head = fresh->next.load(std::memory_order_relaxed);
+                buffer.overwritten += fresh->count.load(std::memory_order_relaxed);
+                fresh->count.store(0, std::memory_order_relaxed);
+                fresh->next.store(nullptr, std::memory_order_relaxed);
+            }
+            if (c) {
+                c->next.store(fresh, std::memory_order_release);
+            } else {
+                std::lock_guard lock(get_registry().mutex);
+                buffer.head = fresh;
+            }
+            buffer.tail = c = fresh;
+            count = 0;
+        }
+
+        c->records[count] = { name, begin, end };
+        c->count.store(count + 1, std::memory_order_release);
+    }
+
+    void set_thread_name(const char *name) {
+        local_buffer().name.store(name, std::memory_order_release);
+    }
+
+    namespace {
+        bool write_trace(registry& r, const std::string& path) {
+            std::FILE* f = std::fopen(path.c_str(), "w");
+            if (!f) return false;
+
+            std::lock_guard lock(r.mutex);
+
+            std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", f);
+            bool first = true;
+            for (const auto& buffer : r.buffers) {
+                if (const char* name = buffer->name.load(std::memory_order_acquire)) {
+                    std::fprintf(f, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", first ? "" : ",", buffer->id);
+                    write_json_string(f, name);
+                    std::fputs("}}", f);
+                    first = false;
+                }
+
+                for (chunk* c = buffer->head ; c ; c = c->next.load(std::memory_order_acquire)) {
+                    uint32_t count = c->count.load(std::memory_order_acquire);
+                    for (uint32_t i = 0 ; i < count ; i++) {
+                        const auto& z = c->records[i];
+                        // trace timestamps are microseconds, keep nanosecond precision in the fraction
+                        std::fprintf(f, "%s{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"name\":", first ? "" : ",",
+                                     buffer->id, static_cast<double>(z.begin) / 1000.0, static_cast<double>(z.end - z.begin) / 1000.0);
+                        write_json_string(f, z.name);
+                        std::fputc('}', f);
+                        first = false;
+                    }
+                }
+            }
+            std::fputs("]}\n", f);
+
+            bool ok = std::ferror(f) == 0;
+            std::fclose(f);
+            return ok;
+        }
+    }
+
+    bool write_chrome_trace(const std::string &path) {
+        if (!write_trace(get_registry(), path)) {
+            SPDLOG_ERROR("Failed to write profiler trace to {}", path);
+            return false;
+        }
+
+        SPDLOG_INFO("Wrote profiler trace to {}", path);
+
+        auto& r = get_registry();
+        std::lock_guard lock(r.mutex);
+        uint64_t overwritten = 0, dropped = 0;
+        for (const auto& buffer : r.buffers) {
+            overwritten += buffer->overwritten;
+            dropped += buffer->dropped.load(std::memory_order_relaxed);
+        }
+        if (overwritten) {
+            SPDLOG_WARN("The trace starts late, the {} oldest zones were overwritten", overwritten);
+        }
+        if (dropped) {
+            SPDLOG_WARN("{} zones are missing from the trace, there was no memory to record them", dropped);
+        }
+        return true;
+    }
+}
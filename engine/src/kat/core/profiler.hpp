@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/**
+ * CPU profiler zones. Everything here compiles to nothing unless the engine is built with KAT_PROFILE
+ * (the KAT_PROFILE CMake option).
+ *
+ * KAT_PROFILE_ZONE("name") times the enclosing scope, KAT_PROFILE_FUNCTION() names the zone after the function.
+ * Zone names must outlive the program (string literals or __func__). The recorded timeline is written as Chrome
+ * trace JSON (loadable in chrome://tracing or ui.perfetto.dev) by KAT_PROFILE_WRITE(path), and automatically at
+ * exit to the path in the KAT_PROFILE_OUTPUT environment variable if it is set.
+ */
+
+namespace kat::core::profiler {
+    uint64_t now() noexcept;
+
+    /**
+     * Appends a completed zone to the calling thread's buffer. Only allocates when the thread's current chunk of
+     * records fills up. Each thread keeps its newest 262144 zones (64 chunks of 4096); past that a full chunk
+     * reuses the thread's oldest one. That and a thread's first zone are the only times this takes a lock.
+     * Never throws: a zone that needs a chunk when none can be allocated is dropped, and write_chrome_trace()
+     * warns about how many were.
+     */
+    void record(const char* name, uint64_t begin, uint64_t end) noexcept;
+
+    /**
+     * Names the calling thread in the trace.
+     */
+    void set_thread_name(const char* name);
+
+    /**
+     * Writes every zone still buffered, from all threads, as Chrome trace JSON. Safe to call while other threads
+     * keep recording; their newest zones may or may not be included, and a thread that has to reuse a chunk waits
+     * until the write is done.
+     */
+    bool write_chrome_trace(const std::string& path);
+
+    class scoped_zone {
+    public:
+        explicit scoped_zone(const char* name) noexcept : m_name(name), m_begin(now()) {}
+        ~scoped_zone() { record(m_name, m_begin, now()); }
+
+        scoped_zone(const scoped_zone&) = delete;
+        scoped_zone& operator=(const scoped_zone&) = delete;
+
+    private:
+        const char* m_name;
+        uint64_t m_begin;
+    };
+}
+
+#ifdef KAT_PROFILE
+#define KAT_PROFILE_CONCAT_IMPL(a, b) a##b
+#define KAT_PROFILE_CONCAT(a, b) KAT_PROFILE_CONCAT_IMPL(a, b)
+#define KAT_PROFILE_ZONE(name) ::kat::core::profiler::scoped_zone KAT_PROFILE_CONCAT(kat_profile_zone_, __LINE__)(name)
+#define KAT_PROFILE_FUNCTION() KAT_PROFILE_ZONE(__func__)
+#define KAT_PROFILE_THREAD(name) ::kat::core::profiler::set_thread_name(name)
+#define KAT_PROFILE_WRITE(path) ::kat::core::profiler::write_chrome_trace(path)
+#else
+#define KAT_PROFILE_ZONE(name) ((void)0)
+#define KAT_PROFILE_FUNCTION() ((void)0)
+#define KAT_PROFILE_THREAD(name) ((void)0)
+#define KAT_PROFILE_WRITE(path) ((void)0)
+#endif
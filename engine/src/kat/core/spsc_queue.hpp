@@ -0,0 +1,68 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace kat::core {
+    /**
+     * Bounded lock-free single-producer/single-consumer queue.
+     *
+     * Exactly one thread may call try_push and exactly one (other) thread may call try_pop. Each side keeps a
+     * private copy of the other side's index and only reloads the shared atomic when that copy says the queue looks
+     * full/empty, so the common case touches no cache line owned by the other thread.
+     */
+    template<typename T, std::size_t Capacity>
+    class spsc_queue {
+        static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "spsc_queue capacity must be a power of two");
+
+        static constexpr std::size_t cache_line = 64;
+
+    public:
+        static constexpr std::size_t capacity = Capacity;
+
+        bool try_push(const T& value) noexcept {
+            const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+            if (tail - m_producer_head == Capacity) {
+                m_producer_head = m_head.load(std::memory_order_acquire);
+                if (tail - m_producer_head == Capacity) {
+                    return false;
+                }
+            }
+
+            m_items[tail & (Capacity - 1)] = value;
+            m_tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool try_pop(T& out) noexcept {
+            const std::size_t head = m_head.load(std::memory_order_relaxed);
+            if (head == m_consumer_tail) {
+                m_consumer_tail = m_tail.load(std::memory_order_acquire);
+                if (head == m_consumer_tail) {
+                    return false;
+                }
+            }
+
+            out = m_items[head & (Capacity - 1)];
+            m_head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * Approximate when called from a thread that is neither the producer nor the consumer.
+         */
+        [[nodiscard]] bool empty() const noexcept {
+            return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+        }
+
+    private:
+        alignas(cache_line) std::atomic<std::size_t> m_head{0};
+        std::size_t m_consumer_tail = 0;
+
+        alignas(cache_line) std::atomic<std::size_t> m_tail{0};
+        std::size_t m_producer_head = 0;
+
+        alignas(cache_line) std::array<T, Capacity> m_items{};
+    };
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "kat/window/window.hpp"
+#include "kat/jobs/job_system.hpp"
+#include "kat/input/gamepad.hpp"
+
+#include <memory>
+
+namespace kat {
+    struct engine_config {
+        window::windowing_engine_config windowing{};
+
+        /**
+         * Worker threads for the job system, 0 picks one per hardware thread (minus the game thread).
+         */
+        uint32_t worker_threads = 0;
+
+        /**
+         * Start the gamepad reader thread.
+         */
+        bool gamepads = true;
+    };
+
+    /**
+     * Owns the engine-wide subsystems: the windowing engine, the job system shared by engine and game code and the
+     * gamepad reader.
+     */
+    struct engine {
+        std::shared_ptr<window::windowing_engine> windowing;
+        std::unique_ptr<::kat::jobs::job_system> jobs;
+        std::unique_ptr<input::gamepad_reader> gamepads;
+
+        [[nodiscard]] static inline std::shared_ptr<engine> create(const engine_config& config = {}) {
+            auto sp = std::make_shared<engine>();
+            sp->jobs = std::make_unique<::kat::jobs::job_system>(config.worker_threads);
+            sp->windowing = window::windowing_engine::create(config.windowing);
+            sp->gamepads = std::make_unique<input::gamepad_reader>();
+            if (config.gamepads) {
+                sp->gamepads->start();
+            }
+            return sp;
+        }
+    };
+}
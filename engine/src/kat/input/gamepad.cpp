@@ -0,0 +1,99 @@
+#include "gamepad.hpp"
+#include <spdlog/spdlog.h>
+#include <cstring>
+
+namespace kat::input {
+    std::string_view gamepad_device_info::name_view() const noexcept {
+        return { name, strnlen(name, sizeof(name)) };
+    }
+
+    void gamepads::begin_frame() noexcept {
+        for (auto& s : m_state) {
+            s.pressed.reset();
+            s.released.reset();
+        }
+    }
+
+    void gamepads::handle_event(const gamepad_event &e) noexcept {
+        if (e.slot >= m_state.size()) return;
+        auto& s = m_state[e.slot];
+
+        switch (e.type) {
+            case gamepad_event_type::connected:
+                s = {};
+                s.connected = true;
+                s.info = e.device;
+                break;
+            case gamepad_event_type::disconnected:
+                s.released |= s.current;
+                s.current.reset();
+                s.axes.fill(0.f);
+                s.connected = false;
+                break;
+            case gamepad_event_type::button_down:
+            case gamepad_event_type::button_up:
+                if (e.control.index < max_buttons) {
+                    bool is_down = e.type == gamepad_event_type::button_down;
+                    if (is_down != s.current[e.control.index]) {
+                        (is_down ? s.pressed : s.released)[e.control.index] = true;
+                    }
+                    s.current[e.control.index] = is_down;
+                }
+                break;
+            case gamepad_event_type::axis:
+                if (e.control.index < max_axes) {
+                    s.axes[e.control.index] = e.control.value;
+                }
+                break;
+        }
+    }
+
+    bool gamepads::connected(std::size_t slot) const noexcept {
+        return slot < m_state.size() && m_state[slot].connected;
+    }
+
+    bool gamepads::down(std::size_t slot, std::size_t button) const noexcept {
+        return slot < m_state.size() && button < max_buttons && m_state[slot].current[button];
+    }
+
+    bool gamepads::pressed(std::size_t slot, std::size_t button) const noexcept {
+        return slot < m_state.size() && button < max_buttons && m_state[slot].pressed[button];
+    }
+
+    bool gamepads::released(std::size_t slot, std::size_t button) const noexcept {
+        return slot < m_state.size() && button < max_buttons && m_state[slot].released[button];
+    }
+
+    float gamepads::axis(std::size_t slot, std::size_t axis) const noexcept {
+        return slot < m_state.size() && axis < max_axes ? m_state[slot].axes[axis] : 0.f;
+    }
+
+    bool gamepad_reader::poll(gamepad_event &out) noexcept {
+        return m_events.try_pop(out);
+    }
+
+    std::size_t gamepad_reader::dropped() const noexcept {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+
+    void gamepad_reader::push(const gamepad_event &e) noexcept {
+        if (!m_events.try_push(e)) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+#ifndef __linux__
+    struct gamepad_reader::device {};
+
+    gamepad_reader::gamepad_reader() = default;
+    gamepad_reader::~gamepad_reader() = default;
+
+    bool gamepad_reader::start() {
+        SPDLOG_WARN("Gamepad input is not supported on this platform");
+        return false;
+    }
+
+    void gamepad_reader::stop() {
+    }
+#endif
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "kat/core/spsc_queue.hpp"
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <thread>
+
+namespace kat::input {
+    enum class gamepad_event_type : uint8_t {
+        connected,
+        disconnected,
+        button_down,
+        button_up,
+        axis
+    };
+
+    /**
+     * Sent with `connected`. Buttons and axes are numbered densely in the order of the device's own codes, so an
+     * arcade stick with 8 buttons reports buttons 0-7 whatever codes its firmware picked.
+     */
+    struct gamepad_device_info {
+        uint16_t vendor, product;
+        uint16_t button_count, axis_count;
+        char name[48];
+
+        [[nodiscard]] std::string_view name_view() const noexcept;
+    };
+
+    struct gamepad_control {
+        uint16_t index;
+        /**
+         * Axes are normalized to [-1, 1] (hats come out as -1, 0 or 1), buttons are 0 or 1.
+         */
+        float value;
+    };
+
+    /**
+     * Fixed-size and trivially copyable so it can cross threads through an spsc_queue. `slot` identifies the device
+     * until its `disconnected` event, after which it may be reused. `timestamp` is in steady_clock nanoseconds, the
+     * same clock as window events.
+     */
+    struct gamepad_event {
+        gamepad_event_type type;
+        uint32_t slot;
+        uint64_t timestamp;
+        union {
+            gamepad_device_info device;
+            gamepad_control control;
+        };
+    };
+
+    /**
+     * Reads gamepads and joysticks on a dedicated thread and hands their events over through a lock-free queue.
+     *
+     * On Linux this is evdev: device fds and an inotify watch on /dev/input are multiplexed with epoll, so the
+     * thread sleeps until something actually happens and hotplug costs nothing while nothing is plugged in. Other
+     * platforms don't have a backend yet; start() returns false there.
+     */
+    class gamepad_reader {
+    public:
+        static constexpr std::size_t max_gamepads = 8;
+        static constexpr std::size_t queue_capacity = 1024;
+
+        gamepad_reader();
+        ~gamepad_reader();
+
+        gamepad_reader(const gamepad_reader&) = delete;
+        gamepad_reader& operator=(const gamepad_reader&) = delete;
+
+        /**
+         * Starts the reader thread, which reports every device already plugged in as `connected` before anything
+         * else.
+         */
+        bool start();
+        void stop();
+
+        /**
+         * Game thread only.
+         */
+        bool poll(gamepad_event& out) noexcept;
+
+        /**
+         * Events lost because the game thread didn't drain the queue in time.
+         */
+        [[nodiscard]] std::size_t dropped() const noexcept;
+
+    private:
+        struct device;
+
+        void thread_main();
+        void scan_devices();
+        void open_device(std::string_view name);
+        void close_device(std::size_t slot);
+        void close_device(std::string_view name);
+        void read_device(std::size_t slot);
+        void sync_device(std::size_t slot, uint64_t timestamp);
+        void read_hotplug();
+        void push(const gamepad_event& e) noexcept;
+
+        std::thread m_thread;
+        std::atomic<bool> m_running = false;
+        int m_epoll = -1, m_inotify = -1, m_wake = -1;
+        std::array<std::unique_ptr<device>, max_gamepads> m_devices;
+
+        core::spsc_queue<gamepad_event, queue_capacity> m_events;
+        std::atomic<std::size_t> m_dropped = 0;
+    };
+
+    /**
+     * Button and axis state of every gamepad slot, fed from a gamepad_reader on the game thread. Works like
+     * keyboard: call begin_frame() once per frame before handing it that frame's events.
+     */
+    class gamepads {
+    public:
+        static constexpr std::size_t max_buttons = 32;
+        static constexpr std::size_t max_axes = 16;
+
+        struct state {
+            bool connected = false;
+            gamepad_device_info info{};
+            std::bitset<max_buttons> current, pressed, released;
+            std::array<float, max_axes> axes{};
+        };
+
+        void begin_frame() noexcept;
+        void handle_event(const gamepad_event& e) noexcept;
+
+        [[nodiscard]] const state& operator[](std::size_t slot) const noexcept { return m_state[slot]; }
+        [[nodiscard]] bool connected(std::size_t slot) const noexcept;
+        [[nodiscard]] bool down(std::size_t slot, std::size_t button) const noexcept;
+        [[nodiscard]] bool pressed(std::size_t slot, std::size_t button) const noexcept;
+        [[nodiscard]] bool released(std::size_t slot, std::size_t button) const noexcept;
+        [[nodiscard]] float axis(std::size_t slot, std::size_t axis) const noexcept;
+
+    private:
+        std::array<state, gamepad_reader::max_gamepads> m_state;
+    };
+}
@@ -0,0 +1,394 @@
+#ifdef __linux__
+#include "gamepad.hpp"
+#include "kat/core/profiler.hpp"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <string>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <linux/input.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+namespace kat::input {
+    namespace {
+        constexpr const char* input_directory = "/dev/input";
+
+        // epoll user data: device slots are 0..max_gamepads-1, these sit above them
+        constexpr uint32_t hotplug_id = gamepad_reader::max_gamepads;
+        constexpr uint32_t wake_id = gamepad_reader::max_gamepads + 1;
+
+        constexpr std::size_t bits_per_long = sizeof(unsigned long) * 8;
+        constexpr std::size_t longs_for_bits(std::size_t bits) { return (bits + bits_per_long - 1) / bits_per_long; }
+
+        bool test_bit(const unsigned long* bits, std::size_t bit) {
+            return (bits[bit / bits_per_long] >> (bit % bits_per_long)) & 1;
+        }
+
+        uint64_t event_time(const input_event& ev) {
+            return static_cast<uint64_t>(ev.input_event_sec) * 1'000'000'000ull + static_cast<uint64_t>(ev.input_event_usec) * 1'000ull;
+        }
+
+        uint64_t monotonic_now() {
+            timespec ts{};
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000ull + static_cast<uint64_t>(ts.tv_nsec);
+        }
+
+        /**
+         * Anything with joystick/gamepad buttons. Keyboards and mice only have codes outside these ranges, so this
+         * also keeps them out without opening every event node twice.
+         */
+        bool is_gamepad(const unsigned long* key_bits) {
+            for (std::size_t code = BTN_JOYSTICK ; code < BTN_DIGI ; code++) {
+                if (test_bit(key_bits, code)) return true;
+            }
+            for (std::size_t code = BTN_TRIGGER_HAPPY ; code <= BTN_TRIGGER_HAPPY40 ; code++) {
+                if (test_bit(key_bits, code)) return true;
+            }
+            return false;
+        }
+    }
+
+    struct gamepad_reader::device {
+        int fd = -1;
+        std::string node;
+
+        // evdev code -> dense index, -1 for codes the device doesn't have
+        std::array<int16_t, KEY_CNT> button_index;
+        std::array<int16_t, ABS_CNT> axis_index;
+        std::array<input_absinfo, ABS_CNT> axis_info{};
+        uint16_t button_count = 0, axis_count = 0;
+
+        // between SYN_DROPPED and the next SYN_REPORT events are incomplete and get thrown away
+        bool dropping = false;
+
+        [[nodiscard]] float normalize(int code, int32_t value) const {
+            const auto& info = axis_info[code];
+            if (info.maximum == info.minimum) return 0.f;
+            float v = 2.f * static_cast<float>(value - info.minimum) / static_cast<float>(info.maximum - info.minimum) - 1.f;
+            return std::clamp(v, -1.f, 1.f);
+        }
+    };
+
+    gamepad_reader::gamepad_reader() = default;
+
+    gamepad_reader::~gamepad_reader() {
+        stop();
+    }
+
+    bool gamepad_reader::start() {
+        if (m_thread.joinable()) return true;
+
+        m_epoll = epoll_create1(EPOLL_CLOEXEC);
+        m_wake = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (m_epoll < 0 || m_wake < 0) {
+            SPDLOG_WARN("Failed to set up gamepad reader: {}", std::strerror(errno));
+            stop();
+            return false;
+        }
+
+        epoll_event wake_event{};
+        wake_event.events = EPOLLIN;
+        wake_event.data.u32 = wake_id;
+        // without the wake-up stop() couldn't get the thread out of epoll_wait
+        if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wake, &wake_event) < 0) {
+            SPDLOG_WARN("Failed to set up gamepad reader: {}", std::strerror(errno));
+            stop();
+            return false;
+        }
+
+        // udev creates the node before it fixes up its permissions, so IN_ATTRIB is when it usually becomes openable
+        m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        epoll_event hotplug_event{};
+        hotplug_event.events = EPOLLIN;
+        hotplug_event.data.u32 = hotplug_id;
+        if (m_inotify < 0 || inotify_add_watch(m_inotify, input_directory, IN_CREATE | IN_ATTRIB | IN_MOVED_TO | IN_DELETE) < 0 ||
+            epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_inotify, &hotplug_event) < 0) {
+            SPDLOG_WARN("Can't watch {} ({}), gamepads plugged in later won't be seen", input_directory, std::strerror(errno));
+            if (m_inotify >= 0) {
+                close(m_inotify);
+                m_inotify = -1;
+            }
+        }
+
+        m_running.store(true, std::memory_order_release);
+        m_thread = std::thread(&gamepad_reader::thread_main, this);
+        SPDLOG_DEBUG("Started gamepad reader");
+        return true;
+    }
+
+    void gamepad_reader::stop() {
+        if (m_thread.joinable()) {
+            m_running.store(false, std::memory_order_release);
+            uint64_t one = 1;
+            [[maybe_unused]] auto written = write(m_wake, &one, sizeof(one));
+            m_thread.join();
+            SPDLOG_DEBUG("Stopped gamepad reader");
+        }
+
+        // the thread is gone, nobody is left to read a disconnected event off the queue that matters
+        for (auto& dev : m_devices) {
+            if (dev) {
+                close(dev->fd);
+                dev.reset();
+            }
+        }
+
+        for (int* fd : { &m_epoll, &m_inotify, &m_wake }) {
+            if (*fd >= 0) {
+                close(*fd);
+                *fd = -1;
+            }
+        }
+    }
+
+    void gamepad_reader::thread_main() {
+        KAT_PROFILE_THREAD("kat-gamepads");
+        scan_devices();
+
+        epoll_event ready[16];
+        while (m_running.load(std::memory_order_acquire)) {
+            int count = epoll_wait(m_epoll, ready, static_cast<int>(std::size(ready)), -1);
+            if (count < 0) {
+                if (errno == EINTR) continue;
+                SPDLOG_WARN("epoll_wait failed, gamepad reader stopping: {}", std::strerror(errno));
+                break;
+            }
+
+            for (int i = 0 ; i < count ; i++) {
+                uint32_t id = ready[i].data.u32;
+                if (id == wake_id) continue;
+                if (id == hotplug_id) {
+                    read_hotplug();
+                } else if (m_devices[id]) {
+                    read_device(id);
+                }
+            }
+        }
+    }
+
+    void gamepad_reader::scan_devices() {
+        DIR* dir = opendir(input_directory);
+        if (!dir) return;
+
+        while (dirent* entry = readdir(dir)) {
+            open_device(entry->d_name);
+        }
+        closedir(dir);
+    }
+
+    void gamepad_reader::open_device(std::string_view name) {
+        if (!name.starts_with("event")) return;
+        for (const auto& dev : m_devices) {
+            if (dev && dev->node == name) return;
+        }
+
+        std::string path = std::string(input_directory) + "/" + std::string(name);
+        int fd = open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) {
+            // EACCES until udev is done with it; IN_ATTRIB brings us back here
+            return;
+        }
+
+        unsigned long key_bits[longs_for_bits(KEY_CNT)] = {};
+        unsigned long abs_bits[longs_for_bits(ABS_CNT)] = {};
+        if (ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(key_bits)), key_bits) < 0 || !is_gamepad(key_bits)) {
+            close(fd);
+            return;
+        }
+        ioctl(fd, EVIOCGBIT(EV_ABS, sizeof(abs_bits)), abs_bits);
+
+        auto free_slot = std::find(m_devices.begin(), m_devices.end(), nullptr);
+        if (free_slot == m_devices.end()) {
+            SPDLOG_WARN("Ignoring {}, already reading {} gamepads", path, max_gamepads);
+            close(fd);
+            return;
+        }
+        auto slot = static_cast<std::size_t>(free_slot - m_devices.begin());
+
+        // stamp events with the clock steady_clock uses rather than wall time
+        int clock = CLOCK_MONOTONIC;
+        ioctl(fd, EVIOCSCLOCKID, &clock);
+
+        auto dev = std::make_unique<device>();
+        dev->fd = fd;
+        dev->node = name;
+        dev->button_index.fill(-1);
+        dev->axis_index.fill(-1);
+
+        // joystick and gamepad buttons first so they get the low indices, then the misc ones
+        auto add_buttons = [&](std::size_t first, std::size_t last) {
+            for (std::size_t code = first ; code < last ; code++) {
+                if (test_bit(key_bits, code)) dev->button_index[code] = static_cast<int16_t>(dev->button_count++);
+            }
+        };
+        add_buttons(BTN_JOYSTICK, KEY_CNT);
+        add_buttons(BTN_MISC, BTN_JOYSTICK);
+
+        // ABS_MISC and up are multitouch and friends, not sticks
+        for (std::size_t code = 0 ; code < ABS_MISC ; code++) {
+            if (test_bit(abs_bits, code) && ioctl(fd, EVIOCGABS(code), &dev->axis_info[code]) >= 0) {
+                dev->axis_index[code] = static_cast<int16_t>(dev->axis_count++);
+            }
+        }
+
+        gamepad_event e{};
+        e.type = gamepad_event_type::connected;
+        e.slot = static_cast<uint32_t>(slot);
+        e.timestamp = monotonic_now();
+        e.device.button_count = dev->button_count;
+        e.device.axis_count = dev->axis_count;
+        input_id id{};
+        if (ioctl(fd, EVIOCGID, &id) >= 0) {
+            e.device.vendor = id.vendor;
+            e.device.product = id.product;
+        }
+        ioctl(fd, EVIOCGNAME(sizeof(e.device.name) - 1), e.device.name);
+
+        epoll_event device_event{};
+        device_event.events = EPOLLIN;
+        device_event.data.u32 = static_cast<uint32_t>(slot);
+        if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &device_event) < 0) {
+            close(fd);
+            return;
+        }
+
+        SPDLOG_INFO("Gamepad {} connected: {} ({:04x}:{:04x}, {} buttons, {} axes)", slot, e.device.name_view(),
+                    e.device.vendor, e.device.product, dev->button_count, dev->axis_count);
+        m_devices[slot] = std::move(dev);
+        push(e);
+        sync_device(slot, e.timestamp);
+    }
+
+    void gamepad_reader::close_device(std::size_t slot) {
+        auto& dev = m_devices[slot];
+        epoll_ctl(m_epoll, EPOLL_CTL_DEL, dev->fd, nullptr);
+        close(dev->fd);
+        dev.reset();
+
+        gamepad_event e{};
+        e.type = gamepad_event_type::disconnected;
+        e.slot = static_cast<uint32_t>(slot);
+        e.timestamp = monotonic_now();
+        push(e);
+        SPDLOG_INFO("Gamepad {} disconnected", slot);
+    }
+
+    void gamepad_reader::close_device(std::string_view name) {
+        for (std::size_t slot = 0 ; slot < m_devices.size() ; slot++) {
+            if (m_devices[slot] && m_devices[slot]->node == name) {
+                close_device(slot);
+            }
+        }
+    }
+
+    void gamepad_reader::read_device(std::size_t slot) {
+        auto& dev = *m_devices[slot];
+
+        input_event events[64];
+        for (;;) {
+            ssize_t bytes = read(dev.fd, events, sizeof(events));
+            if (bytes < 0) {
+                if (errno == ENODEV) {
+                    // unplugged; the inotify IN_DELETE may or may not beat us here
+                    close_device(slot);
+                }
+                return;
+            }
+
+            auto count = static_cast<std::size_t>(bytes) / sizeof(input_event);
+            for (std::size_t i = 0 ; i < count ; i++) {
+                const input_event& ev = events[i];
+
+                if (ev.type == EV_SYN) {
+                    if (ev.code == SYN_DROPPED) {
+                        dev.dropping = true;
+                    } else if (ev.code == SYN_REPORT && dev.dropping) {
+                        dev.dropping = false;
+                        sync_device(slot, event_time(ev));
+                    }
+                    continue;
+                }
+                if (dev.dropping) continue;
+
+                gamepad_event e{};
+                e.slot = static_cast<uint32_t>(slot);
+                e.timestamp = event_time(ev);
+
+                if (ev.type == EV_KEY && ev.code < KEY_CNT && dev.button_index[ev.code] >= 0 && ev.value != 2) {
+                    e.type = ev.value ? gamepad_event_type::button_down : gamepad_event_type::button_up;
+                    e.control.index = static_cast<uint16_t>(dev.button_index[ev.code]);
+                    e.control.value = ev.value ? 1.f : 0.f;
+                    push(e);
+                } else if (ev.type == EV_ABS && ev.code < ABS_CNT && dev.axis_index[ev.code] >= 0) {
+                    e.type = gamepad_event_type::axis;
+                    e.control.index = static_cast<uint16_t>(dev.axis_index[ev.code]);
+                    e.control.value = dev.normalize(ev.code, ev.value);
+                    push(e);
+                }
+            }
+
+            if (count < std::size(events)) return;
+        }
+    }
+
+    void gamepad_reader::sync_device(std::size_t slot, uint64_t timestamp) {
+        // Only on connect and after the kernel dropped events, never per frame. Reports every control;
+        // gamepads::handle_event ignores the ones that didn't change.
+        auto& dev = *m_devices[slot];
+
+        gamepad_event e{};
+        e.slot = static_cast<uint32_t>(slot);
+        e.timestamp = timestamp;
+
+        unsigned long key_state[longs_for_bits(KEY_CNT)] = {};
+        if (ioctl(dev.fd, EVIOCGKEY(sizeof(key_state)), key_state) >= 0) {
+            for (std::size_t code = 0 ; code < KEY_CNT ; code++) {
+                if (dev.button_index[code] < 0) continue;
+                bool down = test_bit(key_state, code);
+                e.type = down ? gamepad_event_type::button_down : gamepad_event_type::button_up;
+                e.control.index = static_cast<uint16_t>(dev.button_index[code]);
+                e.control.value = down ? 1.f : 0.f;
+                push(e);
+            }
+        }
+
+        for (std::size_t code = 0 ; code < ABS_CNT ; code++) {
+            if (dev.axis_index[code] < 0 || ioctl(dev.fd, EVIOCGABS(code), &dev.axis_info[code]) < 0) continue;
+            e.type = gamepad_event_type::axis;
+            e.control.index = static_cast<uint16_t>(dev.axis_index[code]);
+            e.control.value = dev.normalize(static_cast<int>(code), dev.axis_info[code].value);
+            push(e);
+        }
+    }
+
+    void gamepad_reader::read_hotplug() {
+        alignas(inotify_event) char buffer[4096];
+        for (;;) {
+            ssize_t bytes = read(m_inotify, buffer, sizeof(buffer));
+            if (bytes <= 0) return;
+
+            for (char* p = buffer ; p < buffer + bytes ; ) {
+                auto* ev = reinterpret_cast<inotify_event*>(p);
+                p += sizeof(inotify_event) + ev->len;
+                if (ev->len == 0) continue;
+
+                std::string_view name(ev->name);
+                if (ev->mask & IN_DELETE) {
+                    close_device(name);
+                } else {
+                    open_device(name);
+                }
+            }
+        }
+    }
+}
+#endif
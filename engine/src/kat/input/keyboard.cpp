@@ -0,0 +1,66 @@
+#include "keyboard.hpp"
+
+namespace kat::input {
+    void keyboard::begin_frame() noexcept {
+        m_previous = m_current;
+        m_pressed.reset();
+        m_released.reset();
+    }
+
+    void keyboard::handle_event(const window::event &e) noexcept {
+        switch (e.type) {
+            case window::event_type::key_down:
+            case window::event_type::key_up:
+                if (e.key.scancode < key_count) {
+                    bool is_down = e.type == window::event_type::key_down;
+                    // auto-repeat presses aren't transitions
+                    if (is_down != m_current[e.key.scancode]) {
+                        (is_down ? m_pressed : m_released)[e.key.scancode] = true;
+                    }
+                    m_current[e.key.scancode] = is_down;
+                }
+                break;
+            case window::event_type::focus_lost:
+                m_released |= m_current;
+                m_current.reset();
+                break;
+            default:
+                break;
+        }
+    }
+
+    void keyboard::clear() noexcept {
+        m_current.reset();
+        m_previous.reset();
+        m_pressed.reset();
+        m_released.reset();
+    }
+
+    bool keyboard::down(key k) const noexcept {
+        return down(static_cast<uint32_t>(k));
+    }
+
+    bool keyboard::down(uint32_t scancode) const noexcept {
+        return scancode < key_count && m_current[scancode];
+    }
+
+    bool keyboard::pressed(key k) const noexcept {
+        return pressed(static_cast<uint32_t>(k));
+    }
+
+    bool keyboard::pressed(uint32_t scancode) const noexcept {
+        return scancode < key_count && m_pressed[scancode];
+    }
+
+    bool keyboard::released(key k) const noexcept {
+        return released(static_cast<uint32_t>(k));
+    }
+
+    bool keyboard::released(uint32_t scancode) const noexcept {
+        return scancode < key_count && m_released[scancode];
+    }
+
+    bool keyboard::was_down(key k) const noexcept {
+        return m_previous[static_cast<uint32_t>(k)];
+    }
+}
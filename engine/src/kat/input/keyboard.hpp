@@ -0,0 +1,87 @@
+#pragma once
+
+#include "kat/window/events.hpp"
+#include <bitset>
+#include <cstdint>
+
+namespace kat::input {
+    /**
+     * Physical keys, named after the US layout. Values are Linux evdev codes, which is the space every platform's
+     * key_event::scancode is translated into.
+     */
+    enum class key : uint16_t {
+        unknown = 0,
+        escape = 1,
+        num_1 = 2, num_2 = 3, num_3 = 4, num_4 = 5, num_5 = 6, num_6 = 7, num_7 = 8, num_8 = 9, num_9 = 10, num_0 = 11,
+        minus = 12, equal = 13, backspace = 14, tab = 15,
+        q = 16, w = 17, e = 18, r = 19, t = 20, y = 21, u = 22, i = 23, o = 24, p = 25,
+        left_bracket = 26, right_bracket = 27, enter = 28, left_control = 29,
+        a = 30, s = 31, d = 32, f = 33, g = 34, h = 35, j = 36, k = 37, l = 38,
+        semicolon = 39, apostrophe = 40, grave = 41, left_shift = 42, backslash = 43,
+        z = 44, x = 45, c = 46, v = 47, b = 48, n = 49, m = 50,
+        comma = 51, period = 52, slash = 53, right_shift = 54, keypad_multiply = 55, left_alt = 56, space = 57,
+        caps_lock = 58,
+        f1 = 59, f2 = 60, f3 = 61, f4 = 62, f5 = 63, f6 = 64, f7 = 65, f8 = 66, f9 = 67, f10 = 68,
+        num_lock = 69, scroll_lock = 70,
+        keypad_7 = 71, keypad_8 = 72, keypad_9 = 73, keypad_minus = 74, keypad_4 = 75, keypad_5 = 76, keypad_6 = 77,
+        keypad_plus = 78, keypad_1 = 79, keypad_2 = 80, keypad_3 = 81, keypad_0 = 82, keypad_period = 83,
+        f11 = 87, f12 = 88,
+        keypad_enter = 96, right_control = 97, keypad_divide = 98, print_screen = 99, right_alt = 100,
+        home = 102, up = 103, page_up = 104, left = 105, right = 106, end = 107, down = 108, page_down = 109,
+        insert = 110, del = 111, pause = 119,
+        left_super = 125, right_super = 126, menu = 127,
+    };
+
+    /**
+     * Key state table fed from window events.
+     *
+     * Holds the state of every key at the end of this frame and the previous one, indexed by scancode, so
+     * queries are a bit test and never touch the platform. Transitions are recorded as they happen, so a key tapped
+     * and released within one frame still reports pressed() and released(). Call begin_frame() once per frame
+     * before handing it that frame's events.
+     */
+    class keyboard {
+    public:
+        static constexpr std::size_t key_count = 256;
+
+        /**
+         * Makes the current state the previous one.
+         */
+        void begin_frame() noexcept;
+
+        /**
+         * Applies key_down/key_up. Losing focus releases everything, the matching key_up events would go to
+         * another window.
+         */
+        void handle_event(const window::event& e) noexcept;
+
+        /**
+         * Releases every key.
+         */
+        void clear() noexcept;
+
+        [[nodiscard]] bool down(key k) const noexcept;
+        [[nodiscard]] bool down(uint32_t scancode) const noexcept;
+
+        /**
+         * Went down since the last begin_frame().
+         */
+        [[nodiscard]] bool pressed(key k) const noexcept;
+        [[nodiscard]] bool pressed(uint32_t scancode) const noexcept;
+
+        /**
+         * Went up since the last begin_frame().
+         */
+        [[nodiscard]] bool released(key k) const noexcept;
+        [[nodiscard]] bool released(uint32_t scancode) const noexcept;
+
+        /**
+         * State at the end of the previous frame.
+         */
+        [[nodiscard]] bool was_down(key k) const noexcept;
+
+    private:
+        std::bitset<key_count> m_current, m_previous;
+        std::bitset<key_count> m_pressed, m_released;
+    };
+}
@@ -0,0 +1,153 @@
+#include "job_system.hpp"
+#include "kat/core/profiler.hpp"
+#include <spdlog/spdlog.h>
+
+namespace kat::jobs {
+    namespace {
+        thread_local const job_system* tl_owner = nullptr;
+        thread_local uint32_t tl_index = 0;
+        thread_local uint32_t tl_rng = 0x9e3779b9u;
+
+        uint32_t next_random() {
+            // xorshift32, only used to spread steal attempts across victims
+            tl_rng ^= tl_rng << 13;
+            tl_rng ^= tl_rng >> 17;
+            tl_rng ^= tl_rng << 5;
+            return tl_rng;
+        }
+    }
+
+    bool job_system::work_deque::push_back(const job &j) {
+        std::lock_guard lock(mutex);
+        if (back - front == capacity) return false;
+        jobs[back++ & (capacity - 1)] = j;
+        return true;
+    }
+
+    bool job_system::work_deque::pop_back(job &out) {
+        std::lock_guard lock(mutex);
+        if (back == front) return false;
+        out = jobs[--back & (capacity - 1)];
+        return true;
+    }
+
+    bool job_system::work_deque::pop_front(job &out) {
+        std::lock_guard lock(mutex);
+        if (back == front) return false;
+        out = jobs[front++ & (capacity - 1)];
+        return true;
+    }
+
+    job_system::job_system(uint32_t worker_count) {
+        if (worker_count == 0) {
+            uint32_t hw = std::thread::hardware_concurrency();
+            worker_count = hw > 1 ? hw - 1 : 1;
+        }
+
+        // workers, plus the injection deque for everyone else
+        for (uint32_t i = 0 ; i <= worker_count ; i++) {
+            m_deques.push_back(std::make_unique<work_deque>());
+        }
+
+        m_workers.reserve(worker_count);
+        for (uint32_t i = 0 ; i < worker_count ; i++) {
+            m_workers.emplace_back(&job_system::worker_main, this, i);
+        }
+
+        SPDLOG_DEBUG("Started job system with {} workers", worker_count);
+    }
+
+    job_system::~job_system() {
+        {
+            std::lock_guard lock(m_sleep_mutex);
+            m_running.store(false);
+        }
+        m_sleep_cv.notify_all();
+
+        for (auto& worker : m_workers) {
+            worker.join();
+        }
+    }
+
+    uint32_t job_system::worker_count() const noexcept {
+        return static_cast<uint32_t>(m_workers.size());
+    }
+
+    void job_system::push(const job &j) {
+        j.counter->m_pending.fetch_add(1, std::memory_order_relaxed);
+
+        uint32_t index = tl_owner == this ? tl_index : static_cast<uint32_t>(m_workers.size());
+        if (!m_deques[index]->push_back(j)) {
+            // deque full, the caller is producing faster than anyone can drain, so just do the work now
+            run(j);
+            return;
+        }
+
+        m_queued.fetch_add(1);
+        if (m_sleepers.load() > 0) {
+            { std::lock_guard lock(m_sleep_mutex); }
+            m_sleep_cv.notify_one();
+        }
+    }
+
+    bool job_system::find_job(uint32_t self, job &out) {
+        if (m_queued.load(std::memory_order_relaxed) == 0) return false;
+
+        uint32_t count = static_cast<uint32_t>(m_deques.size());
+        if (self < count && m_deques[self]->pop_back(out)) {
+            m_queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        uint32_t start = next_random() % count;
+        for (uint32_t i = 0 ; i < count ; i++) {
+            uint32_t victim = (start + i) % count;
+            if (victim != self && m_deques[victim]->pop_front(out)) {
+                m_queued.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void job_system::run(const job &j) {
+        j.invoke(j.ctx, j.begin, j.end);
+        j.counter->m_pending.fetch_sub(1, std::memory_order_release);
+    }
+
+    void job_system::wait(job_counter &counter) {
+        uint32_t self = tl_owner == this ? tl_index : static_cast<uint32_t>(m_workers.size());
+
+        job j{};
+        while (!counter.done()) {
+            if (find_job(self, j)) {
+                run(j);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void job_system::worker_main(uint32_t index) {
+        KAT_PROFILE_THREAD("kat-worker");
+        tl_owner = this;
+        tl_index = index;
+        tl_rng ^= (index + 1) * 0x85ebca6bu;
+
+        job j{};
+        while (m_running.load(std::memory_order_relaxed)) {
+            if (find_job(index, j)) {
+                run(j);
+                continue;
+            }
+
+            // Announce ourselves before the final check so a concurrent push either sees us and notifies, or we
+            // see its job and don't sleep.
+            std::unique_lock lock(m_sleep_mutex);
+            m_sleepers.fetch_add(1);
+            m_sleep_cv.wait(lock, [this] { return m_queued.load() > 0 || !m_running.load(); });
+            m_sleepers.fetch_sub(1);
+        }
+    }
+}
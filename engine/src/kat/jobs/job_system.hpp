@@ -0,0 +1,170 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace kat::jobs {
+    /**
+     * Counts outstanding jobs. Jobs submitted with a counter increment it and decrement it when they finish;
+     * job_system::wait() returns once it reaches zero.
+     */
+    class job_counter {
+    public:
+        [[nodiscard]] bool done() const noexcept {
+            return m_pending.load(std::memory_order_acquire) == 0;
+        }
+
+    private:
+        friend class job_system;
+        std::atomic<uint32_t> m_pending = 0;
+    };
+
+    /**
+     * A rectangle of a 2D area handed to parallel_for_tiles.
+     */
+    struct tile {
+        glm::uvec2 position;
+        glm::uvec2 size;
+    };
+
+    /**
+     * Work-stealing scheduler.
+     *
+     * Every worker owns a deque: it pushes and pops its own work at the back (so recently split work stays hot in
+     * cache) while idle workers steal from the front of a random victim. Threads that aren't workers, like the game
+     * thread, submit into a shared injection deque and help run jobs while they wait.
+     */
+    class job_system {
+    public:
+        static constexpr uint32_t default_tile_extent = 64;
+
+        /**
+         * `worker_count` of 0 means one worker per hardware thread, minus one for the thread that waits.
+         */
+        explicit job_system(uint32_t worker_count = 0);
+        ~job_system();
+
+        job_system(const job_system&) = delete;
+        job_system& operator=(const job_system&) = delete;
+
+        [[nodiscard]] uint32_t worker_count() const noexcept;
+
+        /**
+         * Runs `fn()` on some thread. `fn` is moved to the heap, prefer parallel_for for fine-grained work.
+         */
+        template<typename F>
+        void submit(job_counter& counter, F&& fn) {
+            using fn_type = std::decay_t<F>;
+            auto* boxed = new fn_type(std::forward<F>(fn));
+            push({ [](void* ctx, uint32_t, uint32_t) {
+                auto* f = static_cast<fn_type*>(ctx);
+                (*f)();
+                delete f;
+            }, boxed, 0, 1, &counter });
+        }
+
+        /**
+         * Runs jobs until `counter` reaches zero.
+         */
+        void wait(job_counter& counter);
+
+        /**
+         * Calls `fn(begin, end)` for consecutive sub-ranges of [0, count) no larger than `grain`, in parallel, and
+         * returns when all of them are done. Nothing is allocated.
+         */
+        template<typename F>
+        void parallel_for(uint32_t count, uint32_t grain, F&& fn) {
+            if (count == 0) return;
+            if (grain == 0) grain = 1;
+
+            job_counter counter;
+            using fn_type = std::remove_reference_t<F>;
+            auto* ctx = const_cast<void*>(static_cast<const void*>(std::addressof(fn)));
+            auto invoke = [](void* c, uint32_t begin, uint32_t end) {
+                (*static_cast<fn_type*>(c))(begin, end);
+            };
+
+            // never past count, so ranges ending near UINT32_MAX don't wrap
+            for (uint32_t begin = 0, end ; begin < count ; begin = end) {
+                end = begin + std::min(grain, count - begin);
+                push({ invoke, ctx, begin, end, &counter });
+            }
+
+            wait(counter);
+        }
+
+        /**
+         * Splits a `size` area (e.g. a window's size) into tiles and calls `fn(tile)` for each in parallel.
+         * Edge tiles are clipped to the area. Returns false without calling `fn` when there would be more tiles
+         * than fit in 32 bits.
+         */
+        template<typename F>
+        bool parallel_for_tiles(glm::uvec2 size, glm::uvec2 tile_size, F&& fn) {
+            if (size.x == 0 || size.y == 0) return true;
+            tile_size = glm::max(tile_size, glm::uvec2(1, 1));
+
+            uint64_t tiles_x = (uint64_t(size.x) + tile_size.x - 1) / tile_size.x;
+            uint64_t tiles_y = (uint64_t(size.y) + tile_size.y - 1) / tile_size.y;
+            uint64_t tile_count = tiles_x * tiles_y;
+            if (tile_count > UINT32_MAX) return false;
+
+            parallel_for(static_cast<uint32_t>(tile_count), 1, [&](uint32_t begin, uint32_t end) {
+                for (uint32_t i = begin ; i < end ; i++) {
+                    glm::uvec2 position = { static_cast<uint32_t>(i % tiles_x) * tile_size.x, static_cast<uint32_t>(i / tiles_x) * tile_size.y };
+                    fn(tile{ position, glm::min(tile_size, size - position) });
+                }
+            });
+            return true;
+        }
+
+        template<typename F>
+        bool parallel_for_tiles(glm::uvec2 size, F&& fn) {
+            return parallel_for_tiles(size, glm::uvec2(default_tile_extent, default_tile_extent), std::forward<F>(fn));
+        }
+
+    private:
+        struct job {
+            void (*invoke)(void* ctx, uint32_t begin, uint32_t end);
+            void* ctx;
+            uint32_t begin, end;
+            job_counter* counter;
+        };
+
+        // Lock-guarded ring buffer. The owner works at the back, thieves take from the front; contention only
+        // happens when a thief hits the one deque its owner is also using, so a plain mutex is cheap here.
+        struct work_deque {
+            static constexpr uint32_t capacity = 4096;
+
+            std::mutex mutex;
+            std::unique_ptr<job[]> jobs = std::make_unique<job[]>(capacity);
+            uint32_t front = 0, back = 0;
+
+            bool push_back(const job& j);
+            bool pop_back(job& out);
+            bool pop_front(job& out);
+        };
+
+        void push(const job& j);
+        bool find_job(uint32_t self, job& out);
+        void run(const job& j);
+        void worker_main(uint32_t index);
+
+        std::vector<std::unique_ptr<work_deque>> m_deques; // one per worker, the last one is the injection deque
+        std::vector<std::thread> m_workers;
+
+        std::mutex m_sleep_mutex;
+        std::condition_variable m_sleep_cv;
+        std::atomic<uint32_t> m_queued = 0;
+        std::atomic<uint32_t> m_sleepers = 0;
+        std::atomic<bool> m_running = true;
+    };
+}
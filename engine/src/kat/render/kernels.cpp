@@ -0,0 +1,123 @@
+#include "kernels.hpp"
+#include <spdlog/spdlog.h>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_MSC_VER) && KAT_RENDER_X86
+#include <intrin.h>
+#endif
+
+namespace kat::render {
+    namespace {
+        void fill_scalar(uint32_t* dst, std::size_t count, uint32_t color) {
+            for (std::size_t i = 0 ; i < count ; i++) {
+                dst[i] = color;
+            }
+        }
+
+        void blend_scalar(uint32_t* dst, const uint32_t* src, std::size_t count) {
+            for (std::size_t i = 0 ; i < count ; i++) {
+                dst[i] = detail::blend_pixel(dst[i], src[i]);
+            }
+        }
+
+        void blend_solid_scalar(uint32_t* dst, std::size_t count, uint32_t color) {
+            for (std::size_t i = 0 ; i < count ; i++) {
+                dst[i] = detail::blend_pixel(dst[i], color);
+            }
+        }
+
+        const kernel_table scalar_table = {
+                kernel_isa::scalar,
+                fill_scalar,
+                blend_scalar,
+                blend_solid_scalar,
+        };
+
+        bool cpu_has_avx2() noexcept {
+#if !KAT_RENDER_X86
+            return false;
+#elif defined(_MSC_VER)
+            int info[4];
+            __cpuid(info, 0);
+            if (info[0] < 7) return false;
+
+            __cpuid(info, 1);
+            bool osxsave = (info[2] & (1 << 27)) != 0;
+            bool avx = (info[2] & (1 << 28)) != 0;
+            if (!osxsave || !avx) return false;
+
+            // the OS has to save the upper halves of the ymm registers as well
+            if ((_xgetbv(0) & 0x6) != 0x6) return false;
+
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;
+#else
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#endif
+        }
+
+        bool cpu_has_sse2() noexcept {
+            return KAT_RENDER_X86;
+        }
+
+        const kernel_table* table_for(kernel_isa isa) noexcept {
+            switch (isa) {
+                case kernel_isa::avx2: return avx2_kernels();
+                case kernel_isa::sse2: return sse2_kernels();
+                case kernel_isa::scalar: return &scalar_table;
+            }
+            return &scalar_table;
+        }
+    }
+
+    const kernel_table &scalar_kernels() noexcept {
+        return scalar_table;
+    }
+
+    bool is_supported(kernel_isa isa) noexcept {
+        switch (isa) {
+            case kernel_isa::scalar: return true;
+            case kernel_isa::sse2: return sse2_kernels() != nullptr && cpu_has_sse2();
+            case kernel_isa::avx2: return avx2_kernels() != nullptr && cpu_has_avx2();
+        }
+        return false;
+    }
+
+    const kernel_table &select_kernels(kernel_isa preferred) noexcept {
+        for (auto isa : { kernel_isa::avx2, kernel_isa::sse2 }) {
+            if (static_cast<int>(isa) <= static_cast<int>(preferred) && is_supported(isa)) {
+                return *table_for(isa);
+            }
+        }
+
+        return scalar_table;
+    }
+
+    const kernel_table &select_kernels() noexcept {
+        static const kernel_table& selected = [] () -> const kernel_table& {
+            kernel_isa preferred = kernel_isa::avx2;
+            if (const char* env = std::getenv("KAT_RENDER_ISA")) {
+                if (std::strcmp(env, "scalar") == 0) preferred = kernel_isa::scalar;
+                else if (std::strcmp(env, "sse2") == 0) preferred = kernel_isa::sse2;
+                else if (std::strcmp(env, "avx2") != 0) SPDLOG_WARN("Unknown KAT_RENDER_ISA '{}', ignoring", env);
+            }
+
+            const auto& table = select_kernels(preferred);
+            SPDLOG_DEBUG("Using {} software render kernels", to_string(table.isa));
+            return table;
+        }();
+
+        return selected;
+    }
+
+    std::string_view to_string(kernel_isa isa) noexcept {
+        switch (isa) {
+            case kernel_isa::scalar: return "scalar";
+            case kernel_isa::sse2: return "sse2";
+            case kernel_isa::avx2: return "avx2";
+        }
+        return "unknown";
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// SIMD kernels are only built for x86-64, where SSE2 is part of the baseline and AVX2 is picked at runtime
+#if defined(__x86_64__) || defined(_M_X64)
+#define KAT_RENDER_X86 1
+#else
+#define KAT_RENDER_X86 0
+#endif
+
+namespace kat::render {
+    enum class kernel_isa {
+        scalar,
+        sse2,
+        avx2,
+    };
+
+    /**
+     * Span kernels every software drawing operation is built from. All implementations produce bit-identical output,
+     * so images rendered with one can be compared against golden images made with another.
+     *
+     * Blending is source-over with straight alpha: c = (s * a + d * (255 - a)) / 255 for every channel, with the
+     * source alpha channel treated as 255 so the result alpha is a + d_a * (1 - a). The division uses the usual
+     * exact-for-bytes approximation t = x + 128; (t + (t >> 8)) >> 8.
+     */
+    struct kernel_table {
+        kernel_isa isa;
+
+        void (*fill)(uint32_t* dst, std::size_t count, uint32_t color);
+        void (*blend)(uint32_t* dst, const uint32_t* src, std::size_t count);
+        void (*blend_solid)(uint32_t* dst, std::size_t count, uint32_t color);
+    };
+
+    const kernel_table& scalar_kernels() noexcept;
+    const kernel_table* sse2_kernels() noexcept;
+    const kernel_table* avx2_kernels() noexcept;
+
+    [[nodiscard]] bool is_supported(kernel_isa isa) noexcept;
+
+    /**
+     * The fastest kernels the running CPU supports. Can be pinned with the KAT_RENDER_ISA environment variable
+     * (scalar, sse2 or avx2); unsupported requests fall back to the best available set.
+     */
+    const kernel_table& select_kernels() noexcept;
+    const kernel_table& select_kernels(kernel_isa preferred) noexcept;
+
+    std::string_view to_string(kernel_isa isa) noexcept;
+
+    namespace detail {
+        constexpr uint32_t div255(uint32_t x) noexcept {
+            x += 128;
+            return (x + (x >> 8)) >> 8;
+        }
+
+        constexpr uint32_t blend_pixel(uint32_t d, uint32_t s) noexcept {
+            uint32_t a = s >> 24;
+            uint32_t ia = 255 - a;
+            s |= 0xff000000u;
+
+            uint32_t out = 0;
+            for (int shift = 0 ; shift < 32 ; shift += 8) {
+                uint32_t sc = (s >> shift) & 0xff, dc = (d >> shift) & 0xff;
+                out |= div255(sc * a + dc * ia) << shift;
+            }
+            return out;
+        }
+    }
+}
@@ -0,0 +1,95 @@
+#include "kernels.hpp"
+
+// compiled with AVX2 code generation enabled, only reached after a runtime CPU check
+
+#if KAT_RENDER_X86
+#include <immintrin.h>
+
+namespace kat::render {
+    namespace {
+        // Same arithmetic as the SSE2 kernels on eight pixels. AVX2 unpack, shuffle and pack all work within each
+        // 128-bit half, so pixels come back out in the order they went in.
+        inline __m256i blend_half(__m256i d, __m256i s_opaque, __m256i a) {
+            const __m256i c128 = _mm256_set1_epi16(128);
+            const __m256i c255 = _mm256_set1_epi16(255);
+
+            __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(s_opaque, a), _mm256_mullo_epi16(d, _mm256_sub_epi16(c255, a)));
+            t = _mm256_add_epi16(t, c128);
+            return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+        }
+
+        inline __m256i blend8(__m256i d, __m256i s) {
+            const __m256i zero = _mm256_setzero_si256();
+            const __m256i s_opaque = _mm256_or_si256(s, _mm256_set1_epi32(static_cast<int>(0xff000000u)));
+
+            __m256i s_lo = _mm256_unpacklo_epi8(s, zero), s_hi = _mm256_unpackhi_epi8(s, zero);
+            __m256i a_lo = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s_lo, 0xff), 0xff);
+            __m256i a_hi = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s_hi, 0xff), 0xff);
+
+            __m256i lo = blend_half(_mm256_unpacklo_epi8(d, zero), _mm256_unpacklo_epi8(s_opaque, zero), a_lo);
+            __m256i hi = blend_half(_mm256_unpackhi_epi8(d, zero), _mm256_unpackhi_epi8(s_opaque, zero), a_hi);
+            return _mm256_packus_epi16(lo, hi);
+        }
+
+        void fill_avx2(uint32_t* dst, std::size_t count, uint32_t color) {
+            const __m256i c = _mm256_set1_epi32(static_cast<int>(color));
+            std::size_t i = 0;
+            for (; i + 16 <= count ; i += 16) {
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), c);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i + 8), c);
+            }
+            for (; i < count ; i++) {
+                dst[i] = color;
+            }
+        }
+
+        void blend_avx2(uint32_t* dst, const uint32_t* src, std::size_t count) {
+            std::size_t i = 0;
+            for (; i + 8 <= count ; i += 8) {
+                __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+                __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), blend8(d, s));
+            }
+            for (; i < count ; i++) {
+                dst[i] = detail::blend_pixel(dst[i], src[i]);
+            }
+        }
+
+        void blend_solid_avx2(uint32_t* dst, std::size_t count, uint32_t color) {
+            uint32_t a = color >> 24;
+            if (a == 255) {
+                fill_avx2(dst, count, color);
+                return;
+            }
+            if (a == 0) return;
+
+            const __m256i s = _mm256_set1_epi32(static_cast<int>(color));
+            std::size_t i = 0;
+            for (; i + 8 <= count ; i += 8) {
+                __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), blend8(d, s));
+            }
+            for (; i < count ; i++) {
+                dst[i] = detail::blend_pixel(dst[i], color);
+            }
+        }
+
+        const kernel_table avx2_table = {
+                kernel_isa::avx2,
+                fill_avx2,
+                blend_avx2,
+                blend_solid_avx2,
+        };
+    }
+
+    const kernel_table *avx2_kernels() noexcept {
+        return &avx2_table;
+    }
+}
+#else
+namespace kat::render {
+    const kernel_table *avx2_kernels() noexcept {
+        return nullptr;
+    }
+}
+#endif
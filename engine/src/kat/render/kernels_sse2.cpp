@@ -0,0 +1,93 @@
+#include "kernels.hpp"
+
+#if KAT_RENDER_X86
+#include <emmintrin.h>
+
+namespace kat::render {
+    namespace {
+        // Blends four pixels. Each half is widened to 16 bits per channel, so a pixel is four lanes [b, g, r, a];
+        // shufflelo/hi with 0xff copies each pixel's alpha lane across its own four lanes.
+        inline __m128i blend_half(__m128i d, __m128i s_opaque, __m128i a) {
+            const __m128i c128 = _mm_set1_epi16(128);
+            const __m128i c255 = _mm_set1_epi16(255);
+
+            __m128i t = _mm_add_epi16(_mm_mullo_epi16(s_opaque, a), _mm_mullo_epi16(d, _mm_sub_epi16(c255, a)));
+            t = _mm_add_epi16(t, c128);
+            return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+        }
+
+        inline __m128i blend4(__m128i d, __m128i s) {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i s_opaque = _mm_or_si128(s, _mm_set1_epi32(static_cast<int>(0xff000000u)));
+
+            __m128i s_lo = _mm_unpacklo_epi8(s, zero), s_hi = _mm_unpackhi_epi8(s, zero);
+            __m128i a_lo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s_lo, 0xff), 0xff);
+            __m128i a_hi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s_hi, 0xff), 0xff);
+
+            __m128i lo = blend_half(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(s_opaque, zero), a_lo);
+            __m128i hi = blend_half(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(s_opaque, zero), a_hi);
+            return _mm_packus_epi16(lo, hi);
+        }
+
+        void fill_sse2(uint32_t* dst, std::size_t count, uint32_t color) {
+            const __m128i c = _mm_set1_epi32(static_cast<int>(color));
+            std::size_t i = 0;
+            for (; i + 8 <= count ; i += 8) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), c);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 4), c);
+            }
+            for (; i < count ; i++) {
+                dst[i] = color;
+            }
+        }
+
+        void blend_sse2(uint32_t* dst, const uint32_t* src, std::size_t count) {
+            std::size_t i = 0;
+            for (; i + 4 <= count ; i += 4) {
+                __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+                __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), blend4(d, s));
+            }
+            for (; i < count ; i++) {
+                dst[i] = detail::blend_pixel(dst[i], src[i]);
+            }
+        }
+
+        void blend_solid_sse2(uint32_t* dst, std::size_t count, uint32_t color) {
+            uint32_t a = color >> 24;
+            if (a == 255) {
+                fill_sse2(dst, count, color);
+                return;
+            }
+            if (a == 0) return;
+
+            const __m128i s = _mm_set1_epi32(static_cast<int>(color));
+            std::size_t i = 0;
+            for (; i + 4 <= count ; i += 4) {
+                __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), blend4(d, s));
+            }
+            for (; i < count ; i++) {
+                dst[i] = detail::blend_pixel(dst[i], color);
+            }
+        }
+
+        const kernel_table sse2_table = {
+                kernel_isa::sse2,
+                fill_sse2,
+                blend_sse2,
+                blend_solid_sse2,
+        };
+    }
+
+    const kernel_table *sse2_kernels() noexcept {
+        return &sse2_table;
+    }
+}
+#else
+namespace kat::render {
+    const kernel_table *sse2_kernels() noexcept {
+        return nullptr;
+    }
+}
+#endif
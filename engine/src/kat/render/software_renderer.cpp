@@ -0,0 +1,120 @@
+#include "software_renderer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+namespace kat::render {
+    namespace {
+        struct clipped_rect {
+            glm::uvec2 dst, src, size;
+        };
+
+        // Intersects a rect placed at `position` with the target, returning false if nothing is left.
+        bool clip(glm::uvec2 target_size, glm::ivec2 position, glm::uvec2 size, clipped_rect& out) {
+            int64_t x0 = std::max<int64_t>(position.x, 0), y0 = std::max<int64_t>(position.y, 0);
+            int64_t x1 = std::min<int64_t>(static_cast<int64_t>(position.x) + size.x, target_size.x);
+            int64_t y1 = std::min<int64_t>(static_cast<int64_t>(position.y) + size.y, target_size.y);
+            if (x0 >= x1 || y0 >= y1) return false;
+
+            out.dst = { static_cast<uint32_t>(x0), static_cast<uint32_t>(y0) };
+            out.src = { static_cast<uint32_t>(x0 - position.x), static_cast<uint32_t>(y0 - position.y) };
+            out.size = { static_cast<uint32_t>(x1 - x0), static_cast<uint32_t>(y1 - y0) };
+            return true;
+        }
+
+        // First pixel whose center is at or after `x`, clamped to [0, limit].
+        uint32_t first_center_at_or_after(float x, uint32_t limit) {
+            float v = std::ceil(x - 0.5f);
+            if (!(v > 0.f)) return 0; // also catches NaN
+            return v >= static_cast<float>(limit) ? limit : static_cast<uint32_t>(v);
+        }
+
+        // x where the edge p -> q (p.y < q.y) crosses row center `y`. Always evaluated from the upper endpoint so a
+        // shared edge produces the same value for both triangles using it.
+        float edge_x(glm::vec2 p, glm::vec2 q, float y) {
+            return p.x + (y - p.y) * (q.x - p.x) / (q.y - p.y);
+        }
+    }
+
+    software_renderer::software_renderer() : m_kernels(&select_kernels()) {
+    }
+
+    software_renderer::software_renderer(kernel_isa preferred) : m_kernels(&select_kernels(preferred)) {
+    }
+
+    kernel_isa software_renderer::isa() const {
+        return m_kernels->isa;
+    }
+
+    void software_renderer::span(uint32_t *dst, std::size_t count, uint32_t color) const {
+        if (alpha_of(color) == 255) {
+            m_kernels->fill(dst, count, color);
+        } else {
+            m_kernels->blend_solid(dst, count, color);
+        }
+    }
+
+    void software_renderer::clear(const surface &target, uint32_t color) const {
+        if (target.stride == target.size.x) {
+            m_kernels->fill(target.pixels, static_cast<std::size_t>(target.size.x) * target.size.y, color);
+            return;
+        }
+
+        for (uint32_t y = 0 ; y < target.size.y ; y++) {
+            m_kernels->fill(target.row(y), target.size.x, color);
+        }
+    }
+
+    void software_renderer::blit(const surface &target, const const_surface &source, glm::ivec2 position) const {
+        clipped_rect r{};
+        if (!clip(target.size, position, source.size, r)) return;
+
+        for (uint32_t y = 0 ; y < r.size.y ; y++) {
+            std::memcpy(target.row(r.dst.y + y) + r.dst.x, source.row(r.src.y + y) + r.src.x, r.size.x * sizeof(uint32_t));
+        }
+    }
+
+    void software_renderer::blend(const surface &target, const const_surface &source, glm::ivec2 position) const {
+        clipped_rect r{};
+        if (!clip(target.size, position, source.size, r)) return;
+
+        for (uint32_t y = 0 ; y < r.size.y ; y++) {
+            m_kernels->blend(target.row(r.dst.y + y) + r.dst.x, source.row(r.src.y + y) + r.src.x, r.size.x);
+        }
+    }
+
+    void software_renderer::fill_rect(const surface &target, glm::ivec2 position, glm::uvec2 size, uint32_t color) const {
+        clipped_rect r{};
+        if (alpha_of(color) == 0 || !clip(target.size, position, size, r)) return;
+
+        for (uint32_t y = 0 ; y < r.size.y ; y++) {
+            span(target.row(r.dst.y + y) + r.dst.x, r.size.x, color);
+        }
+    }
+
+    void software_renderer::fill_triangle(const surface &target, glm::vec2 a, glm::vec2 b, glm::vec2 c, uint32_t color) const {
+        if (alpha_of(color) == 0) return;
+
+        if (b.y < a.y) std::swap(a, b);
+        if (c.y < b.y) std::swap(b, c);
+        if (b.y < a.y) std::swap(a, b);
+        if (!(c.y > a.y)) return;
+
+        uint32_t y_begin = first_center_at_or_after(a.y, target.size.y);
+        uint32_t y_end = first_center_at_or_after(c.y, target.size.y);
+
+        for (uint32_t y = y_begin ; y < y_end ; y++) {
+            float center = static_cast<float>(y) + 0.5f;
+
+            float x_long = edge_x(a, c, center);
+            float x_short = center < b.y ? edge_x(a, b, center) : edge_x(b, c, center);
+
+            uint32_t x0 = first_center_at_or_after(std::min(x_long, x_short), target.size.x);
+            uint32_t x1 = first_center_at_or_after(std::max(x_long, x_short), target.size.x);
+            if (x0 < x1) {
+                span(target.row(y) + x0, x1 - x0, color);
+            }
+        }
+    }
+}
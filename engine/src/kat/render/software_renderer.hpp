@@ -0,0 +1,49 @@
+#pragma once
+
+#include "kat/render/surface.hpp"
+#include "kat/render/kernels.hpp"
+#include <glm/glm.hpp>
+
+namespace kat::render {
+    /**
+     * Immediate-mode CPU renderer drawing into a surface (e.g. the pixels of a framebuffer_x11).
+     *
+     * Every operation clips against the destination and reduces to rows of span kernels, so output is identical for
+     * every kernel set and only speed depends on the CPU.
+     */
+    class software_renderer {
+    public:
+        software_renderer();
+        explicit software_renderer(kernel_isa preferred);
+
+        void clear(const surface& target, uint32_t color) const;
+
+        /**
+         * Copies `source` to `position` in `target`, ignoring source alpha.
+         */
+        void blit(const surface& target, const const_surface& source, glm::ivec2 position) const;
+
+        /**
+         * Draws `source` over `target` at `position` using source alpha.
+         */
+        void blend(const surface& target, const const_surface& source, glm::ivec2 position) const;
+
+        /**
+         * Fills a rectangle, blending if the color isn't fully opaque.
+         */
+        void fill_rect(const surface& target, glm::ivec2 position, glm::uvec2 size, uint32_t color) const;
+
+        /**
+         * Fills a triangle, blending if the color isn't fully opaque. A pixel is covered when its center is inside
+         * the triangle; pixels whose centers lie exactly on a shared edge belong to exactly one of the triangles.
+         */
+        void fill_triangle(const surface& target, glm::vec2 a, glm::vec2 b, glm::vec2 c, uint32_t color) const;
+
+        [[nodiscard]] kernel_isa isa() const;
+
+    private:
+        void span(uint32_t* dst, std::size_t count, uint32_t color) const;
+
+        const kernel_table* m_kernels;
+    };
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <glm/glm.hpp>
+
+namespace kat::render {
+    /**
+     * Packs a color as 0xAARRGGBB, the layout every surface uses. On an X11 TrueColor framebuffer the alpha byte is
+     * ignored by the server, so opaque colors can be written straight to the screen.
+     */
+    constexpr uint32_t rgba(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255) noexcept {
+        return (static_cast<uint32_t>(a) << 24) | (static_cast<uint32_t>(r) << 16) | (static_cast<uint32_t>(g) << 8) | static_cast<uint32_t>(b);
+    }
+
+    constexpr uint8_t alpha_of(uint32_t color) noexcept {
+        return static_cast<uint8_t>(color >> 24);
+    }
+
+    /**
+     * Non-owning view of 32-bit pixels. `stride` is the distance between rows in pixels.
+     */
+    template<typename T>
+    struct basic_surface {
+        T* pixels = nullptr;
+        glm::uvec2 size{};
+        uint32_t stride = 0;
+
+        constexpr basic_surface() = default;
+        constexpr basic_surface(T* pixels_, glm::uvec2 size_, uint32_t stride_) : pixels(pixels_), size(size_), stride(stride_) {}
+        constexpr basic_surface(std::span<T> pixels_, glm::uvec2 size_, uint32_t stride_) : pixels(pixels_.data()), size(size_), stride(stride_) {}
+
+        template<typename U> requires std::is_same_v<const U, T> && (!std::is_same_v<U, T>)
+        constexpr basic_surface(const basic_surface<U>& other) : pixels(other.pixels), size(other.size), stride(other.stride) {}
+
+        [[nodiscard]] constexpr T* row(uint32_t y) const noexcept {
+            return pixels + static_cast<std::size_t>(y) * stride;
+        }
+    };
+
+    using surface = basic_surface<uint32_t>;
+    using const_surface = basic_surface<const uint32_t>;
+}
@@ -0,0 +1,114 @@
+#include "kat/window/backend.hpp"
+#include "kat/window/window.hpp"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace kat::window {
+    namespace {
+        template<typename Platform>
+        std::unique_ptr<platform_state> connect(const windowing_engine_config& config) {
+            return std::make_unique<Platform>(config);
+        }
+
+        constexpr backend compiled_backends[] = {
+#ifdef KATWINDOW_TARGET_WAYLAND
+                { "wayland", connect<wayland::engine_state_wayland> },
+#endif
+#ifdef KATWINDOW_TARGET_X11
+                { "x11", connect<x11::engine_state_x11> },
+#endif
+#ifdef KATWINDOW_TARGET_XCB
+                { "xcb", connect<xcb::engine_state_xcb> },
+#endif
+#ifdef KATWINDOW_TARGET_WIN32
+                { "win32", connect<win32::engine_state_win32> },
+#endif
+#ifdef KATWINDOW_TARGET_HEADLESS
+                { "headless", connect<headless::engine_state_headless>, false },
+#endif
+        };
+
+        void add_named(std::vector<const backend*>& order, std::string_view list, std::string_view source) {
+            while (!list.empty()) {
+                auto comma = list.find(',');
+                auto name = list.substr(0, comma);
+                list = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+                if (name.empty()) continue;
+
+                if (auto* found = find_backend(name)) {
+                    if (std::find(order.begin(), order.end(), found) == order.end()) {
+                        order.push_back(found);
+                    }
+                } else {
+                    SPDLOG_WARN("{} names '{}', which isn't compiled into this build", source, name);
+                }
+            }
+        }
+
+        /**
+         * The backends asked for by name followed by every other one that may be probed.
+         */
+        std::vector<const backend*> probe_order(const windowing_engine_config& config) {
+            std::vector<const backend*> order;
+
+            if (const char* requested = std::getenv("KAT_WINDOW_BACKEND")) {
+                add_named(order, requested, "KAT_WINDOW_BACKEND");
+            }
+            add_named(order, config.backend, "windowing_engine_config::backend");
+
+            for (const auto& b : compiled_backends) {
+                if (b.probed && std::find(order.begin(), order.end(), &b) == order.end()) {
+                    order.push_back(&b);
+                }
+            }
+
+            // a build of nothing but headless runs it without being asked
+            if (order.empty()) {
+                for (const auto& b : compiled_backends) {
+                    order.push_back(&b);
+                }
+            }
+
+            return order;
+        }
+    }
+
+    std::span<const backend> backends() noexcept {
+        return compiled_backends;
+    }
+
+    const backend* find_backend(std::string_view name) noexcept {
+        for (const auto& b : compiled_backends) {
+            if (b.name == name) return &b;
+        }
+        return nullptr;
+    }
+
+    std::unique_ptr<platform_state> connect_platform(const windowing_engine_config& config, const backend*& chosen) {
+        KAT_PROFILE_ZONE("connect_platform");
+        std::unique_ptr<platform_state> first_failure;
+        const backend* first_failed = nullptr;
+
+        for (const auto* b : probe_order(config)) {
+            auto platform = b->connect(config);
+            if (!platform->is_app_exit()) {
+                SPDLOG_INFO("Using the {} windowing backend", b->name);
+                chosen = b;
+                return platform;
+            }
+
+            SPDLOG_DEBUG("The {} windowing backend didn't come up", b->name);
+            if (!first_failure) {
+                first_failure = std::move(platform);
+                first_failed = b;
+            }
+        }
+
+        SPDLOG_ERROR("No windowing backend could connect");
+        chosen = first_failed;
+        return first_failure;
+    }
+}
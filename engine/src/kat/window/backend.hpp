@@ -0,0 +1,49 @@
+#pragma once
+
+#include "kat/window/platform.hpp"
+
+#include <memory>
+#include <span>
+#include <string_view>
+
+namespace kat::window {
+    /**
+     * A windowing backend compiled into this build.
+     */
+    struct backend {
+        std::string_view name;
+
+        /**
+         * Connects to the windowing system. If it isn't reachable from here (no compositor, no X server) the
+         * platform comes back with is_app_exit() already set and the reason logged.
+         */
+        std::unique_ptr<platform_state> (*connect)(const windowing_engine_config& config);
+
+        /**
+         * Tried without being asked for by name. Off for headless, which always comes up and would hide a broken
+         * display behind a window nobody can see.
+         */
+        bool probed = true;
+    };
+
+    /**
+     * Every compiled-in backend in the order they are tried: Wayland, then Xlib, then XCB on Linux. Headless comes
+     * last and is only used when named.
+     */
+    [[nodiscard]] std::span<const backend> backends() noexcept;
+
+    /**
+     * Null if no backend by that name was compiled in.
+     */
+    [[nodiscard]] const backend* find_backend(std::string_view name) noexcept;
+
+    /**
+     * Connects to the first backend that comes up. Backends named in KAT_WINDOW_BACKEND and then in
+     * windowing_engine_config::backend (both comma separated) are tried first, in that order; if none of those
+     * come up the remaining backends are still tried.
+     *
+     * `chosen` is set to the backend that connected. If none did, this returns the platform of the first backend
+     * tried anyway with is_app_exit() set, so the engine still has something to talk to while it shuts down.
+     */
+    [[nodiscard]] std::unique_ptr<platform_state> connect_platform(const windowing_engine_config& config, const backend*& chosen);
+}
@@ -0,0 +1,56 @@
+#include "events.hpp"
+#include <chrono>
+
+namespace kat::window {
+    uint64_t event_timestamp_now() noexcept {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    event make_event(event_type type, uint64_t window, uint64_t timestamp) noexcept {
+        event e{};
+        e.type = type;
+        e.window = window;
+        e.timestamp = timestamp;
+        return e;
+    }
+
+    event make_event(event_type type, uint64_t window) noexcept {
+        return make_event(type, window, event_timestamp_now());
+    }
+
+    void event_queue::push(const event &e) noexcept {
+        if (m_tail - m_head == capacity) {
+            m_head++;
+            m_dropped++;
+        }
+
+        m_events[m_tail & (capacity - 1)] = e;
+        m_tail++;
+    }
+
+    bool event_queue::poll(event &out) noexcept {
+        if (m_head == m_tail) {
+            return false;
+        }
+
+        out = m_events[m_head & (capacity - 1)];
+        m_head++;
+        return true;
+    }
+
+    void event_queue::clear() noexcept {
+        m_head = m_tail = 0;
+    }
+
+    std::size_t event_queue::size() const noexcept {
+        return m_tail - m_head;
+    }
+
+    bool event_queue::empty() const noexcept {
+        return m_head == m_tail;
+    }
+
+    std::size_t event_queue::dropped() const noexcept {
+        return m_dropped;
+    }
+}
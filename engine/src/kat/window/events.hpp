@@ -0,0 +1,152 @@
+#pragma once
+
+#include "kat/cfg.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace kat::window {
+    enum class event_type : uint8_t {
+        none = 0,
+        key_down,
+        key_up,
+        mouse_move,
+        mouse_button_down,
+        mouse_button_up,
+        mouse_scroll,
+        raw_mouse_motion,
+        raw_mouse_button_down,
+        raw_mouse_button_up,
+        resize,
+        move,
+        focus_gained,
+        focus_lost,
+        close_requested,
+        dpi_changed,
+        monitor_changed,
+    };
+
+    enum class mouse_button : uint8_t {
+        left, right, middle, x1, x2,
+    };
+
+    enum key_modifier : uint16_t {
+        key_modifier_none = 0,
+        key_modifier_shift = 1 << 0,
+        key_modifier_control = 1 << 1,
+        key_modifier_alt = 1 << 2,
+        key_modifier_super = 1 << 3,
+    };
+
+    struct key_event {
+        uint32_t scancode; // physical key as a Linux evdev code on every platform, see kat::input::key
+        uint32_t keycode;  // layout-dependent key (keysym on X11, virtual key on Win32)
+        uint16_t modifiers;
+        bool repeat;
+    };
+
+    struct mouse_move_event {
+        int32_t x, y;
+    };
+
+    struct mouse_button_event {
+        mouse_button button;
+        int32_t x, y;
+    };
+
+    struct mouse_scroll_event {
+        float x, y;
+    };
+
+    /**
+     * Device motion before pointer acceleration, in the mouse's own counts. Only reported while raw input is on.
+     */
+    struct raw_mouse_motion_event {
+        float dx, dy;
+    };
+
+    struct resize_event {
+        uint32_t width, height;
+    };
+
+    struct move_event {
+        int32_t x, y;
+    };
+
+    struct dpi_event {
+        float x, y;
+    };
+
+    enum class monitor_change : uint8_t {
+        connected,
+        disconnected,
+        configuration, // mode, position or size
+    };
+
+    struct monitor_event {
+        uint64_t monitor; // native identifier (RROutput on X11), 0 when the platform can't tell which one changed
+        monitor_change change;
+    };
+
+    /**
+     * A single platform-neutral event. Trivially copyable so it can live in the fixed ring buffer below.
+     *
+     * `window` is the native handle of the window the event belongs to (an XID or HWND widened to 64 bits), or 0
+     * for events that don't belong to a window. `timestamp` is in steady_clock nanoseconds.
+     */
+    struct event {
+        event_type type;
+        uint64_t window;
+        uint64_t timestamp;
+
+        union {
+            key_event key;
+            mouse_move_event mouse_move;
+            mouse_button_event mouse_button;
+            mouse_scroll_event mouse_scroll;
+            raw_mouse_motion_event raw_mouse_motion;
+            resize_event resize;
+            move_event move;
+            dpi_event dpi;
+            monitor_event monitor;
+        };
+    };
+
+    static_assert(std::is_trivially_copyable_v<event>, "events must be trivially copyable");
+
+    /**
+     * The clock events are stamped with: steady_clock in nanoseconds.
+     */
+    uint64_t event_timestamp_now() noexcept;
+
+    /**
+     * Creates an event of the given type stamped with `timestamp` (or the current time). The payload is zeroed.
+     */
+    event make_event(event_type type, uint64_t window, uint64_t timestamp) noexcept;
+    event make_event(event_type type, uint64_t window) noexcept;
+
+    /**
+     * Fixed-capacity ring buffer of events. Never allocates; when full the oldest event is dropped so the queue
+     * always holds the most recent input.
+     */
+    class event_queue {
+    public:
+        static constexpr std::size_t capacity = KAT_EVENT_QUEUE_CAPACITY;
+        static_assert((capacity & (capacity - 1)) == 0, "KAT_EVENT_QUEUE_CAPACITY must be a power of two");
+
+        void push(const event& e) noexcept;
+        bool poll(event& out) noexcept;
+
+        void clear() noexcept;
+
+        [[nodiscard]] std::size_t size() const noexcept;
+        [[nodiscard]] bool empty() const noexcept;
+        [[nodiscard]] std::size_t dropped() const noexcept;
+
+    private:
+        std::array<event, capacity> m_events{};
+        std::size_t m_head = 0, m_tail = 0;
+        std::size_t m_dropped = 0;
+    };
+}
@@ -0,0 +1,38 @@
+#include "kat/cfg.hpp"
+#ifdef KATWINDOW_TARGET_HEADLESS
+#include "framebuffer_headless.hpp"
+
+namespace kat::window::headless {
+    framebuffer_headless::framebuffer_headless(window_headless &window) : framebuffer_headless(window, window.size()) {
+    }
+
+    framebuffer_headless::framebuffer_headless(window_headless &window, glm::uvec2 size_) : m_window(&window), m_size(size_) {
+        m_back.resize(static_cast<std::size_t>(m_size.x) * m_size.y);
+    }
+
+    std::span<uint32_t> framebuffer_headless::pixels() {
+        return m_back;
+    }
+
+    uint32_t framebuffer_headless::stride() const {
+        return m_size.x;
+    }
+
+    glm::uvec2 framebuffer_headless::size() const {
+        return m_size;
+    }
+
+    void framebuffer_headless::resize(glm::uvec2 new_size) {
+        if (new_size == m_size) return;
+
+        m_size = new_size;
+        m_back.assign(static_cast<std::size_t>(m_size.x) * m_size.y, 0);
+    }
+
+    void framebuffer_headless::present() {
+        m_window->present(m_back, m_size);
+        // the window's previous contents come back; only the first presents or a resize make them the wrong size
+        m_back.resize(static_cast<std::size_t>(m_size.x) * m_size.y);
+    }
+}
+#endif
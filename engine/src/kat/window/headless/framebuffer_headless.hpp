@@ -0,0 +1,58 @@
+#pragma once
+
+#include "kat/cfg.hpp"
+
+#ifdef KATWINDOW_TARGET_HEADLESS
+
+#include "kat/window/headless/platform_headless.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace kat::window::headless {
+    /**
+     * CPU-side pixel surface presented to a window_headless, the counterpart of framebuffer_x11.
+     *
+     * Pixels are 0xXXRRGGBB in plain memory. Presenting swaps the back buffer with the window's contents instead
+     * of copying, so a benchmark pays for drawing and nothing else, and a test can read back exactly what was
+     * presented through window_headless::contents().
+     *
+     * Must not outlive its window.
+     */
+    class framebuffer_headless {
+    public:
+        explicit framebuffer_headless(window_headless& window);
+        framebuffer_headless(window_headless& window, glm::uvec2 size_);
+
+        framebuffer_headless(const framebuffer_headless&) = delete;
+        framebuffer_headless& operator=(const framebuffer_headless&) = delete;
+
+        /**
+         * The buffer the next present() will show. Whatever it held before is undefined, the previous present's
+         * buffer is recycled.
+         */
+        [[nodiscard]] std::span<uint32_t> pixels();
+
+        /**
+         * Distance between rows of pixels(), in pixels.
+         */
+        [[nodiscard]] uint32_t stride() const;
+        [[nodiscard]] glm::uvec2 size() const;
+
+        /**
+         * Contents are lost.
+         */
+        void resize(glm::uvec2 new_size);
+
+        void present();
+
+    private:
+        window_headless* m_window;
+        glm::uvec2 m_size;
+        std::vector<uint32_t> m_back;
+    };
+}
+
+#endif
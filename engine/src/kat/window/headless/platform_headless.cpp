@@ -0,0 +1,471 @@
+#include "kat/cfg.hpp"
+#ifdef KATWINDOW_TARGET_HEADLESS
+#include "platform_headless.hpp"
+#include "kat/window/window.hpp"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+
+namespace kat::window::headless {
+    namespace {
+        ::kat::window::video_mode default_video_mode() {
+            ::kat::window::video_mode mode{};
+            mode.resolution = { 1920, 1080 };
+            mode.refresh_rate = { 60, 1 };
+            mode.depth = { 8, 8, 8 };
+            return mode;
+        }
+
+        event make_monitor_event(uint64_t id, monitor_change change) {
+            auto e = make_event(event_type::monitor_changed, 0, 0);
+            e.monitor.monitor = id;
+            e.monitor.change = change;
+            return e;
+        }
+    }
+
+    engine_state_headless::engine_state_headless(const windowing_engine_config &config) {
+        KAT_PROFILE_ZONE("engine_state_headless::engine_state_headless");
+        if (config.headless_monitors.empty()) {
+            headless_monitor_config fallback;
+            fallback.primary = true;
+            m_monitors.push_back(std::make_shared<monitor_headless>(m_next_monitor_id++, fallback));
+        } else {
+            for (const auto& monitor_config : config.headless_monitors) {
+                m_monitors.push_back(std::make_shared<monitor_headless>(m_next_monitor_id++, monitor_config));
+            }
+        }
+
+        auto primary = std::find_if(m_monitors.begin(), m_monitors.end(), [](const auto& mon) { return mon->is_primary(); });
+        for (auto& mon : m_monitors) {
+            mon->primary(primary == m_monitors.end() ? mon == m_monitors.front() : mon == *primary);
+        }
+
+        if (config.event_thread) {
+            SPDLOG_WARN("The event thread is only implemented by the Xlib backend");
+        }
+        SPDLOG_DEBUG("Headless with {} monitors", m_monitors.size());
+    }
+
+    std::vector<std::shared_ptr<monitor>> engine_state_headless::monitors() const {
+        return { m_monitors.begin(), m_monitors.end() };
+    }
+
+    uint64_t engine_state_headless::monitors_generation() const {
+        return m_monitors_generation;
+    }
+
+    void engine_state_headless::setup(const std::shared_ptr<windowing_engine> &engine) {
+        m_engine = engine;
+    }
+
+    void engine_state_headless::process_events() {
+        m_frame++;
+        m_clock += static_cast<uint64_t>(m_clock_step.count());
+
+        // everything queued for this frame has frame 0 now, later frames count down
+        while (!m_pending.empty() && m_pending.front().frame == 0) {
+            deliver(m_pending.front().payload);
+            m_pending.pop_front();
+        }
+        for (auto& pending : m_pending) {
+            pending.frame--;
+        }
+    }
+
+    void engine_state_headless::deliver(::kat::window::event e) {
+        if (e.timestamp == 0) {
+            e.timestamp = timestamp();
+        }
+
+        if (e.type == event_type::resize || e.type == event_type::move) {
+            if (auto* w = m_windows.find(e.window)) {
+                w->handle_event(e);
+            }
+        }
+        if (e.type == event_type::close_requested) {
+            m_app_exit = true;
+        }
+
+        m_events.push(e);
+    }
+
+    void engine_state_headless::inject(const ::kat::window::event &e, uint64_t frames_ahead) {
+        auto at = std::upper_bound(m_pending.begin(), m_pending.end(), frames_ahead, [](uint64_t frame, const scripted_event& pending) {
+            return frame < pending.frame;
+        });
+        m_pending.insert(at, { frames_ahead, e });
+    }
+
+    void engine_state_headless::inject(std::span<const scripted_event> script) {
+        for (const auto& scripted : script) {
+            inject(scripted.payload, scripted.frame);
+        }
+    }
+
+    void engine_state_headless::inject_key(uint64_t window, uint32_t scancode, bool down, uint16_t modifiers, uint64_t frames_ahead) {
+        auto e = make_event(down ? event_type::key_down : event_type::key_up, window, 0);
+        e.key.scancode = scancode;
+        e.key.modifiers = modifiers;
+        inject(e, frames_ahead);
+    }
+
+    void engine_state_headless::inject_mouse_move(uint64_t window, glm::ivec2 position, uint64_t frames_ahead) {
+        auto e = make_event(event_type::mouse_move, window, 0);
+        e.mouse_move.x = position.x;
+        e.mouse_move.y = position.y;
+        inject(e, frames_ahead);
+    }
+
+    void engine_state_headless::inject_mouse_button(uint64_t window, mouse_button button, bool down, glm::ivec2 position, uint64_t frames_ahead) {
+        auto e = make_event(down ? event_type::mouse_button_down : event_type::mouse_button_up, window, 0);
+        e.mouse_button.button = button;
+        e.mouse_button.x = position.x;
+        e.mouse_button.y = position.y;
+        inject(e, frames_ahead);
+    }
+
+    void engine_state_headless::inject_close(uint64_t window, uint64_t frames_ahead) {
+        inject(make_event(event_type::close_requested, window, 0), frames_ahead);
+    }
+
+    std::size_t engine_state_headless::pending_events() const {
+        return m_pending.size();
+    }
+
+    uint64_t engine_state_headless::frame() const {
+        return m_frame;
+    }
+
+    void engine_state_headless::fixed_clock(std::chrono::nanoseconds step) {
+        m_clock_step = step;
+        m_clock = 0;
+    }
+
+    uint64_t engine_state_headless::timestamp() const {
+        return m_clock_step.count() > 0 ? m_clock : event_timestamp_now();
+    }
+
+    uint64_t engine_state_headless::next_window_id() {
+        return m_next_window_id++;
+    }
+
+    uint64_t engine_state_headless::add_monitor(const headless_monitor_config &config) {
+        auto mon = std::make_shared<monitor_headless>(m_next_monitor_id++, config);
+        if (mon->is_primary()) {
+            for (auto& other : m_monitors) other->primary(false);
+        } else if (m_monitors.empty()) {
+            mon->primary(true);
+        }
+
+        auto id = mon->id();
+        m_monitors.push_back(std::move(mon));
+        m_monitors_generation++;
+        inject(make_monitor_event(id, monitor_change::connected));
+        return id;
+    }
+
+    bool engine_state_headless::remove_monitor(uint64_t id) {
+        auto it = std::find_if(m_monitors.begin(), m_monitors.end(), [id](const auto& mon) { return mon->id() == id; });
+        if (it == m_monitors.end()) return false;
+
+        bool was_primary = (*it)->is_primary();
+        m_monitors.erase(it);
+        if (was_primary && !m_monitors.empty()) {
+            m_monitors.front()->primary(true);
+        }
+
+        m_monitors_generation++;
+        inject(make_monitor_event(id, monitor_change::disconnected));
+        return true;
+    }
+
+    bool engine_state_headless::switch_mode(uint64_t id, const ::kat::window::video_mode &mode) {
+        auto* mon = find_monitor(id);
+        if (!mon || !mon->video_mode(mode)) return false;
+
+        m_monitors_generation++;
+        inject(make_monitor_event(id, monitor_change::configuration));
+        return true;
+    }
+
+    monitor_headless* engine_state_headless::find_monitor(uint64_t id) const {
+        for (const auto& mon : m_monitors) {
+            if (mon->id() == id) return mon.get();
+        }
+        return nullptr;
+    }
+
+    monitor_headless* engine_state_headless::monitor_at(glm::ivec2 position, glm::uvec2 size) const {
+        glm::ivec2 w_max = position + glm::ivec2(size);
+
+        monitor_headless* best = nullptr;
+        int64_t best_area = 0;
+        for (const auto& mon : m_monitors) {
+            glm::ivec2 m_min = mon->position();
+            glm::ivec2 m_max = m_min + glm::ivec2(mon->size());
+
+            int64_t width = std::min(w_max.x, m_max.x) - std::max(position.x, m_min.x);
+            int64_t height = std::min(w_max.y, m_max.y) - std::max(position.y, m_min.y);
+            if (width > 0 && height > 0 && width * height > best_area) {
+                best_area = width * height;
+                best = mon.get();
+            }
+        }
+
+        if (!best) {
+            for (const auto& mon : m_monitors) {
+                if (mon->is_primary() || !best) best = mon.get();
+            }
+        }
+
+        return best;
+    }
+
+    monitor_headless::monitor_headless(uint64_t id, const headless_monitor_config &config)
+            : m_id(id), m_name(config.name), m_position(config.position), m_physical_size(config.physical_size), m_dpi(config.dpi),
+              m_is_primary(config.primary), m_video_modes(config.video_modes) {
+        if (m_video_modes.empty()) {
+            m_video_modes.push_back(default_video_mode());
+        }
+        sort_video_modes(m_video_modes);
+
+        if (auto* current = find_closest_video_mode(m_video_modes, config.current_mode)) {
+            m_video_mode = *current;
+        }
+    }
+
+    glm::vec2 monitor_headless::dpi() const {
+        return m_dpi;
+    }
+
+    glm::vec2 monitor_headless::scale() const {
+        return kat::window::conv_dpi_to_scale(dpi());
+    }
+
+    glm::uvec2 monitor_headless::physical_size() const {
+        return m_physical_size;
+    }
+
+    glm::uvec2 monitor_headless::size() const {
+        return m_video_mode.resolution;
+    }
+
+    glm::ivec2 monitor_headless::position() const {
+        return m_position;
+    }
+
+    std::string_view monitor_headless::name() const {
+        return m_name;
+    }
+
+    bool monitor_headless::is_primary() const {
+        return m_is_primary;
+    }
+
+    void monitor_headless::primary(bool is_primary) {
+        m_is_primary = is_primary;
+    }
+
+    ::kat::window::video_mode monitor_headless::video_mode() const {
+        return m_video_mode;
+    }
+
+    bool monitor_headless::video_mode(const ::kat::window::video_mode &mode) {
+        if (std::find(m_video_modes.begin(), m_video_modes.end(), mode) == m_video_modes.end()) return false;
+
+        m_video_mode = mode;
+        return true;
+    }
+
+    std::span<const ::kat::window::video_mode> monitor_headless::video_modes() const {
+        return m_video_modes;
+    }
+
+    const ::kat::window::video_mode* monitor_headless::closest_video_mode(const video_mode_request &request) const {
+        return find_closest_video_mode(m_video_modes, request);
+    }
+
+    uint64_t monitor_headless::id() const {
+        return m_id;
+    }
+}
+
+namespace kat::window {
+    headless::window_headless::window_headless(windowing_engine& engine, std::string_view title_, glm::uvec2 size_, glm::ivec2 position_)
+            : m_platform(engine.platform_as<engine_state_headless>()), m_title(title_), m_size(size_), m_position(position_),
+              m_windowed_size(size_), m_windowed_position(position_) {
+        m_id = m_platform->next_window_id();
+        // the first thing a real window manager tells a new window is that it has focus
+        m_platform->inject(make_event(event_type::focus_gained, m_id, 0));
+    }
+
+    std::string headless::window_headless::title() const {
+        return m_title;
+    }
+
+    void headless::window_headless::title(std::string_view new_title) {
+        m_title = new_title;
+    }
+
+    glm::vec2 headless::window_headless::dpi() const {
+        if (auto* mon = m_platform->monitor_at(m_position, m_size)) {
+            return mon->dpi();
+        }
+        return { KAT_BASE_DPI, KAT_BASE_DPI };
+    }
+
+    glm::vec2 headless::window_headless::scale() const {
+        return kat::window::conv_dpi_to_scale(dpi());
+    }
+
+    glm::uvec2 headless::window_headless::size() const {
+        return m_size;
+    }
+
+    glm::ivec2 headless::window_headless::position() const {
+        return m_position;
+    }
+
+    void headless::window_headless::size(glm::uvec2 new_size) {
+        apply_geometry(new_size, m_position);
+    }
+
+    void headless::window_headless::position(glm::ivec2 new_position) {
+        apply_geometry(m_size, new_position);
+    }
+
+    void headless::window_headless::apply_geometry(glm::uvec2 new_size, glm::ivec2 new_position) {
+        if (new_size != m_size) {
+            m_size = new_size;
+            auto e = make_event(event_type::resize, m_id, 0);
+            e.resize.width = m_size.x;
+            e.resize.height = m_size.y;
+            m_platform->inject(e);
+        }
+
+        if (new_position != m_position) {
+            m_position = new_position;
+            auto e = make_event(event_type::move, m_id, 0);
+            e.move.x = m_position.x;
+            e.move.y = m_position.y;
+            m_platform->inject(e);
+        }
+    }
+
+    void headless::window_headless::handle_event(const event &e) {
+        if (e.type == event_type::resize) {
+            m_size = { e.resize.width, e.resize.height };
+        } else if (e.type == event_type::move) {
+            m_position = { e.move.x, e.move.y };
+        }
+    }
+
+    bool headless::window_headless::decorated() const {
+        return m_decorated;
+    }
+
+    void headless::window_headless::decorated(bool new_mode) {
+        m_decorated = new_mode;
+    }
+
+    fullscreen_mode headless::window_headless::fullscreen() const {
+        return m_fullscreen;
+    }
+
+    void headless::window_headless::fullscreen(fullscreen_mode new_mode) {
+        if (new_mode == m_fullscreen) return;
+
+        if (new_mode == fullscreen_mode::windowed) {
+            m_fullscreen = new_mode;
+            auto* mon = m_maximized ? m_platform->monitor_at(m_position, m_size) : nullptr;
+            if (mon) {
+                apply_geometry(mon->size(), mon->position());
+            } else {
+                apply_geometry(m_windowed_size, m_windowed_position);
+            }
+            return;
+        }
+
+        if (m_fullscreen == fullscreen_mode::windowed && !m_maximized) {
+            m_windowed_size = m_size;
+            m_windowed_position = m_position;
+        }
+        m_fullscreen = new_mode;
+        if (auto* mon = m_platform->monitor_at(m_position, m_size)) {
+            apply_geometry(mon->size(), mon->position());
+        }
+    }
+
+    void headless::window_headless::restore() {
+        m_minimized = false;
+        // leaves fullscreen too, like the other backends
+        if (m_maximized || m_fullscreen != fullscreen_mode::windowed) {
+            m_fullscreen = fullscreen_mode::windowed;
+            m_maximized = false;
+            apply_geometry(m_windowed_size, m_windowed_position);
+        }
+    }
+
+    void headless::window_headless::maximize() {
+        m_minimized = false;
+        if (m_maximized || m_fullscreen != fullscreen_mode::windowed) return;
+
+        m_maximized = true;
+        m_windowed_size = m_size;
+        m_windowed_position = m_position;
+        if (auto* mon = m_platform->monitor_at(m_position, m_size)) {
+            apply_geometry(mon->size(), mon->position());
+        }
+    }
+
+    void headless::window_headless::minimize() {
+        m_minimized = true;
+    }
+
+    void headless::window_headless::show() {
+        m_visible = true;
+    }
+
+    void headless::window_headless::hide() {
+        m_visible = false;
+    }
+
+    bool headless::window_headless::visible() const {
+        return m_visible;
+    }
+
+    bool headless::window_headless::minimized() const {
+        return m_minimized;
+    }
+
+    bool headless::window_headless::maximized() const {
+        return m_maximized;
+    }
+
+    uint64_t headless::window_headless::platform_handle() const {
+        return m_id;
+    }
+
+    uint64_t headless::window_headless::native_handle() const {
+        return m_id;
+    }
+
+    std::span<const uint32_t> headless::window_headless::contents() const {
+        return m_contents;
+    }
+
+    glm::uvec2 headless::window_headless::contents_size() const {
+        return m_contents_size;
+    }
+
+    uint64_t headless::window_headless::presented_frames() const {
+        return m_presented;
+    }
+
+    void headless::window_headless::present(std::vector<uint32_t> &pixels, glm::uvec2 size_) {
+        std::swap(m_contents, pixels);
+        m_contents_size = size_;
+        m_presented++;
+    }
+}
+#endif
@@ -0,0 +1,280 @@
+#pragma once
+
+#include "kat/cfg.hpp"
+
+#ifdef KATWINDOW_TARGET_HEADLESS
+
+#include "kat/window/utils.hpp"
+#include "kat/window/events.hpp"
+#include "kat/window/platform.hpp"
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace kat::window {
+    struct windowing_engine;
+
+    namespace headless {
+        class monitor_headless;
+        class window_headless;
+
+        /**
+         * An event to deliver during a later process_events(). `frame` counts calls from now: 0 is the next one.
+         */
+        struct scripted_event {
+            uint64_t frame = 0;
+            ::kat::window::event payload{};
+        };
+
+        /**
+         * A windowing system that isn't there. Monitors come from windowing_engine_config::headless_monitors,
+         * windows only exist in memory, and the only input is what gets injected. Nothing here makes a system
+         * call, so benchmarks measure the engine rather than a display server, and a replay produces the same
+         * events on every run.
+         *
+         * Never probed, run it with KAT_WINDOW_BACKEND=headless or windowing_engine_config::backend. Backend
+         * specific calls go through windowing_engine::platform_as<engine_state_headless>().
+         */
+        struct engine_state_headless final : public platform_state_base<window_headless> {
+            explicit engine_state_headless(const windowing_engine_config& config);
+
+            [[nodiscard]] std::vector<std::shared_ptr<monitor>> monitors() const override;
+            [[nodiscard]] uint64_t monitors_generation() const override;
+
+            void setup(const std::shared_ptr<windowing_engine>& engine) override;
+
+            /**
+             * Advances the frame counter (and the fixed clock, if set) and delivers what was injected for this frame.
+             */
+            void process_events() override;
+
+            /**
+             * Hotplugs a monitor. Returns its id, reported by a monitor_changed event on the next process_events().
+             */
+            uint64_t add_monitor(const headless_monitor_config& config);
+            bool remove_monitor(uint64_t id);
+
+            /**
+             * Switches a monitor to one of its own modes. False if it has no such mode.
+             */
+            bool switch_mode(uint64_t id, const ::kat::window::video_mode& mode);
+
+            [[nodiscard]] monitor_headless* find_monitor(uint64_t id) const;
+
+            /**
+             * The monitor covering most of the rectangle, the primary one if none covers it. Null without monitors.
+             */
+            [[nodiscard]] monitor_headless* monitor_at(glm::ivec2 position, glm::uvec2 size) const;
+
+            /**
+             * Queues an event for the process_events() call `frames_ahead` calls from now, after anything already
+             * queued for it. A zero timestamp is filled in on delivery. Resize and move events also update the
+             * window they name, the way a window manager's would.
+             */
+            void inject(const ::kat::window::event& e, uint64_t frames_ahead = 0);
+            void inject(std::span<const scripted_event> script);
+
+            void inject_key(uint64_t window, uint32_t scancode, bool down, uint16_t modifiers = key_modifier_none, uint64_t frames_ahead = 0);
+            void inject_mouse_move(uint64_t window, glm::ivec2 position, uint64_t frames_ahead = 0);
+            void inject_mouse_button(uint64_t window, mouse_button button, bool down, glm::ivec2 position, uint64_t frames_ahead = 0);
+
+            /**
+             * Like the window manager's close button: sets is_app_exit() once delivered.
+             */
+            void inject_close(uint64_t window, uint64_t frames_ahead = 0);
+
+            /**
+             * Events waiting for a later frame.
+             */
+            [[nodiscard]] std::size_t pending_events() const;
+
+            /**
+             * How many times process_events() has run.
+             */
+            [[nodiscard]] uint64_t frame() const;
+
+            /**
+             * Stamps events with a clock that advances by `step` every process_events() instead of steady_clock, so
+             * timestamps are the same on every run. Zero goes back to steady_clock.
+             */
+            void fixed_clock(std::chrono::nanoseconds step);
+
+            /**
+             * The time events raised now get stamped with.
+             */
+            [[nodiscard]] uint64_t timestamp() const;
+
+            /**
+             * Native handles for new windows, counting up from 1 (0 is never a window).
+             */
+            uint64_t next_window_id();
+
+        private:
+            void deliver(::kat::window::event e);
+
+            std::vector<std::shared_ptr<monitor_headless>> m_monitors;
+            uint64_t m_monitors_generation = 0;
+            uint64_t m_next_monitor_id = 1;
+            uint64_t m_next_window_id = 1;
+            std::weak_ptr<windowing_engine> m_engine;
+
+            // sorted by frame, insertion order within one
+            std::deque<scripted_event> m_pending;
+            uint64_t m_frame = 0;
+
+            std::chrono::nanoseconds m_clock_step{0};
+            uint64_t m_clock = 0;
+        };
+
+        class monitor_headless final : public ::kat::window::monitor {
+        public:
+            monitor_headless(uint64_t id, const headless_monitor_config& config);
+
+            [[nodiscard]] glm::vec2 dpi() const override;
+            [[nodiscard]] glm::vec2 scale() const override;
+
+            [[nodiscard]] glm::uvec2 physical_size() const override;
+
+            /**
+             * The resolution of the current mode.
+             */
+            [[nodiscard]] glm::uvec2 size() const override;
+            [[nodiscard]] glm::ivec2 position() const override;
+
+            [[nodiscard]] std::string_view name() const override;
+
+            [[nodiscard]] bool is_primary() const override;
+            void primary(bool is_primary);
+
+            [[nodiscard]] ::kat::window::video_mode video_mode() const override;
+            bool video_mode(const ::kat::window::video_mode& mode);
+
+            /**
+             * Sorted and deduplicated, see sort_video_modes().
+             */
+            [[nodiscard]] std::span<const ::kat::window::video_mode> video_modes() const override;
+            [[nodiscard]] const ::kat::window::video_mode* closest_video_mode(const video_mode_request& request) const override;
+
+            [[nodiscard]] uint64_t id() const override;
+
+        private:
+            uint64_t m_id;
+            std::string m_name;
+            glm::ivec2 m_position;
+            glm::uvec2 m_physical_size;
+            glm::vec2 m_dpi;
+            bool m_is_primary;
+            std::vector<::kat::window::video_mode> m_video_modes;
+            ::kat::window::video_mode m_video_mode{};
+        };
+
+        class window_headless final : public ::kat::window::window {
+        public:
+            /**
+             * Use windowing_engine::create_window(), the engine owns its windows and destroys them before itself.
+             */
+            window_headless(windowing_engine& engine, std::string_view title_, glm::uvec2 size_, glm::ivec2 position_);
+
+            window_headless(const window_headless&) = delete;
+            window_headless& operator=(const window_headless&) = delete;
+
+            [[nodiscard]] std::string title() const override;
+            void title(std::string_view new_title) override;
+
+            /**
+             * Those of the monitor the window is on, KAT_BASE_DPI when there are no monitors.
+             */
+            [[nodiscard]] glm::vec2 dpi() const override;
+            [[nodiscard]] glm::vec2 scale() const override;
+
+            /**
+             * Setters apply at once and queue the resize or move event a window manager would send for the next
+             * process_events().
+             */
+            [[nodiscard]] glm::uvec2 size() const override;
+            [[nodiscard]] glm::ivec2 position() const override;
+
+            void size(glm::uvec2 new_size) override;
+            void position(glm::ivec2 new_position) override;
+
+            /**
+             * Applies an injected resize or move without queueing another event.
+             */
+            void handle_event(const ::kat::window::event& e);
+
+            [[nodiscard]] bool decorated() const override;
+            void decorated(bool new_mode) override;
+
+            [[nodiscard]] fullscreen_mode fullscreen() const override;
+
+            /**
+             * Covers the monitor the window is on. There is no compositor to bypass, so borderless and exclusive
+             * only differ in what fullscreen() reports.
+             */
+            void fullscreen(fullscreen_mode new_mode) override;
+            // no mode switching here, the monitor overload stays the default that refuses
+            using ::kat::window::window::fullscreen;
+
+            /**
+             * Leaves fullscreen and maximize, back to the geometry from before either.
+             */
+            void restore() override;
+            void maximize() override;
+            void minimize() override;
+
+            void show() override;
+            void hide() override;
+
+            [[nodiscard]] bool visible() const;
+            [[nodiscard]] bool minimized() const;
+            [[nodiscard]] bool maximized() const;
+
+            [[nodiscard]] uint64_t platform_handle() const;
+            [[nodiscard]] uint64_t native_handle() const override;
+
+            /**
+             * What the last framebuffer_headless::present() put on the window, size() pixels with a stride of
+             * size().x as of that present. Empty until the first one.
+             */
+            [[nodiscard]] std::span<const uint32_t> contents() const;
+            [[nodiscard]] glm::uvec2 contents_size() const;
+            [[nodiscard]] uint64_t presented_frames() const;
+
+            /**
+             * Takes `pixels` as the window's contents and hands back the previous ones for reuse, nothing is copied.
+             */
+            void present(std::vector<uint32_t>& pixels, glm::uvec2 size);
+
+        private:
+            void apply_geometry(glm::uvec2 new_size, glm::ivec2 new_position);
+
+            engine_state_headless* m_platform;
+            uint64_t m_id;
+            std::string m_title;
+            bool m_decorated = true;
+            bool m_visible = true;
+            bool m_minimized = false;
+            bool m_maximized = false;
+
+            glm::uvec2 m_size;
+            glm::ivec2 m_position;
+
+            fullscreen_mode m_fullscreen = fullscreen_mode::windowed;
+            // where restore() goes back to after maximize() or fullscreen()
+            glm::uvec2 m_windowed_size;
+            glm::ivec2 m_windowed_position;
+
+            std::vector<uint32_t> m_contents;
+            glm::uvec2 m_contents_size{0, 0};
+            uint64_t m_presented = 0;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,176 @@
+#pragma once
+
+#include "kat/window/utils.hpp"
+#include "kat/window/events.hpp"
+#include "kat/window/window_registry.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace kat::window {
+    struct windowing_engine;
+
+    /**
+     * A monitor as reported by whichever backend is running. Every backend's monitor class derives from this and is
+     * final, so code that knows the concrete type calls it directly.
+     *
+     * video_modes() is sorted and deduplicated with sort_video_modes().
+     */
+    class monitor {
+    public:
+        virtual ~monitor() = default;
+
+        [[nodiscard]] virtual glm::vec2 dpi() const = 0;
+        [[nodiscard]] virtual glm::vec2 scale() const = 0;
+
+        [[nodiscard]] virtual glm::uvec2 physical_size() const = 0;
+        [[nodiscard]] virtual glm::uvec2 size() const = 0;
+        [[nodiscard]] virtual glm::ivec2 position() const = 0;
+
+        [[nodiscard]] virtual std::string_view name() const = 0;
+
+        [[nodiscard]] virtual bool is_primary() const = 0;
+
+        [[nodiscard]] virtual ::kat::window::video_mode video_mode() const = 0;
+        [[nodiscard]] virtual std::span<const ::kat::window::video_mode> video_modes() const = 0;
+        [[nodiscard]] virtual const ::kat::window::video_mode* closest_video_mode(const video_mode_request& request) const = 0;
+
+        [[nodiscard]] virtual uint64_t id() const = 0;
+    };
+
+    /**
+     * A window of whichever backend is running, see monitor.
+     */
+    class window {
+    public:
+        virtual ~window() = default;
+
+        [[nodiscard]] virtual std::string title() const = 0;
+        virtual void title(std::string_view new_title) = 0;
+
+        [[nodiscard]] virtual glm::vec2 dpi() const = 0;
+        [[nodiscard]] virtual glm::vec2 scale() const = 0;
+
+        [[nodiscard]] virtual glm::uvec2 size() const = 0;
+        [[nodiscard]] virtual glm::ivec2 position() const = 0;
+
+        virtual void size(glm::uvec2 new_size) = 0;
+        virtual void position(glm::ivec2 new_position) = 0;
+
+        [[nodiscard]] virtual bool decorated() const = 0;
+        virtual void decorated(bool new_mode) = 0;
+
+        /**
+         * Backends without fullscreen support stay windowed and ignore the setter.
+         */
+        [[nodiscard]] virtual fullscreen_mode fullscreen() const { return fullscreen_mode::windowed; }
+        virtual void fullscreen(fullscreen_mode) {}
+
+        /**
+         * Exclusive fullscreen on one of this engine's monitors after switching it to `mode`, usually one from its
+         * closest_video_mode(). Returns false and leaves the window as it was if the mode couldn't be set, which is
+         * always the case on backends that can't switch modes (only Xlib can so far).
+         */
+        virtual bool fullscreen(const monitor&, const ::kat::window::video_mode&) { return false; }
+
+        virtual void restore() = 0;
+        virtual void maximize() = 0;
+        virtual void minimize() = 0;
+
+        virtual void show() = 0;
+        virtual void hide() = 0;
+
+        /**
+         * The native handle as an integer, the same value the backend puts in event::window.
+         */
+        [[nodiscard]] virtual uint64_t native_handle() const = 0;
+    };
+
+    /**
+     * The connection to a windowing system, picked at runtime from the compiled-in backends (see backend.hpp).
+     *
+     * The event queue and exit flag live here rather than behind virtual calls, so polling events stays a plain
+     * ring buffer read whichever backend filled it.
+     */
+    class platform_state {
+    public:
+        virtual ~platform_state() = default;
+
+        virtual void setup(const std::shared_ptr<windowing_engine>& engine) = 0;
+        virtual void process_events() = 0;
+
+        [[nodiscard]] virtual std::vector<std::shared_ptr<monitor>> monitors() const = 0;
+
+        /**
+         * Bumped whenever a monitor is added, removed or changes, so snapshots know when to rebuild.
+         */
+        [[nodiscard]] virtual uint64_t monitors_generation() const = 0;
+
+        virtual window_handle create_window(windowing_engine& engine, std::string_view title, glm::uvec2 size, glm::ivec2 position) = 0;
+        virtual void destroy_window(window_handle handle) = 0;
+
+        /**
+         * Destroys every window. The engine calls this before destroying the platform, windows talk to the platform
+         * on their way out.
+         */
+        virtual void destroy_windows() = 0;
+
+        [[nodiscard]] virtual window* get_window(window_handle handle) const = 0;
+        [[nodiscard]] virtual window* find_window(uint64_t native) const = 0;
+        [[nodiscard]] virtual window_handle find_window_handle(uint64_t native) const = 0;
+
+        [[nodiscard]] bool is_app_exit() const { return m_app_exit; }
+        [[nodiscard]] event_queue& events() { return m_events; }
+
+        bool m_app_exit = false;
+        event_queue m_events;
+    };
+
+    /**
+     * The window bookkeeping every backend does the same way, over a registry of its own window type so its event
+     * dispatch finds concrete windows without casting.
+     */
+    template<typename Window>
+    class platform_state_base : public platform_state {
+    public:
+        window_handle create_window(windowing_engine& engine, std::string_view title, glm::uvec2 size, glm::ivec2 position) final {
+            auto w = std::make_unique<Window>(engine, title, size, position);
+            auto native = w->native_handle();
+            return m_windows.insert(native, std::move(w));
+        }
+
+        void destroy_window(window_handle handle) final {
+            m_windows.erase(handle);
+        }
+
+        void destroy_windows() final {
+            m_windows.clear();
+        }
+
+        [[nodiscard]] window* get_window(window_handle handle) const final {
+            return m_windows.get(handle);
+        }
+
+        [[nodiscard]] window* find_window(uint64_t native) const final {
+            return m_windows.find(native);
+        }
+
+        [[nodiscard]] window_handle find_window_handle(uint64_t native) const final {
+            return m_windows.handle_of(native);
+        }
+
+        /**
+         * Every window of this engine, keyed by native handle for event dispatch.
+         */
+        [[nodiscard]] window_registry<Window>& windows() { return m_windows; }
+
+    protected:
+        // destroyed after the backend's own members, which is why the engine empties it before deleting the platform
+        window_registry<Window> m_windows;
+    };
+}
@@ -1,4 +1,7 @@
 #include "utils.hpp"
+#include <algorithm>
+#include <cmath>
+#include <tuple>
 
 glm::vec2 kat::window::conv_dpi_to_scale(const glm::vec2& dpi) noexcept {
     return dpi / static_cast<float>(KAT_BASE_DPI);
@@ -7,6 +10,7 @@ glm::vec2 kat::window::conv_dpi_to_scale(const glm::vec2& dpi) noexcept {
 bool kat::window::video_mode::operator==(const kat::window::video_mode &rhs) const {
     return resolution == rhs.resolution &&
            refresh_rate == rhs.refresh_rate &&
+           timing.interlaced == rhs.timing.interlaced &&
            depth == rhs.depth;
 }
 
@@ -23,3 +27,113 @@ bool kat::window::display_depth::operator==(const kat::window::display_depth &rh
 bool kat::window::display_depth::operator!=(const kat::window::display_depth &rhs) const {
     return !(rhs == *this);
 }
+
+
+namespace kat::window {
+    namespace {
+        uint32_t bits_per_pixel(const video_mode& mode) noexcept {
+            return mode.depth.red + mode.depth.green + mode.depth.blue;
+        }
+
+        bool resolution_less(const video_mode& lhs, const video_mode& rhs) noexcept {
+            return std::tie(lhs.resolution.x, lhs.resolution.y) < std::tie(rhs.resolution.x, rhs.resolution.y);
+        }
+
+        // Rates this close are one mode listed with slightly different timings: 59.94 and 59.95Hz are 0.017% apart
+        // and merge, 59.94 and 60Hz are 0.1% apart and stay separate.
+        constexpr double same_rate_tolerance = 0.0005;
+
+        bool same_mode(const video_mode& lhs, const video_mode& rhs) noexcept {
+            if (lhs.resolution != rhs.resolution || lhs.depth != rhs.depth || lhs.timing.interlaced != rhs.timing.interlaced) {
+                return false;
+            }
+            if (lhs.refresh_rate == rhs.refresh_rate) return true;
+
+            double lhs_hz = lhs.refresh_rate.hz(), rhs_hz = rhs.refresh_rate.hz();
+            return std::abs(lhs_hz - rhs_hz) < std::max(lhs_hz, rhs_hz) * same_rate_tolerance;
+        }
+
+        // Best mode among modes that share a resolution. Lower costs win; a don't-care field turns into
+        // "higher is better" by negating the value.
+        const video_mode* closest_in_range(const video_mode* first, const video_mode* last, const video_mode_request& request) noexcept {
+            const video_mode* best = nullptr;
+            std::tuple<double, int64_t, bool> best_cost;
+            for (auto* mode = first ; mode != last ; mode++) {
+                double hz = mode->refresh_rate.hz();
+                double refresh_cost = request.refresh_rate.numerator ? std::abs(hz - request.refresh_rate.hz()) : -hz;
+
+                int64_t bpp = bits_per_pixel(*mode);
+                int64_t depth_cost = request.bits_per_pixel ? std::abs(bpp - static_cast<int64_t>(request.bits_per_pixel)) : -bpp;
+
+                std::tuple<double, int64_t, bool> cost = { refresh_cost, depth_cost, mode->timing.interlaced };
+                if (!best || cost < best_cost) {
+                    best = mode;
+                    best_cost = cost;
+                }
+            }
+            return best;
+        }
+    }
+
+    bool video_mode_less(const video_mode& lhs, const video_mode& rhs) noexcept {
+        if (lhs.resolution != rhs.resolution) return resolution_less(lhs, rhs);
+
+        // cross-multiplied so 60000/1001 and 60/1 order exactly
+        auto lhs_rate = lhs.refresh_rate.numerator * rhs.refresh_rate.denominator;
+        auto rhs_rate = rhs.refresh_rate.numerator * lhs.refresh_rate.denominator;
+        if (lhs_rate != rhs_rate) return lhs_rate < rhs_rate;
+
+        if (bits_per_pixel(lhs) != bits_per_pixel(rhs)) return bits_per_pixel(lhs) < bits_per_pixel(rhs);
+        if (lhs.depth != rhs.depth) return std::tie(lhs.depth.red, lhs.depth.green, lhs.depth.blue) < std::tie(rhs.depth.red, rhs.depth.green, rhs.depth.blue);
+
+        return !lhs.timing.interlaced && rhs.timing.interlaced;
+    }
+
+    void sort_video_modes(std::vector<video_mode>& modes) {
+        // stable, so of exact duplicates the one the platform listed first (usually its preferred timing) stays
+        std::stable_sort(modes.begin(), modes.end(), video_mode_less);
+        modes.erase(std::unique(modes.begin(), modes.end(), same_mode), modes.end());
+    }
+
+    void keep_video_mode(std::vector<video_mode>& modes, const video_mode& mode) {
+        if (std::find(modes.begin(), modes.end(), mode) != modes.end()) return;
+
+        auto merged = std::find_if(modes.begin(), modes.end(), [&](const video_mode& m) { return same_mode(m, mode); });
+        if (merged != modes.end()) {
+            *merged = mode;
+        } else {
+            modes.push_back(mode);
+        }
+        std::stable_sort(modes.begin(), modes.end(), video_mode_less);
+    }
+
+    const video_mode* find_closest_video_mode(std::span<const video_mode> modes, const video_mode_request& request) noexcept {
+        if (modes.empty()) return nullptr;
+
+        video_mode target{};
+        if (request.resolution.x != 0 && request.resolution.y != 0) {
+            target.resolution = request.resolution;
+            auto [first, last] = std::equal_range(modes.data(), modes.data() + modes.size(), target, resolution_less);
+            if (first != last) {
+                return closest_in_range(first, last, request);
+            }
+        }
+
+        // no exact resolution: settle on the one nearest in area (or the largest when it doesn't matter), ties go up
+        auto requested_area = static_cast<int64_t>(request.resolution.x) * request.resolution.y;
+        const video_mode* nearest = nullptr;
+        int64_t nearest_cost = 0;
+        for (const auto& mode : modes) {
+            auto area = static_cast<int64_t>(mode.resolution.x) * mode.resolution.y;
+            int64_t cost = requested_area ? std::abs(area - requested_area) * 2 - (area > requested_area) : -area;
+            if (!nearest || cost < nearest_cost) {
+                nearest = &mode;
+                nearest_cost = cost;
+            }
+        }
+
+        target.resolution = nearest->resolution;
+        auto [first, last] = std::equal_range(modes.data(), modes.data() + modes.size(), target, resolution_less);
+        return closest_in_range(first, last, request);
+    }
+}
@@ -2,6 +2,15 @@
 
 #include "kat/cfg.hpp"
 #include <glm/glm.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
 
 namespace kat::window {
     glm::vec2 conv_dpi_to_scale(const glm::vec2& dpi) noexcept;
@@ -14,13 +23,216 @@ namespace kat::window {
         bool operator!=(const display_depth &rhs) const;
     };
 
+    /**
+     * A refresh rate in Hz as an exact fraction, so 59.94Hz (60000/1001) doesn't get rounded to 60.
+     */
+    struct rational_refresh_rate {
+        uint64_t numerator = 0;
+        uint64_t denominator = 1;
+
+        [[nodiscard]] constexpr double hz() const noexcept {
+            return denominator == 0 ? 0.0 : static_cast<double>(numerator) / static_cast<double>(denominator);
+        }
+
+        /**
+         * Nearest whole Hz, what most UIs show.
+         */
+        [[nodiscard]] constexpr uint32_t rounded() const noexcept {
+            return denominator == 0 ? 0 : static_cast<uint32_t>((numerator + denominator / 2) / denominator);
+        }
+
+        /**
+         * Exact frame period rounded to the nearest nanosecond, or zero for an unknown rate.
+         */
+        [[nodiscard]] constexpr std::chrono::nanoseconds period() const noexcept {
+            if (numerator == 0) return std::chrono::nanoseconds(0);
+            return std::chrono::nanoseconds(static_cast<int64_t>((denominator * 1'000'000'000ull + numerator / 2) / numerator));
+        }
+
+        [[nodiscard]] constexpr bool operator==(const rational_refresh_rate& rhs) const noexcept {
+            return numerator * rhs.denominator == rhs.numerator * denominator;
+        }
+
+        [[nodiscard]] constexpr bool operator!=(const rational_refresh_rate& rhs) const noexcept {
+            return !(*this == rhs);
+        }
+    };
+
+    /**
+     * Raw scanout timing of a mode, where the platform reports it. A zero dot clock means unknown.
+     */
+    struct mode_timing {
+        uint64_t dot_clock = 0; // pixels per second
+        uint32_t htotal = 0, vtotal = 0;
+        bool interlaced = false;
+        bool double_scan = false;
+
+        /**
+         * The refresh rate these timings produce, reduced to lowest terms. Interlaced modes scan two fields per
+         * frame and double-scanned modes draw every line twice, the same adjustment xrandr makes.
+         */
+        [[nodiscard]] constexpr rational_refresh_rate refresh_rate() const noexcept {
+            uint64_t num = dot_clock * (interlaced ? 2 : 1);
+            uint64_t den = static_cast<uint64_t>(htotal) * vtotal * (double_scan ? 2 : 1);
+            if (num == 0 || den == 0) return {};
+
+            uint64_t g = std::gcd(num, den);
+            return { num / g, den / g };
+        }
+    };
+
     struct video_mode {
         glm::uvec2 resolution;
-        int refresh_rate;
+        rational_refresh_rate refresh_rate;
         display_depth depth;
+        mode_timing timing;
 
         bool operator==(const video_mode &rhs) const;
 
         bool operator!=(const video_mode &rhs) const;
     };
+
+    /**
+     * Time between refreshes in the given mode. Modes that don't report a rate are treated as 60Hz.
+     */
+    constexpr std::chrono::nanoseconds refresh_period(const video_mode& mode) noexcept {
+        auto period = mode.refresh_rate.period();
+        return period.count() > 0 ? period : std::chrono::nanoseconds(16'666'667);
+    }
+
+    enum class fullscreen_mode : uint8_t {
+        windowed,
+        borderless, // covers the monitor at its current mode, the compositor keeps running
+        exclusive,  // covers the monitor with compositing bypassed, optionally after a mode switch
+    };
+
+    /**
+     * What a caller would like from a mode. Zeroed fields mean "don't care", in which case the largest resolution,
+     * highest refresh rate and deepest format are preferred.
+     */
+    struct video_mode_request {
+        glm::uvec2 resolution{0, 0};
+        rational_refresh_rate refresh_rate{0, 1};
+        uint32_t bits_per_pixel = 0; // red + green + blue, so 24 for 8 bits per channel
+    };
+
+    /**
+     * The order mode tables are kept in: width, height, refresh rate, depth, progressive before interlaced.
+     */
+    bool video_mode_less(const video_mode& lhs, const video_mode& rhs) noexcept;
+
+    /**
+     * Sorts `modes` by video_mode_less and drops repeats. X11 outputs commonly list the same mode several times with
+     * slightly different timings, so modes that only differ by less than 0.05% in refresh rate count as repeats and
+     * the lowest rate of them is kept. That is far tighter than the 0.1% between 59.94 and 60Hz, which stay apart.
+     * Follow up with keep_video_mode() for the mode the monitor is actually in.
+     */
+    void sort_video_modes(std::vector<video_mode>& modes);
+
+    /**
+     * Makes sure `mode` itself is in a table prepared by sort_video_modes(), so a monitor's current mode always
+     * compares equal to one of its video_modes(). The near-duplicate `mode` was merged into is swapped for it, and
+     * it is added when nothing matches.
+     */
+    void keep_video_mode(std::vector<video_mode>& modes, const video_mode& mode);
+
+    /**
+     * The mode closest to `request` in a table prepared by sort_video_modes(), or null if it is empty.
+     * Resolution decides first, then refresh rate, then depth. An exact resolution is found by binary search,
+     * otherwise the resolution nearest in area is used.
+     */
+    const video_mode* find_closest_video_mode(std::span<const video_mode> modes, const video_mode_request& request) noexcept;
+
+    /**
+     * Every mode in `modes` for which `predicate(mode)` holds, in table order.
+     */
+    template<typename Predicate>
+    std::vector<video_mode> find_video_modes(std::span<const video_mode> modes, Predicate&& predicate) {
+        std::vector<video_mode> matches;
+        for (const auto& mode : modes) {
+            if (predicate(mode)) matches.push_back(mode);
+        }
+        return matches;
+    }
+
+    /**
+     * Plain-value snapshot of a monitor, see windowing_engine::monitor_infos().
+     *
+     * Everything is stored inline so arrays of these are contiguous and can be copied around freely. The monitor's
+     * modes are the range [first_mode, first_mode + mode_count) of windowing_engine::video_modes().
+     */
+    struct monitor_info {
+        static constexpr std::size_t max_name_length = 63;
+
+        uint64_t id; // native identifier, matches monitor_event::monitor
+        glm::ivec2 position;
+        glm::uvec2 size;
+        glm::uvec2 physical_size;
+        glm::vec2 dpi;
+        glm::vec2 scale;
+        video_mode current_mode;
+        uint32_t first_mode, mode_count;
+        bool primary;
+        char name_storage[max_name_length + 1]; // truncated, always null terminated
+
+        [[nodiscard]] std::string_view name() const noexcept {
+            return name_storage;
+        }
+    };
+
+    static_assert(std::is_trivially_copyable_v<monitor_info>, "monitor_info must be trivially copyable");
+
+    /**
+     * A monitor the headless backend reports, see windowing_engine_config::headless_monitors.
+     */
+    struct headless_monitor_config {
+        std::string name = "HEADLESS-1";
+        glm::ivec2 position{0, 0};
+        glm::uvec2 physical_size{527, 296}; // millimeters, a 24" 16:9 panel
+        glm::vec2 dpi{KAT_BASE_DPI, KAT_BASE_DPI};
+
+        /**
+         * Every mode the monitor offers, sorted when it is created. Empty means 1920x1080 at 60Hz only.
+         */
+        std::vector<video_mode> video_modes;
+
+        /**
+         * The mode it starts in, picked from video_modes with find_closest_video_mode().
+         */
+        video_mode_request current_mode{};
+
+        bool primary = false; // the first monitor is primary when none is marked
+    };
+
+    struct windowing_engine_config {
+        /**
+         * Run the platform connection on a dedicated thread that reads and timestamps events as they arrive and
+         * answers window manager pings, handing everything to process_events() through a lock-free queue.
+         * Only supported on X11; other platforms ignore it.
+         */
+        bool event_thread = false;
+
+        /**
+         * Upper bound on how long the event thread sleeps between checks of the connection.
+         */
+        std::chrono::milliseconds event_thread_poll_interval{1};
+
+        /**
+         * Report unaccelerated mouse motion and buttons as raw_mouse_* events at the device's full rate, in
+         * addition to the usual pointer events. Turned on automatically while a window has the pointer locked.
+         * Uses XInput2 on X11; other platforms ignore it.
+         */
+        bool raw_mouse_input = false;
+
+        /**
+         * Backends to try before the others, by name from backends(), comma separated. KAT_WINDOW_BACKEND comes
+         * first when it is set. Empty probes in the default order.
+         */
+        std::string backend;
+
+        /**
+         * Monitors of the headless backend. One 1920x1080 60Hz monitor when empty.
+         */
+        std::vector<headless_monitor_config> headless_monitors;
+    };
 }
\ No newline at end of file
@@ -0,0 +1,222 @@
+#include "kat/cfg.hpp"
+#ifdef KATWINDOW_TARGET_WAYLAND
+#include "framebuffer_wayland.hpp"
+#include "kat/window/window.hpp"
+#include <spdlog/spdlog.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+
+namespace kat::window::wayland {
+    namespace {
+        uint64_t timespec_ns(const timespec& ts) {
+            return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000ull + static_cast<uint64_t>(ts.tv_nsec);
+        }
+
+        /**
+         * A presentation clock timestamp on the steady_clock timeline, which is CLOCK_MONOTONIC on Linux.
+         * Compositors use CLOCK_MONOTONIC as well, the conversion is only there for the ones that don't.
+         */
+        uint64_t to_steady_ns(clockid_t clock, uint64_t ns) {
+            if (clock == CLOCK_MONOTONIC) return ns;
+
+            timespec other{}, monotonic{};
+            clock_gettime(clock, &other);
+            clock_gettime(CLOCK_MONOTONIC, &monotonic);
+            return ns - timespec_ns(other) + timespec_ns(monotonic);
+        }
+    }
+
+    framebuffer_wayland::framebuffer_wayland(const std::shared_ptr<windowing_engine> &engine, const window_wayland &window) : framebuffer_wayland(engine, window, window.size()) {
+    }
+
+    framebuffer_wayland::framebuffer_wayland(const std::shared_ptr<windowing_engine> &engine, const window_wayland &window, glm::uvec2 size_) : m_windowing_engine(engine), m_window(&window), m_size(size_) {
+        m_surface = window.platform_handle();
+        create_buffers();
+    }
+
+    framebuffer_wayland::~framebuffer_wayland() {
+        for (auto& slot : m_feedback) {
+            if (slot.feedback) {
+                wp_presentation_feedback_destroy(slot.feedback);
+                slot.feedback = nullptr;
+            }
+        }
+        destroy_buffers();
+    }
+
+    std::span<uint32_t> framebuffer_wayland::pixels() {
+        auto& buf = m_buffers[m_back];
+        wait_for(buf);
+        return { buf.pixels, static_cast<std::size_t>(m_size.x) * m_size.y };
+    }
+
+    uint32_t framebuffer_wayland::stride() const {
+        return m_size.x;
+    }
+
+    glm::uvec2 framebuffer_wayland::size() const {
+        return m_size;
+    }
+
+    void framebuffer_wayland::resize(glm::uvec2 new_size) {
+        if (new_size == m_size) return;
+
+        destroy_buffers();
+        m_size = new_size;
+        create_buffers();
+    }
+
+    void framebuffer_wayland::present() {
+        auto& buf = m_buffers[m_back];
+        if (!buf.handle || !m_window->can_present()) return;
+
+        wl_surface_attach(m_surface, buf.handle, 0, 0);
+        wl_surface_damage_buffer(m_surface, 0, 0, INT32_MAX, INT32_MAX);
+        request_feedback();
+        wl_surface_commit(m_surface);
+        buf.busy = true;
+
+        wl_display_flush(m_windowing_engine->platform_as<engine_state_wayland>()->display);
+        m_back ^= 1;
+    }
+
+    const presentation_wayland &framebuffer_wayland::last_presentation() const {
+        return m_last_presentation;
+    }
+
+    uint64_t framebuffer_wayland::presented_frames() const {
+        return m_presented;
+    }
+
+    uint64_t framebuffer_wayland::discarded_frames() const {
+        return m_discarded;
+    }
+
+    void framebuffer_wayland::request_feedback() {
+        auto* presentation = m_windowing_engine->platform_as<engine_state_wayland>()->presentation;
+        if (!presentation) return;
+
+        for (auto& slot : m_feedback) {
+            if (slot.feedback) continue;
+
+            static const wp_presentation_feedback_listener feedback_listener = {
+                    .sync_output = on_feedback_sync_output,
+                    .presented = on_feedback_presented,
+                    .discarded = on_feedback_discarded,
+            };
+            slot.owner = this;
+            slot.submitted = event_timestamp_now();
+            slot.feedback = wp_presentation_feedback(presentation, m_surface);
+            wp_presentation_feedback_add_listener(slot.feedback, &feedback_listener, &slot);
+            return;
+        }
+    }
+
+    void framebuffer_wayland::on_feedback_sync_output(void *, struct wp_presentation_feedback *, wl_output *) {
+    }
+
+    void framebuffer_wayland::on_feedback_presented(void *data, struct wp_presentation_feedback *feedback, uint32_t tv_sec_hi, uint32_t tv_sec_lo,
+                                                    uint32_t tv_nsec, uint32_t refresh, uint32_t seq_hi, uint32_t seq_lo, uint32_t flags) {
+        auto& slot = *static_cast<feedback_slot*>(data);
+        auto* self = slot.owner;
+
+        uint64_t seconds = (static_cast<uint64_t>(tv_sec_hi) << 32) | tv_sec_lo;
+        uint64_t presented = to_steady_ns(self->m_windowing_engine->platform_as<engine_state_wayland>()->presentation_clock, seconds * 1'000'000'000ull + tv_nsec);
+
+        auto& p = self->m_last_presentation;
+        p.presented = presented;
+        p.latency = std::chrono::nanoseconds(presented > slot.submitted ? presented - slot.submitted : 0);
+        p.refresh = std::chrono::nanoseconds(refresh);
+        p.sequence = (static_cast<uint64_t>(seq_hi) << 32) | seq_lo;
+        p.vsync = flags & WP_PRESENTATION_FEEDBACK_KIND_VSYNC;
+        p.hw_clock = flags & WP_PRESENTATION_FEEDBACK_KIND_HW_CLOCK;
+        p.zero_copy = flags & WP_PRESENTATION_FEEDBACK_KIND_ZERO_COPY;
+        self->m_presented++;
+
+        wp_presentation_feedback_destroy(feedback);
+        slot.feedback = nullptr;
+    }
+
+    void framebuffer_wayland::on_feedback_discarded(void *data, struct wp_presentation_feedback *feedback) {
+        auto& slot = *static_cast<feedback_slot*>(data);
+        slot.owner->m_discarded++;
+
+        wp_presentation_feedback_destroy(feedback);
+        slot.feedback = nullptr;
+    }
+
+    void framebuffer_wayland::on_buffer_release(void *data, wl_buffer *) {
+        static_cast<buffer*>(data)->busy = false;
+    }
+
+    void framebuffer_wayland::wait_for(buffer &buf) {
+        auto* platform = m_windowing_engine->platform_as<engine_state_wayland>();
+        while (buf.busy) {
+            if (!platform->dispatch_blocking()) {
+                // the connection is gone, nobody is reading the buffer any more
+                buf.busy = false;
+            }
+        }
+    }
+
+    void framebuffer_wayland::create_buffers() {
+        m_back = 0;
+        if (m_size.x == 0 || m_size.y == 0) return;
+
+        std::size_t buffer_bytes = static_cast<std::size_t>(m_size.x) * m_size.y * 4;
+        m_mapping_size = buffer_bytes * 2;
+
+        int fd = memfd_create("kat-framebuffer", MFD_CLOEXEC);
+        if (fd < 0 || ftruncate(fd, static_cast<off_t>(m_mapping_size)) < 0) {
+            SPDLOG_ERROR("Can't allocate framebuffer memory: {}", std::strerror(errno));
+            if (fd >= 0) close(fd);
+            m_mapping_size = 0;
+            return;
+        }
+
+        m_mapping = mmap(nullptr, m_mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (m_mapping == MAP_FAILED) {
+            SPDLOG_ERROR("Can't map framebuffer memory: {}", std::strerror(errno));
+            close(fd);
+            m_mapping = nullptr;
+            m_mapping_size = 0;
+            return;
+        }
+
+        // the buffers keep the pool alive, neither the pool nor the fd are needed after this
+        auto* platform = m_windowing_engine->platform_as<engine_state_wayland>();
+        auto* pool = wl_shm_create_pool(platform->shm, fd, static_cast<int32_t>(m_mapping_size));
+        static const wl_buffer_listener buffer_listener = {
+                .release = on_buffer_release,
+        };
+        for (std::size_t i = 0 ; i < std::size(m_buffers) ; i++) {
+            auto& buf = m_buffers[i];
+            buf.pixels = reinterpret_cast<uint32_t*>(static_cast<char*>(m_mapping) + i * buffer_bytes);
+            buf.handle = wl_shm_pool_create_buffer(pool, static_cast<int32_t>(i * buffer_bytes), static_cast<int32_t>(m_size.x),
+                                                   static_cast<int32_t>(m_size.y), static_cast<int32_t>(m_size.x * 4), WL_SHM_FORMAT_XRGB8888);
+            wl_buffer_add_listener(buf.handle, &buffer_listener, &buf);
+        }
+        wl_shm_pool_destroy(pool);
+        close(fd);
+
+        SPDLOG_DEBUG("Created {}x{} framebuffer (wl_shm)", m_size.x, m_size.y);
+    }
+
+    void framebuffer_wayland::destroy_buffers() {
+        for (auto& buf : m_buffers) {
+            // destroying a buffer the compositor still holds is allowed, it keeps showing what it already has
+            if (buf.handle) wl_buffer_destroy(buf.handle);
+            buf = buffer{};
+        }
+
+        if (m_mapping) {
+            munmap(m_mapping, m_mapping_size);
+            m_mapping = nullptr;
+            m_mapping_size = 0;
+        }
+    }
+}
+#endif
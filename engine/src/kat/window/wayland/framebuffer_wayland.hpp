@@ -0,0 +1,140 @@
+#pragma once
+
+#include "kat/cfg.hpp"
+
+#ifdef KATWINDOW_TARGET_WAYLAND
+
+#include "kat/window/wayland/platform_wayland.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <glm/glm.hpp>
+
+namespace kat::window::wayland {
+    /**
+     * When and how a presented frame reached the screen, from wp_presentation feedback.
+     */
+    struct presentation_wayland {
+        /**
+         * When the frame turned into light, in steady_clock nanoseconds like event timestamps.
+         */
+        uint64_t presented = 0;
+
+        /**
+         * From present() to `presented`.
+         */
+        std::chrono::nanoseconds latency{0};
+
+        /**
+         * The output's refresh period as the compositor measured it, zero if it couldn't tell (variable refresh).
+         */
+        std::chrono::nanoseconds refresh{0};
+
+        /**
+         * The output's vblank counter, zero if it has none.
+         */
+        uint64_t sequence = 0;
+
+        bool vsync = false;     // presented on a vertical retrace rather than torn in
+        bool hw_clock = false;  // `presented` comes from the display hardware, not a software estimate
+        bool zero_copy = false; // scanned out straight from our buffer, no compositor copy
+    };
+
+    /**
+     * CPU-side pixel surface presented to a window_wayland, the counterpart of framebuffer_x11.
+     *
+     * Pixels are XRGB8888. Two wl_shm buffers share one memfd mapping, so the game fills frame N+1 while the
+     * compositor reads frame N and nothing is copied through the socket. Every present asks for wp_presentation
+     * feedback, which reports when the frame was actually shown and the refresh period of the output it went to;
+     * that is a better clock to pace against than the mode's nominal refresh rate.
+     *
+     * Must not outlive its window.
+     */
+    class framebuffer_wayland {
+    public:
+        framebuffer_wayland(const std::shared_ptr<windowing_engine>& engine, const window_wayland& window);
+        framebuffer_wayland(const std::shared_ptr<windowing_engine>& engine, const window_wayland& window, glm::uvec2 size_);
+        ~framebuffer_wayland();
+
+        framebuffer_wayland(const framebuffer_wayland&) = delete;
+        framebuffer_wayland& operator=(const framebuffer_wayland&) = delete;
+
+        /**
+         * The buffer the next present() will show. If the compositor still holds it from an earlier present this
+         * waits for the release, which only happens when the game runs more than a frame ahead.
+         */
+        [[nodiscard]] std::span<uint32_t> pixels();
+
+        /**
+         * Distance between rows of pixels(), in pixels.
+         */
+        [[nodiscard]] uint32_t stride() const;
+        [[nodiscard]] glm::uvec2 size() const;
+
+        /**
+         * Reallocates both buffers. Contents are lost.
+         */
+        void resize(glm::uvec2 new_size);
+
+        /**
+         * Attaches the current back buffer, commits and swaps buffers. Does nothing while the window is hidden or
+         * waiting for its configure.
+         */
+        void present();
+
+        /**
+         * The most recent frame the compositor reported as shown. All zero until the first one.
+         */
+        [[nodiscard]] const presentation_wayland& last_presentation() const;
+        [[nodiscard]] uint64_t presented_frames() const;
+
+        /**
+         * Frames replaced by a newer one before they were shown.
+         */
+        [[nodiscard]] uint64_t discarded_frames() const;
+
+    private:
+        struct buffer {
+            wl_buffer* handle = nullptr;
+            uint32_t* pixels = nullptr;
+            bool busy = false;
+        };
+
+        struct feedback_slot {
+            framebuffer_wayland* owner = nullptr;
+            struct wp_presentation_feedback* feedback = nullptr;
+            uint64_t submitted = 0;
+        };
+
+        static void on_buffer_release(void* data, wl_buffer* buffer);
+        static void on_feedback_sync_output(void* data, struct wp_presentation_feedback* feedback, wl_output* output);
+        static void on_feedback_presented(void* data, struct wp_presentation_feedback* feedback, uint32_t tv_sec_hi, uint32_t tv_sec_lo,
+                                          uint32_t tv_nsec, uint32_t refresh, uint32_t seq_hi, uint32_t seq_lo, uint32_t flags);
+        static void on_feedback_discarded(void* data, struct wp_presentation_feedback* feedback);
+
+        void create_buffers();
+        void destroy_buffers();
+        void wait_for(buffer& buf);
+        void request_feedback();
+
+        std::shared_ptr<windowing_engine> m_windowing_engine;
+        const window_wayland* m_window;
+        wl_surface* m_surface;
+
+        glm::uvec2 m_size;
+        buffer m_buffers[2];
+        uint32_t m_back = 0;
+        void* m_mapping = nullptr;
+        std::size_t m_mapping_size = 0;
+
+        // a handful of frames can be waiting for feedback at once, more than that and we just don't ask
+        std::array<feedback_slot, 4> m_feedback;
+        presentation_wayland m_last_presentation;
+        uint64_t m_presented = 0, m_discarded = 0;
+    };
+}
+
+#endif
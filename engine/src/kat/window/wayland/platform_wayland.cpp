@@ -0,0 +1,1071 @@
+#include "kat/cfg.hpp"
+#ifdef KATWINDOW_TARGET_WAYLAND
+#include "platform_wayland.hpp"
+#include "kat/window/window.hpp"
+#include <spdlog/spdlog.h>
+#include <linux/input-event-codes.h>
+#include <sys/mman.h>
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace kat::window::wayland {
+    namespace {
+        uint64_t surface_id(wl_surface* surface) {
+            return reinterpret_cast<uintptr_t>(surface);
+        }
+
+        // the wl_output and xdg_output versions whose events the listeners below handle
+        constexpr uint32_t max_output_version = 4;
+        constexpr uint32_t max_xdg_output_version = 3;
+        constexpr uint32_t max_seat_version = 5;
+        constexpr uint32_t max_compositor_version = 4;
+
+        // Wheel distance of one click on libinput compositors, in surface pixels. Continuous scrolling (touchpads,
+        // wheels without axis_discrete) is converted with it so it comes out in the same clicks as discrete scrolling.
+        constexpr double continuous_scroll_per_step = 10.0;
+
+        // Objects from a seat or output bound at a version with a release request have to be released, destroying
+        // only the proxy leaves the compositor's side alive for as long as the connection lasts.
+        void release_keyboard(wl_keyboard* keyboard) {
+            if (wl_keyboard_get_version(keyboard) >= WL_KEYBOARD_RELEASE_SINCE_VERSION) {
+                wl_keyboard_release(keyboard);
+            } else {
+                wl_keyboard_destroy(keyboard);
+            }
+        }
+
+        void release_pointer(wl_pointer* pointer) {
+            if (wl_pointer_get_version(pointer) >= WL_POINTER_RELEASE_SINCE_VERSION) {
+                wl_pointer_release(pointer);
+            } else {
+                wl_pointer_destroy(pointer);
+            }
+        }
+
+        void release_seat(wl_seat* seat) {
+            if (wl_seat_get_version(seat) >= WL_SEAT_RELEASE_SINCE_VERSION) {
+                wl_seat_release(seat);
+            } else {
+                wl_seat_destroy(seat);
+            }
+        }
+
+        void release_output(wl_output* output) {
+            if (wl_output_get_version(output) >= WL_OUTPUT_RELEASE_SINCE_VERSION) {
+                wl_output_release(output);
+            } else {
+                wl_output_destroy(output);
+            }
+        }
+    }
+
+    bool make_mouse_button_wayland(uint32_t button, mouse_button &out) {
+        switch (button) {
+            case BTN_LEFT: out = mouse_button::left; return true;
+            case BTN_RIGHT: out = mouse_button::right; return true;
+            case BTN_MIDDLE: out = mouse_button::middle; return true;
+            case BTN_SIDE: out = mouse_button::x1; return true;
+            case BTN_EXTRA: out = mouse_button::x2; return true;
+            default: return false;
+        }
+    }
+
+    ::kat::window::video_mode make_video_mode_wayland(int32_t width, int32_t height, int32_t refresh_mhz) {
+        ::kat::window::video_mode mode{};
+        mode.resolution = { static_cast<uint32_t>(std::max(width, 0)), static_cast<uint32_t>(std::max(height, 0)) };
+        if (refresh_mhz > 0) {
+            uint64_t g = std::gcd(static_cast<uint64_t>(refresh_mhz), 1000ull);
+            mode.refresh_rate = { static_cast<uint64_t>(refresh_mhz) / g, 1000 / g };
+        }
+        mode.depth = { 8, 8, 8 };
+        return mode;
+    }
+
+    engine_state_wayland::engine_state_wayland(const windowing_engine_config &config) : m_config(config) {
+        KAT_PROFILE_ZONE("engine_state_wayland::engine_state_wayland");
+        display = wl_display_connect(nullptr);
+        if (!display) {
+            SPDLOG_ERROR("Can't connect to a Wayland compositor, is WAYLAND_DISPLAY set?");
+            m_app_exit = true;
+            return;
+        }
+
+        m_xkb_context = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
+
+        static const wl_registry_listener registry_listener = {
+                .global = on_registry_global,
+                .global_remove = on_registry_global_remove,
+        };
+        registry = wl_display_get_registry(display);
+        wl_registry_add_listener(registry, &registry_listener, this);
+
+        // first round trip: the globals, which binds them
+        wl_display_roundtrip(display);
+
+        if (!compositor || !shm || !wm_base) {
+            SPDLOG_ERROR("The compositor lacks wl_compositor, wl_shm or xdg_wm_base");
+            m_app_exit = true;
+            return;
+        }
+
+        if (output_manager) {
+            for (auto& mon : m_monitors) {
+                mon->attach_xdg_output(output_manager);
+            }
+        }
+
+        // second round trip: what the bound globals say about themselves, outputs, seat and keymap
+        wl_display_roundtrip(display);
+
+        if (!presentation) {
+            SPDLOG_INFO("Compositor has no wp_presentation, presentation timing won't be reported");
+        }
+
+        SPDLOG_DEBUG("Connected to Wayland compositor");
+        SPDLOG_DEBUG("{} outputs, xdg-output {}, xdg-decoration {}", m_monitors.size(), output_manager != nullptr, decoration_manager != nullptr);
+    }
+
+    engine_state_wayland::~engine_state_wayland() {
+        if (!display) return;
+
+        for (auto& mon : m_monitors) {
+            mon->release();
+        }
+        m_monitors.clear();
+
+        if (m_keyboard) release_keyboard(m_keyboard);
+        if (m_pointer) release_pointer(m_pointer);
+        if (m_seat) release_seat(m_seat);
+        if (m_xkb_state) xkb_state_unref(m_xkb_state);
+        if (m_xkb_keymap) xkb_keymap_unref(m_xkb_keymap);
+        if (m_xkb_context) xkb_context_unref(m_xkb_context);
+
+        if (presentation) wp_presentation_destroy(presentation);
+        if (decoration_manager) zxdg_decoration_manager_v1_destroy(decoration_manager);
+        if (output_manager) zxdg_output_manager_v1_destroy(output_manager);
+        if (wm_base) xdg_wm_base_destroy(wm_base);
+        if (shm) wl_shm_destroy(shm);
+        if (compositor) wl_compositor_destroy(compositor);
+        if (registry) wl_registry_destroy(registry);
+
+        wl_display_disconnect(display);
+        SPDLOG_DEBUG("Closed Display");
+    }
+
+    void engine_state_wayland::on_registry_global(void *data, wl_registry *registry, uint32_t name, const char *interface, uint32_t version) {
+        auto* self = static_cast<engine_state_wayland*>(data);
+        std::string_view iface = interface;
+
+        if (iface == wl_compositor_interface.name) {
+            self->compositor = static_cast<wl_compositor*>(wl_registry_bind(registry, name, &wl_compositor_interface, std::min(version, max_compositor_version)));
+        } else if (iface == wl_shm_interface.name) {
+            self->shm = static_cast<wl_shm*>(wl_registry_bind(registry, name, &wl_shm_interface, 1));
+        } else if (iface == xdg_wm_base_interface.name) {
+            static const xdg_wm_base_listener wm_base_listener = {
+                    .ping = on_wm_base_ping,
+            };
+            self->wm_base = static_cast<xdg_wm_base*>(wl_registry_bind(registry, name, &xdg_wm_base_interface, 1));
+            xdg_wm_base_add_listener(self->wm_base, &wm_base_listener, self);
+        } else if (iface == zxdg_output_manager_v1_interface.name) {
+            self->output_manager = static_cast<zxdg_output_manager_v1*>(wl_registry_bind(registry, name, &zxdg_output_manager_v1_interface, std::min(version, max_xdg_output_version)));
+        } else if (iface == zxdg_decoration_manager_v1_interface.name) {
+            self->decoration_manager = static_cast<zxdg_decoration_manager_v1*>(wl_registry_bind(registry, name, &zxdg_decoration_manager_v1_interface, 1));
+        } else if (iface == wp_presentation_interface.name) {
+            static const wp_presentation_listener presentation_listener = {
+                    .clock_id = on_presentation_clock_id,
+            };
+            self->presentation = static_cast<wp_presentation*>(wl_registry_bind(registry, name, &wp_presentation_interface, 1));
+            wp_presentation_add_listener(self->presentation, &presentation_listener, self);
+        } else if (iface == wl_seat_interface.name && !self->m_seat) {
+            // one seat is all a game needs, the first is the default seat everywhere
+            static const wl_seat_listener seat_listener = {
+                    .capabilities = on_seat_capabilities,
+                    .name = on_seat_name,
+            };
+            self->m_seat = static_cast<wl_seat*>(wl_registry_bind(registry, name, &wl_seat_interface, std::min(version, max_seat_version)));
+            self->m_seat_name = name;
+            wl_seat_add_listener(self->m_seat, &seat_listener, self);
+        } else if (iface == wl_output_interface.name) {
+            self->bind_output(name, version);
+        }
+    }
+
+    void engine_state_wayland::on_registry_global_remove(void *data, wl_registry *, uint32_t name) {
+        auto* self = static_cast<engine_state_wayland*>(data);
+
+        auto it = std::find_if(self->m_monitors.begin(), self->m_monitors.end(), [name](const auto& mon) { return mon->id() == name; });
+        if (it != self->m_monitors.end()) {
+            (*it)->release();
+            self->m_monitors.erase(it);
+            self->m_monitors_generation++;
+
+            // the next oldest output takes over as primary
+            if (!self->m_monitors.empty()) {
+                self->m_monitors.front()->primary(true);
+            }
+
+            auto ev = make_event(event_type::monitor_changed, 0, self->m_dispatch_timestamp);
+            ev.monitor.monitor = name;
+            ev.monitor.change = monitor_change::disconnected;
+            self->m_events.push(ev);
+            return;
+        }
+
+        if (name == self->m_seat_name && self->m_seat) {
+            if (self->m_keyboard) release_keyboard(std::exchange(self->m_keyboard, nullptr));
+            if (self->m_pointer) release_pointer(std::exchange(self->m_pointer, nullptr));
+            release_seat(std::exchange(self->m_seat, nullptr));
+            self->m_keyboard_focus = self->m_pointer_focus = nullptr;
+            self->m_repeating = false;
+            self->m_scroll = {};
+        }
+    }
+
+    void engine_state_wayland::bind_output(uint32_t name, uint32_t version) {
+        if (version < 2) {
+            // without wl_output.done there is no telling when an output's description is complete
+            SPDLOG_WARN("Ignoring wl_output {} with version {}", name, version);
+            return;
+        }
+
+        auto* output = static_cast<wl_output*>(wl_registry_bind(registry, name, &wl_output_interface, std::min(version, max_output_version)));
+        auto mon = std::make_shared<monitor_wayland>(this, name, output);
+        mon->primary(m_monitors.empty());
+        if (output_manager) {
+            mon->attach_xdg_output(output_manager);
+        }
+        m_monitors.push_back(std::move(mon));
+    }
+
+    void engine_state_wayland::on_wm_base_ping(void *, xdg_wm_base *wm_base, uint32_t serial) {
+        xdg_wm_base_pong(wm_base, serial);
+    }
+
+    void engine_state_wayland::on_presentation_clock_id(void *data, wp_presentation *, uint32_t clock) {
+        static_cast<engine_state_wayland*>(data)->presentation_clock = static_cast<clockid_t>(clock);
+    }
+
+    void engine_state_wayland::on_seat_capabilities(void *data, wl_seat *seat, uint32_t capabilities) {
+        auto* self = static_cast<engine_state_wayland*>(data);
+
+        bool has_keyboard = capabilities & WL_SEAT_CAPABILITY_KEYBOARD;
+        if (has_keyboard && !self->m_keyboard) {
+            static const wl_keyboard_listener keyboard_listener = {
+                    .keymap = on_keyboard_keymap,
+                    .enter = on_keyboard_enter,
+                    .leave = on_keyboard_leave,
+                    .key = on_keyboard_key,
+                    .modifiers = on_keyboard_modifiers,
+                    .repeat_info = on_keyboard_repeat_info,
+            };
+            self->m_keyboard = wl_seat_get_keyboard(seat);
+            wl_keyboard_add_listener(self->m_keyboard, &keyboard_listener, self);
+        } else if (!has_keyboard && self->m_keyboard) {
+            release_keyboard(std::exchange(self->m_keyboard, nullptr));
+            self->m_keyboard_focus = nullptr;
+            self->m_repeating = false;
+        }
+
+        bool has_pointer = capabilities & WL_SEAT_CAPABILITY_POINTER;
+        if (has_pointer && !self->m_pointer) {
+            static const wl_pointer_listener pointer_listener = {
+                    .enter = on_pointer_enter,
+                    .leave = on_pointer_leave,
+                    .motion = on_pointer_motion,
+                    .button = on_pointer_button,
+                    .axis = on_pointer_axis,
+                    .frame = on_pointer_frame,
+                    .axis_source = [](void*, wl_pointer*, uint32_t) {},
+                    .axis_stop = [](void*, wl_pointer*, uint32_t, uint32_t) {},
+                    .axis_discrete = on_pointer_axis_discrete,
+                    // never sent at the version bound, listed so newer headers see every member initialized
+#ifdef WL_POINTER_AXIS_VALUE120_SINCE_VERSION
+                    .axis_value120 = [](void*, wl_pointer*, uint32_t, int32_t) {},
+#endif
+#ifdef WL_POINTER_AXIS_RELATIVE_DIRECTION_SINCE_VERSION
+                    .axis_relative_direction = [](void*, wl_pointer*, uint32_t, uint32_t) {},
+#endif
+            };
+            self->m_pointer = wl_seat_get_pointer(seat);
+            wl_pointer_add_listener(self->m_pointer, &pointer_listener, self);
+        } else if (!has_pointer && self->m_pointer) {
+            release_pointer(std::exchange(self->m_pointer, nullptr));
+            self->m_pointer_focus = nullptr;
+            self->m_scroll = {};
+        }
+    }
+
+    void engine_state_wayland::on_seat_name(void *, wl_seat *, [[maybe_unused]] const char *name) {
+        SPDLOG_DEBUG("Using seat {}", name);
+    }
+
+    void engine_state_wayland::on_keyboard_keymap(void *data, wl_keyboard *, uint32_t format, int32_t fd, uint32_t size) {
+        auto* self = static_cast<engine_state_wayland*>(data);
+        if (format != WL_KEYBOARD_KEYMAP_FORMAT_XKB_V1 || !self->m_xkb_context) {
+            close(fd);
+            return;
+        }
+
+        // must be MAP_PRIVATE, since version 7 the compositor may hand every client the same read-only fd
+        void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED) {
+            SPDLOG_ERROR("Can't map the keymap: {}", std::strerror(errno));
+            return;
+        }
+
+        const char* text = static_cast<const char*>(map);
+        auto* keymap = xkb_keymap_new_from_buffer(self->m_xkb_context, text, strnlen(text, size), XKB_KEYMAP_FORMAT_TEXT_V1, XKB_KEYMAP_COMPILE_NO_FLAGS);
+        munmap(map, size);
+        if (!keymap) {
+            SPDLOG_ERROR("Can't compile the compositor's keymap");
+            return;
+        }
+
+        if (self->m_xkb_state) xkb_state_unref(self->m_xkb_state);
+        if (self->m_xkb_keymap) xkb_keymap_unref(self->m_xkb_keymap);
+        self->m_xkb_keymap = keymap;
+        self->m_xkb_state = xkb_state_new(keymap);
+
+        self->m_mod_shift = xkb_keymap_mod_get_index(keymap, XKB_MOD_NAME_SHIFT);
+        self->m_mod_control = xkb_keymap_mod_get_index(keymap, XKB_MOD_NAME_CTRL);
+        self->m_mod_alt = xkb_keymap_mod_get_index(keymap, XKB_MOD_NAME_ALT);
+        self->m_mod_super = xkb_keymap_mod_get_index(keymap, XKB_MOD_NAME_LOGO);
+        SPDLOG_DEBUG("Loaded keymap");
+    }
+
+    void engine_state_wayland::on_keyboard_enter(void *data, wl_keyboard *, uint32_t, wl_surface *surface, wl_array *) {
+        auto* self = static_cast<engine_state_wayland*>(data);
+        self->m_keyboard_focus = surface;
+        self->m_events.push(make_event(event_type::focus_gained, surface_id(surface), self->m_dispatch_timestamp));
+    }
+
+    void engine_state_wayland::on_keyboard_leave(void *data, wl_keyboard *, uint32_t, wl_surface *surface) {
+        auto* self = static_cast<engine_state_wayland*>(data);
+        // null when the surface was destroyed first, forget_surface() already dropped the focus then
+        if (surface) {
+            self->m_events.push(make_event(event_type::focus_lost, surface_id(surface), self->m_dispatch_timestamp));
+        }
+        self->m_keyboard_focus = nullptr;
+        self->m_repeating = false;
+    }
+
+    void engine_state_wayland::on_keyboard_key(void *data, wl_keyboard *, uint32_t, uint32_t, uint32_t key, uint32_t state) {
+        auto* self = static_cast<engine_state_wayland*>(data);
+        bool down = state == WL_KEYBOARD_KEY_STATE_PRESSED;
+        self->send_key(key, down, false, self->m_dispatch_timestamp);
+
+        if (down) {
+            // xkb keycodes are evdev codes offset by 8, like X keycodes
+            bool repeats = self->m_xkb_keymap && xkb_keymap_key_repeats(self->m_xkb_keymap, key + 8);
+            self->m_repeating = repeats && self->m_repeat_rate > 0;
+            self->m_repeat_key = key;
+            self->m_repeat_next = self->m_dispatch_timestamp + static_cast<uint64_t>(self->m_repeat_delay) * 1'000'000ull;
+        } else if (key == self->m_repeat_key) {
+            self->m_repeating = false;
+        }
+    }
+
+    void engine_state_wayland::on_keyboard_modifiers(void *data, wl_keyboard *, uint32_t, uint32_t depressed, uint32_t latched, uint32_t locked, uint32_t group) {
+        auto* self = static_cast<engine_state_wayland*>(data);
+        if (!self->m_xkb_state) return;
+
+        xkb_state_update_mask(self->m_xkb_state, depressed, latched, locked, 0, 0, group);
+
+        auto active = [self](xkb_mod_index_t index) {
+            return index != XKB_MOD_INVALID && xkb_state_mod_index_is_active(self->m_xkb_state, index, XKB_STATE_MODS_EFFECTIVE) > 0;
+        };
+
+        uint16_t mods = key_modifier_none;
+        if (active(self->m_mod_shift)) mods |= key_modifier_shift;
+        if (active(self->m_mod_control)) mods |= key_modifier_control;
+        if (active(self->m_mod_alt)) mods |= key_modifier_alt;
+        if (active(self->m_mod_super)) mods |= key_modifier_super;
+        self->m_modifiers = mods;
+    }
+
+    void engine_state_wayland::on_keyboard_repeat_info(void *data, wl_keyboard *, int32_t rate, int32_t delay) {
+        auto* self = static_cast<engine_state_wayland*>(data);
+        self->m_repeat_rate = rate;
+        self->m_repeat_delay = delay;
+        if (rate <= 0) {
+            self->m_repeating = false;
+        }
+    }
+
+    void engine_state_wayland::send_key(uint32_t key, bool down, bool repeat, uint64_t timestamp) {
+        auto ev = make_event(down ? event_type::key_down : event_type::key_up, surface_id(m_keyboard_focus), timestamp);
+        ev.key.scancode = key;
+        ev.key.modifiers = m_modifiers;
+        ev.key.repeat = repeat;
+
+        // the unshifted symbol in the active layout, what the other backends report as keycode
+        if (m_xkb_keymap && m_xkb_state) {
+            const xkb_keysym_t* syms = nullptr;
+            auto layout = xkb_state_key_get_layout(m_xkb_state, key + 8);
+            if (xkb_keymap_key_get_syms_by_level(m_xkb_keymap, key + 8, layout, 0, &syms) > 0) {
+                ev.key.keycode = syms[0];
+            }
+        }
+
+        m_events.push(ev);
+    }
+
+    void engine_state_wayland::generate_repeats(uint64_t now) {
+        if (!m_repeating || !m_keyboard_focus || m_repeat_rate <= 0) return;
+
+        uint64_t interval = 1'000'000'000ull / static_cast<uint64_t>(m_repeat_rate);
+        // after a long stall only the repeats of the last few intervals are worth sending
+        if (now > m_repeat_next + interval * 4) {
+            m_repeat_next = now - interval * 4;
+        }
+
+        while (m_repeat_next <= now) {
+            send_key(m_repeat_key, true, true, m_repeat_next);
+            m_repeat_next += interval;
+        }
+    }
+
+    void engine_state_wayland::on_pointer_enter(void *data, wl_pointer *, uint32_t, wl_surface *surface, wl_fixed_t x, wl_fixed_t y) {
+        auto* self = static_cast<engine_state_wayland*>(data);
+        self->m_pointer_focus = surface;
+        self->m_pointer_position = { wl_fixed_to_int(x), wl_fixed_to_int(y) };
+    }
+
+    void engine_state_wayland::on_pointer_leave(void *data, wl_pointer *, uint32_t, wl_surface *) {
+        static_cast<engine_state_wayland*>(data)->m_pointer_focus = nullptr;
+    }
+
+    void engine_state_wayland::on_pointer_motion(void *data, wl_pointer *, uint32_t, wl_fixed_t x, wl_fixed_t y) {
+        auto* self = static_cast<engine_state_wayland*>(data);
+        self->m_pointer_position = { wl_fixed_to_int(x), wl_fixed_to_int(y) };
+
+        auto ev = make_event(event_type::mouse_move, surface_id(self->m_pointer_focus), self->m_dispatch_timestamp);
+        ev.mouse_move.x = self->m_pointer_position.x;
+        ev.mouse_move.y = self->m_pointer_position.y;
+        self->m_events.push(ev);
+    }
+
+    void engine_state_wayland::on_pointer_button(void *data, wl_pointer *, uint32_t, uint32_t, uint32_t button, uint32_t state) {
+        auto* self = static_cast<engine_state_wayland*>(data);
+        mouse_button mb;
+        if (!make_mouse_button_wayland(button, mb)) return;
+
+        bool press = state == WL_POINTER_BUTTON_STATE_PRESSED;
+        auto ev = make_event(press ? event_type::mouse_button_down : event_type::mouse_button_up, surface_id(self->m_pointer_focus), self->m_dispatch_timestamp);
+        ev.mouse_button.button = mb;
+        ev.mouse_button.x = self->m_pointer_position.x;
+        ev.mouse_button.y = self->m_pointer_position.y;
+        self->m_events.push(ev);
+    }
+
+    void engine_state_wayland::on_pointer_axis(void *data, wl_pointer *pointer, uint32_t, uint32_t axis, wl_fixed_t value) {
+        auto* self = static_cast<engine_state_wayland*>(data);
+
+        // axis values are in surface pixels, positive down/right
+        auto& scroll = self->m_scroll;
+        (axis == WL_POINTER_AXIS_VERTICAL_SCROLL ? scroll.continuous.y : scroll.continuous.x) += wl_fixed_to_double(value);
+        scroll.pending = true;
+
+        // before version 5 there are no frames to wait for
+        if (wl_pointer_get_version(pointer) < WL_POINTER_FRAME_SINCE_VERSION) {
+            self->flush_scroll();
+        }
+    }
+
+    void engine_state_wayland::on_pointer_axis_discrete(void *data, wl_pointer *, uint32_t axis, int32_t discrete) {
+        auto* self = static_cast<engine_state_wayland*>(data);
+
+        // sent ahead of the axis event of the same frame, whole wheel clicks
+        auto& scroll = self->m_scroll;
+        (axis == WL_POINTER_AXIS_VERTICAL_SCROLL ? scroll.discrete.y : scroll.discrete.x) += discrete;
+        scroll.pending = true;
+    }
+
+    void engine_state_wayland::on_pointer_frame(void *data, wl_pointer *) {
+        static_cast<engine_state_wayland*>(data)->flush_scroll();
+    }
+
+    void engine_state_wayland::flush_scroll() {
+        if (!m_scroll.pending) return;
+
+        // Flipped to the X11 convention of one unit per click, positive up. Clicks are taken as they are when the
+        // compositor counted them, pixel distances are converted.
+        auto steps = [](int32_t discrete, double continuous) {
+            return static_cast<float>(discrete != 0 ? discrete : continuous / continuous_scroll_per_step);
+        };
+
+        auto ev = make_event(event_type::mouse_scroll, surface_id(m_pointer_focus), m_dispatch_timestamp);
+        ev.mouse_scroll.x = steps(m_scroll.discrete.x, m_scroll.continuous.x);
+        ev.mouse_scroll.y = -steps(m_scroll.discrete.y, m_scroll.continuous.y);
+        m_scroll = {};
+
+        // axis_stop frames and the like carry no movement
+        if (ev.mouse_scroll.x != 0.f || ev.mouse_scroll.y != 0.f) {
+            m_events.push(ev);
+        }
+    }
+
+    void engine_state_wayland::handle_output_done(monitor_wayland &monitor, bool first) {
+        m_monitors_generation++;
+
+        auto ev = make_event(event_type::monitor_changed, 0, m_dispatch_timestamp);
+        ev.monitor.monitor = monitor.id();
+        ev.monitor.change = first ? monitor_change::connected : monitor_change::configuration;
+        m_events.push(ev);
+    }
+
+    void engine_state_wayland::setup(const std::shared_ptr<windowing_engine> &engine) {
+        m_engine = engine;
+
+        if (m_config.event_thread) {
+            SPDLOG_WARN("The event thread is only implemented by the Xlib backend");
+        }
+
+        if (m_config.raw_mouse_input) {
+            SPDLOG_WARN("Raw mouse input is only implemented by the Xlib backend");
+        }
+    }
+
+    glm::vec2 engine_state_wayland::dpi() const {
+        int32_t scale = 1;
+        for (const auto& mon : m_monitors) {
+            if (mon->is_done()) scale = std::max(scale, mon->buffer_scale());
+        }
+        return glm::vec2(KAT_BASE_DPI * static_cast<float>(scale));
+    }
+
+    glm::vec2 engine_state_wayland::scale() const {
+        return kat::window::conv_dpi_to_scale(dpi());
+    }
+
+    std::vector<std::shared_ptr<monitor>> engine_state_wayland::monitors() const {
+        std::vector<std::shared_ptr<monitor>> done;
+        done.reserve(m_monitors.size());
+        for (const auto& mon : m_monitors) {
+            if (mon->is_done()) done.push_back(mon);
+        }
+        return done;
+    }
+
+    uint64_t engine_state_wayland::monitors_generation() const {
+        return m_monitors_generation;
+    }
+
+    monitor_wayland* engine_state_wayland::find_monitor(wl_output *output) const {
+        for (const auto& mon : m_monitors) {
+            if (mon->get_output() == output) return mon.get();
+        }
+        return nullptr;
+    }
+
+    monitor_wayland* engine_state_wayland::find_monitor(uint64_t id) const {
+        for (const auto& mon : m_monitors) {
+            if (mon->id() == id) return mon.get();
+        }
+        return nullptr;
+    }
+
+    void engine_state_wayland::process_events() {
+        m_dispatch_timestamp = event_timestamp_now();
+        if (!display) return;
+
+        // the prepare/read/dispatch dance is how to read without blocking
+        while (wl_display_prepare_read(display) != 0) {
+            wl_display_dispatch_pending(display);
+        }
+        wl_display_flush(display);
+
+        pollfd pfd{ wl_display_get_fd(display), POLLIN, 0 };
+        if (poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLIN)) {
+            wl_display_read_events(display);
+        } else {
+            wl_display_cancel_read(display);
+        }
+        wl_display_dispatch_pending(display);
+
+        generate_repeats(event_timestamp_now());
+
+        if (!m_app_exit && wl_display_get_error(display)) {
+            SPDLOG_ERROR("Lost the connection to the Wayland compositor: {}", std::strerror(wl_display_get_error(display)));
+            m_app_exit = true;
+        }
+    }
+
+    bool engine_state_wayland::dispatch_blocking() {
+        if (!display) return false;
+        m_dispatch_timestamp = event_timestamp_now();
+        return wl_display_dispatch(display) != -1;
+    }
+
+    void engine_state_wayland::forget_surface(wl_surface *surface) {
+        if (m_keyboard_focus == surface) {
+            m_keyboard_focus = nullptr;
+            m_repeating = false;
+        }
+        if (m_pointer_focus == surface) {
+            m_pointer_focus = nullptr;
+        }
+    }
+
+    uint64_t engine_state_wayland::dispatch_timestamp() const {
+        return m_dispatch_timestamp;
+    }
+
+    monitor_wayland::monitor_wayland(engine_state_wayland *platform, uint32_t name, wl_output *output) : m_platform(platform), m_name(name), m_output(output) {
+        static const wl_output_listener output_listener = {
+                .geometry = on_geometry,
+                .mode = on_mode,
+                .done = on_done,
+                .scale = on_scale,
+                .name = on_name,
+                .description = on_description,
+        };
+        wl_output_add_listener(m_output, &output_listener, this);
+    }
+
+    monitor_wayland::~monitor_wayland() {
+        release();
+    }
+
+    void monitor_wayland::release() {
+        if (m_xdg_output) {
+            zxdg_output_v1_destroy(std::exchange(m_xdg_output, nullptr));
+        }
+        if (m_output) {
+            release_output(std::exchange(m_output, nullptr));
+        }
+    }
+
+    void monitor_wayland::attach_xdg_output(zxdg_output_manager_v1 *manager) {
+        if (m_xdg_output || !m_output) return;
+
+        static const zxdg_output_v1_listener xdg_output_listener = {
+                .logical_position = on_logical_position,
+                .logical_size = on_logical_size,
+                .done = on_xdg_done,
+                .name = on_xdg_name,
+                .description = on_xdg_description,
+        };
+        m_xdg_output = zxdg_output_manager_v1_get_xdg_output(manager, m_output);
+        zxdg_output_v1_add_listener(m_xdg_output, &xdg_output_listener, this);
+    }
+
+    void monitor_wayland::on_geometry(void *data, wl_output *, int32_t x, int32_t y, int32_t physical_width, int32_t physical_height,
+                                      int32_t, const char *make, const char *model, int32_t) {
+        auto* self = static_cast<monitor_wayland*>(data);
+        self->m_physical_size = { static_cast<uint32_t>(std::max(physical_width, 0)), static_cast<uint32_t>(std::max(physical_height, 0)) };
+        if (!self->m_has_logical_geometry) {
+            self->m_position = { x, y };
+        }
+        // replaced by wl_output.name where the compositor has version 4
+        if (self->m_output_name.empty()) {
+            self->m_output_name = std::string(make) + " " + model;
+        }
+    }
+
+    void monitor_wayland::on_mode(void *data, wl_output *, uint32_t flags, int32_t width, int32_t height, int32_t refresh) {
+        auto* self = static_cast<monitor_wayland*>(data);
+        if (!self->m_in_batch) {
+            self->m_pending_modes.clear();
+            self->m_in_batch = true;
+        }
+
+        auto mode = make_video_mode_wayland(width, height, refresh);
+        self->m_pending_modes.push_back(mode);
+        if (flags & WL_OUTPUT_MODE_CURRENT) {
+            self->m_video_mode = mode;
+        }
+    }
+
+    void monitor_wayland::on_done(void *data, wl_output *) {
+        auto* self = static_cast<monitor_wayland*>(data);
+        if (self->m_in_batch) {
+            self->m_video_modes = std::move(self->m_pending_modes);
+            self->m_pending_modes.clear();
+            sort_video_modes(self->m_video_modes);
+            if (self->m_video_mode.resolution != glm::uvec2(0, 0)) {
+                keep_video_mode(self->m_video_modes, self->m_video_mode);
+            }
+            self->m_in_batch = false;
+        }
+
+        bool first = !self->m_done;
+        self->m_done = true;
+        self->m_platform->handle_output_done(*self, first);
+    }
+
+    void monitor_wayland::on_scale(void *data, wl_output *, int32_t factor) {
+        static_cast<monitor_wayland*>(data)->m_scale = std::max(factor, 1);
+    }
+
+    void monitor_wayland::on_name(void *data, wl_output *, const char *name) {
+        static_cast<monitor_wayland*>(data)->m_output_name = name;
+    }
+
+    void monitor_wayland::on_description(void *, wl_output *, const char *) {
+    }
+
+    void monitor_wayland::on_logical_position(void *data, zxdg_output_v1 *, int32_t x, int32_t y) {
+        auto* self = static_cast<monitor_wayland*>(data);
+        self->m_position = { x, y };
+        self->m_has_logical_geometry = true;
+    }
+
+    void monitor_wayland::on_logical_size(void *data, zxdg_output_v1 *, int32_t width, int32_t height) {
+        auto* self = static_cast<monitor_wayland*>(data);
+        self->m_logical_size = { static_cast<uint32_t>(std::max(width, 0)), static_cast<uint32_t>(std::max(height, 0)) };
+        self->m_has_logical_geometry = true;
+    }
+
+    void monitor_wayland::on_xdg_done(void *, zxdg_output_v1 *) {
+        // version 3 and up rely on wl_output.done alone, older versions send both and wl_output.done handles it
+    }
+
+    void monitor_wayland::on_xdg_name(void *data, zxdg_output_v1 *, const char *name) {
+        static_cast<monitor_wayland*>(data)->m_output_name = name;
+    }
+
+    void monitor_wayland::on_xdg_description(void *, zxdg_output_v1 *, const char *) {
+    }
+
+    glm::vec2 monitor_wayland::dpi() const {
+        return glm::vec2(KAT_BASE_DPI * static_cast<float>(m_scale));
+    }
+
+    glm::vec2 monitor_wayland::scale() const {
+        return kat::window::conv_dpi_to_scale(dpi());
+    }
+
+    glm::uvec2 monitor_wayland::physical_size() const {
+        return m_physical_size;
+    }
+
+    glm::uvec2 monitor_wayland::size() const {
+        if (m_logical_size.x && m_logical_size.y) {
+            return m_logical_size;
+        }
+        return m_video_mode.resolution / static_cast<uint32_t>(m_scale);
+    }
+
+    glm::ivec2 monitor_wayland::position() const {
+        return m_position;
+    }
+
+    std::string_view monitor_wayland::name() const {
+        return m_output_name;
+    }
+
+    bool monitor_wayland::is_primary() const {
+        return m_is_primary;
+    }
+
+    void monitor_wayland::primary(bool is_primary) {
+        m_is_primary = is_primary;
+    }
+
+    ::kat::window::video_mode monitor_wayland::video_mode() const {
+        return m_video_mode;
+    }
+
+    std::span<const ::kat::window::video_mode> monitor_wayland::video_modes() const {
+        return m_video_modes;
+    }
+
+    const ::kat::window::video_mode* monitor_wayland::closest_video_mode(const video_mode_request &request) const {
+        return find_closest_video_mode(m_video_modes, request);
+    }
+
+    uint64_t monitor_wayland::id() const {
+        return m_name;
+    }
+
+    wl_output* monitor_wayland::get_output() const {
+        return m_output;
+    }
+
+    int32_t monitor_wayland::buffer_scale() const {
+        return m_scale;
+    }
+
+    bool monitor_wayland::is_done() const {
+        return m_done;
+    }
+}
+
+namespace kat::window {
+    wayland::window_wayland::window_wayland(windowing_engine &engine, std::string_view title_, glm::uvec2 size_, glm::ivec2) : m_windowing_engine(&engine), m_size(size_) {
+        KAT_PROFILE_ZONE("window_wayland::window_wayland");
+        auto* platform = engine.platform_as<engine_state_wayland>();
+
+        static const wl_surface_listener surface_listener = {
+                .enter = on_surface_enter,
+                .leave = on_surface_leave,
+        };
+        static const xdg_surface_listener xdg_surface_listener = {
+                .configure = on_xdg_surface_configure,
+        };
+        static const xdg_toplevel_listener toplevel_listener = {
+                .configure = on_toplevel_configure,
+                .close = on_toplevel_close,
+                // xdg_wm_base is bound at version 1, these come with 4 and 5
+#ifdef XDG_TOPLEVEL_CONFIGURE_BOUNDS_SINCE_VERSION
+                .configure_bounds = [](void*, xdg_toplevel*, int32_t, int32_t) {},
+#endif
+#ifdef XDG_TOPLEVEL_WM_CAPABILITIES_SINCE_VERSION
+                .wm_capabilities = [](void*, xdg_toplevel*, wl_array*) {},
+#endif
+        };
+
+        m_surface = wl_compositor_create_surface(platform->compositor);
+        wl_surface_add_listener(m_surface, &surface_listener, this);
+        m_xdg_surface = xdg_wm_base_get_xdg_surface(platform->wm_base, m_surface);
+        xdg_surface_add_listener(m_xdg_surface, &xdg_surface_listener, this);
+        m_toplevel = xdg_surface_get_toplevel(m_xdg_surface);
+        xdg_toplevel_add_listener(m_toplevel, &toplevel_listener, this);
+        xdg_toplevel_set_app_id(m_toplevel, "kat");
+        title(title_);
+
+        if (platform->decoration_manager) {
+            m_decoration = zxdg_decoration_manager_v1_get_toplevel_decoration(platform->decoration_manager, m_toplevel);
+            zxdg_toplevel_decoration_v1_set_mode(m_decoration, ZXDG_TOPLEVEL_DECORATION_V1_MODE_SERVER_SIDE);
+        }
+
+        wait_for_configure();
+    }
+
+    wayland::window_wayland::~window_wayland() {
+        auto* platform = m_windowing_engine->platform_as<engine_state_wayland>();
+        platform->forget_surface(m_surface);
+
+        if (m_decoration) zxdg_toplevel_decoration_v1_destroy(m_decoration);
+        xdg_toplevel_destroy(m_toplevel);
+        xdg_surface_destroy(m_xdg_surface);
+        wl_surface_destroy(m_surface);
+        wl_display_flush(platform->display);
+    }
+
+    void wayland::window_wayland::wait_for_configure() {
+        // the initial commit without a buffer asks the compositor for a configure, nothing may be attached before it
+        m_configured = false;
+        wl_surface_commit(m_surface);
+        while (!m_configured && m_windowing_engine->platform_as<engine_state_wayland>()->dispatch_blocking()) {
+        }
+    }
+
+    void wayland::window_wayland::on_surface_enter(void *data, wl_surface *, wl_output *output) {
+        auto* self = static_cast<window_wayland*>(data);
+        auto* mon = self->m_windowing_engine->platform_as<engine_state_wayland>()->find_monitor(output);
+        if (!mon) return;
+
+        if (std::find(self->m_outputs.begin(), self->m_outputs.end(), mon->id()) == self->m_outputs.end()) {
+            self->m_outputs.push_back(mon->id());
+        }
+        self->update_scale();
+    }
+
+    void wayland::window_wayland::on_surface_leave(void *data, wl_surface *, wl_output *output) {
+        auto* self = static_cast<window_wayland*>(data);
+        auto* mon = self->m_windowing_engine->platform_as<engine_state_wayland>()->find_monitor(output);
+        if (!mon) return;
+
+        std::erase(self->m_outputs, mon->id());
+        self->update_scale();
+    }
+
+    void wayland::window_wayland::update_scale() {
+        auto* platform = m_windowing_engine->platform_as<engine_state_wayland>();
+        int32_t new_scale = 1;
+        for (auto id : m_outputs) {
+            if (auto* mon = platform->find_monitor(id)) {
+                new_scale = std::max(new_scale, mon->buffer_scale());
+            }
+        }
+
+        if (new_scale != m_scale) {
+            m_scale = new_scale;
+            auto current = dpi();
+            auto ev = make_event(event_type::dpi_changed, surface_id(m_surface), platform->dispatch_timestamp());
+            ev.dpi.x = current.x;
+            ev.dpi.y = current.y;
+            platform->events().push(ev);
+        }
+    }
+
+    void wayland::window_wayland::on_toplevel_configure(void *data, xdg_toplevel *, int32_t width, int32_t height, wl_array *states) {
+        auto* self = static_cast<window_wayland*>(data);
+        // 0x0 leaves the size to us, which is the normal case for a floating window
+        self->m_pending_size = { static_cast<uint32_t>(std::max(width, 0)), static_cast<uint32_t>(std::max(height, 0)) };
+        self->m_pending_maximized = self->m_pending_fullscreen = false;
+
+        uint32_t* state;
+        wl_array_for_each(state, states) {
+            if (*state == XDG_TOPLEVEL_STATE_MAXIMIZED) self->m_pending_maximized = true;
+            if (*state == XDG_TOPLEVEL_STATE_FULLSCREEN) self->m_pending_fullscreen = true;
+        }
+    }
+
+    void wayland::window_wayland::on_xdg_surface_configure(void *data, xdg_surface *surface, uint32_t serial) {
+        auto* self = static_cast<window_wayland*>(data);
+        auto* platform = self->m_windowing_engine->platform_as<engine_state_wayland>();
+        xdg_surface_ack_configure(surface, serial);
+
+        if (self->m_pending_size.x && self->m_pending_size.y && self->m_pending_size != self->m_size) {
+            self->m_size = self->m_pending_size;
+            auto ev = make_event(event_type::resize, surface_id(self->m_surface), platform->dispatch_timestamp());
+            ev.resize.width = self->m_size.x;
+            ev.resize.height = self->m_size.y;
+            platform->events().push(ev);
+        }
+
+        self->m_maximized = self->m_pending_maximized;
+        // the compositor can take a window out of fullscreen on its own
+        if (!self->m_pending_fullscreen) {
+            self->m_fullscreen = fullscreen_mode::windowed;
+        }
+        self->m_configured = true;
+    }
+
+    void wayland::window_wayland::on_toplevel_close(void *data, xdg_toplevel *) {
+        auto* self = static_cast<window_wayland*>(data);
+        auto* platform = self->m_windowing_engine->platform_as<engine_state_wayland>();
+        platform->events().push(make_event(event_type::close_requested, surface_id(self->m_surface), platform->dispatch_timestamp()));
+        platform->m_app_exit = true;
+        SPDLOG_INFO("Exit");
+    }
+
+    std::string wayland::window_wayland::title() const {
+        return m_title;
+    }
+
+    void wayland::window_wayland::title(std::string_view new_title) {
+        m_title = new_title;
+        xdg_toplevel_set_title(m_toplevel, m_title.c_str());
+        wl_display_flush(m_windowing_engine->platform_as<engine_state_wayland>()->display);
+    }
+
+    glm::vec2 wayland::window_wayland::dpi() const {
+        return glm::vec2(KAT_BASE_DPI * static_cast<float>(m_scale));
+    }
+
+    glm::vec2 wayland::window_wayland::scale() const {
+        return kat::window::conv_dpi_to_scale(dpi());
+    }
+
+    glm::uvec2 wayland::window_wayland::size() const {
+        return m_size;
+    }
+
+    glm::ivec2 wayland::window_wayland::position() const {
+        auto* platform = m_windowing_engine->platform_as<engine_state_wayland>();
+        for (auto id : m_outputs) {
+            if (auto* mon = platform->find_monitor(id)) {
+                return mon->position();
+            }
+        }
+        return { 0, 0 };
+    }
+
+    void wayland::window_wayland::size(glm::uvec2 new_size) {
+        if (new_size == m_size) return;
+        m_size = new_size;
+
+        auto* platform = m_windowing_engine->platform_as<engine_state_wayland>();
+        auto ev = make_event(event_type::resize, surface_id(m_surface), event_timestamp_now());
+        ev.resize.width = m_size.x;
+        ev.resize.height = m_size.y;
+        platform->events().push(ev);
+    }
+
+    void wayland::window_wayland::position(glm::ivec2) {
+        SPDLOG_DEBUG("Wayland windows can't be positioned by the client");
+    }
+
+    bool wayland::window_wayland::decorated() const {
+        return m_decorated;
+    }
+
+    void wayland::window_wayland::decorated(bool new_mode) {
+        if (new_mode == m_decorated) return;
+        m_decorated = new_mode;
+
+        if (m_decoration) {
+            // client side with a client that draws none is an undecorated window
+            zxdg_toplevel_decoration_v1_set_mode(m_decoration, m_decorated ? ZXDG_TOPLEVEL_DECORATION_V1_MODE_SERVER_SIDE : ZXDG_TOPLEVEL_DECORATION_V1_MODE_CLIENT_SIDE);
+            wl_display_flush(m_windowing_engine->platform_as<engine_state_wayland>()->display);
+        }
+    }
+
+    fullscreen_mode wayland::window_wayland::fullscreen() const {
+        return m_fullscreen;
+    }
+
+    void wayland::window_wayland::fullscreen(fullscreen_mode new_mode) {
+        bool was_fullscreen = m_fullscreen != fullscreen_mode::windowed;
+        bool is_fullscreen = new_mode != fullscreen_mode::windowed;
+        if (was_fullscreen != is_fullscreen) {
+            if (is_fullscreen) {
+                xdg_toplevel_set_fullscreen(m_toplevel, nullptr);
+            } else {
+                xdg_toplevel_unset_fullscreen(m_toplevel);
+            }
+        }
+
+        m_fullscreen = new_mode;
+        wl_display_flush(m_windowing_engine->platform_as<engine_state_wayland>()->display);
+    }
+
+    void wayland::window_wayland::restore() {
+        if (m_fullscreen != fullscreen_mode::windowed) {
+            fullscreen(fullscreen_mode::windowed);
+        }
+        if (m_maximized) {
+            xdg_toplevel_unset_maximized(m_toplevel);
+        }
+        // there is no unminimize on Wayland, the user brings the window back
+        show();
+        wl_display_flush(m_windowing_engine->platform_as<engine_state_wayland>()->display);
+    }
+
+    void wayland::window_wayland::maximize() {
+        xdg_toplevel_set_maximized(m_toplevel);
+        wl_display_flush(m_windowing_engine->platform_as<engine_state_wayland>()->display);
+    }
+
+    void wayland::window_wayland::minimize() {
+        xdg_toplevel_set_minimized(m_toplevel);
+        wl_display_flush(m_windowing_engine->platform_as<engine_state_wayland>()->display);
+    }
+
+    void wayland::window_wayland::show() {
+        if (!m_hidden) return;
+        m_hidden = false;
+        wait_for_configure();
+    }
+
+    void wayland::window_wayland::hide() {
+        if (m_hidden) return;
+        m_hidden = true;
+        m_configured = false;
+
+        wl_surface_attach(m_surface, nullptr, 0, 0);
+        wl_surface_commit(m_surface);
+        wl_display_flush(m_windowing_engine->platform_as<engine_state_wayland>()->display);
+    }
+
+    bool wayland::window_wayland::can_present() const {
+        return m_configured && !m_hidden;
+    }
+
+    wl_surface* wayland::window_wayland::platform_handle() const {
+        return m_surface;
+    }
+
+    uint64_t wayland::window_wayland::native_handle() const {
+        return surface_id(m_surface);
+    }
+}
+#endif
@@ -0,0 +1,403 @@
+#pragma once
+
+#include "kat/cfg.hpp"
+
+#ifdef KATWINDOW_TARGET_WAYLAND
+
+#include "kat/window/utils.hpp"
+#include "kat/window/events.hpp"
+#include "kat/window/platform.hpp"
+
+#include <wayland-client.h>
+#include <xdg-shell-client-protocol.h>
+#include <xdg-output-unstable-v1-client-protocol.h>
+#include <xdg-decoration-unstable-v1-client-protocol.h>
+#include <presentation-time-client-protocol.h>
+#include <xkbcommon/xkbcommon.h>
+#include <vector>
+#include <memory>
+#include <glm/glm.hpp>
+#include <string_view>
+#include <string>
+#include <utility>
+#include <span>
+#include <ctime>
+
+namespace kat::window {
+    struct windowing_engine;
+
+    namespace wayland {
+        class monitor_wayland;
+        class window_wayland;
+
+        /**
+         * evdev button code (BTN_LEFT...) to mouse_button. False for buttons we don't report.
+         */
+        bool make_mouse_button_wayland(uint32_t button, mouse_button& out);
+
+        /**
+         * A wl_output mode. Refresh comes in mHz; timings and depth aren't reported, depth is that of the
+         * XRGB8888 buffers we draw into.
+         */
+        ::kat::window::video_mode make_video_mode_wayland(int32_t width, int32_t height, int32_t refresh_mhz);
+
+        /**
+         * Platform state for a native Wayland connection.
+         *
+         * Globals are bound during construction with two round trips, the second one collecting the initial state
+         * of every output and the seat. Monitors are wl_outputs and are kept current by the compositor's events, so
+         * unlike X11 nothing is enumerated on demand. Wayland has no server-side key repeat; repeats are generated
+         * in process_events() from the rate and delay the compositor reports.
+         */
+        struct engine_state_wayland final : public platform_state_base<window_wayland> {
+            wl_display* display = nullptr;
+            wl_registry* registry = nullptr;
+            wl_compositor* compositor = nullptr;
+            wl_shm* shm = nullptr;
+            xdg_wm_base* wm_base = nullptr;
+            zxdg_output_manager_v1* output_manager = nullptr;
+            zxdg_decoration_manager_v1* decoration_manager = nullptr;
+            wp_presentation* presentation = nullptr;
+
+            /**
+             * The clock wp_presentation timestamps are in, announced by the compositor. CLOCK_MONOTONIC in practice.
+             */
+            clockid_t presentation_clock = CLOCK_MONOTONIC;
+
+            std::weak_ptr<windowing_engine> m_engine;
+
+            explicit engine_state_wayland(const windowing_engine_config& config);
+            ~engine_state_wayland();
+
+            engine_state_wayland(const engine_state_wayland&) = delete;
+            engine_state_wayland& operator=(const engine_state_wayland&) = delete;
+
+            /**
+             * Wayland has no global DPI, this is KAT_BASE_DPI times the largest output scale.
+             */
+            [[nodiscard]] glm::vec2 dpi() const;
+            [[nodiscard]] glm::vec2 scale() const;
+
+            /**
+             * Outputs the compositor has finished describing.
+             */
+            [[nodiscard]] std::vector<std::shared_ptr<monitor>> monitors() const override;
+            [[nodiscard]] uint64_t monitors_generation() const override;
+
+            /**
+             * The monitor for a wl_output the compositor mentioned in an event, or null if it's gone already.
+             */
+            [[nodiscard]] monitor_wayland* find_monitor(wl_output* output) const;
+            [[nodiscard]] monitor_wayland* find_monitor(uint64_t id) const;
+
+            void setup(const std::shared_ptr<windowing_engine>& engine) override;
+
+            void process_events() override;
+
+            /**
+             * Blocks until the compositor has sent something and dispatches it. Used while waiting for configure
+             * events and buffer releases. False once the connection is broken.
+             */
+            bool dispatch_blocking();
+
+            /**
+             * Drops keyboard and pointer focus still pointing at `surface`, called as its window is destroyed.
+             */
+            void forget_surface(wl_surface* surface);
+
+            /**
+             * Timestamp for events produced by the dispatch in progress, taken once per process_events().
+             */
+            [[nodiscard]] uint64_t dispatch_timestamp() const;
+
+            /**
+             * Called by a monitor when the compositor finishes a batch of changes to it. `first` is the batch that
+             * describes a newly connected output.
+             */
+            void handle_output_done(monitor_wayland& monitor, bool first);
+
+        private:
+            static void on_registry_global(void* data, wl_registry* registry, uint32_t name, const char* interface, uint32_t version);
+            static void on_registry_global_remove(void* data, wl_registry* registry, uint32_t name);
+            static void on_wm_base_ping(void* data, xdg_wm_base* wm_base, uint32_t serial);
+            static void on_presentation_clock_id(void* data, wp_presentation* presentation, uint32_t clock);
+            static void on_seat_capabilities(void* data, wl_seat* seat, uint32_t capabilities);
+            static void on_seat_name(void* data, wl_seat* seat, const char* name);
+
+            static void on_keyboard_keymap(void* data, wl_keyboard* keyboard, uint32_t format, int32_t fd, uint32_t size);
+            static void on_keyboard_enter(void* data, wl_keyboard* keyboard, uint32_t serial, wl_surface* surface, wl_array* keys);
+            static void on_keyboard_leave(void* data, wl_keyboard* keyboard, uint32_t serial, wl_surface* surface);
+            static void on_keyboard_key(void* data, wl_keyboard* keyboard, uint32_t serial, uint32_t time, uint32_t key, uint32_t state);
+            static void on_keyboard_modifiers(void* data, wl_keyboard* keyboard, uint32_t serial, uint32_t depressed, uint32_t latched, uint32_t locked, uint32_t group);
+            static void on_keyboard_repeat_info(void* data, wl_keyboard* keyboard, int32_t rate, int32_t delay);
+
+            static void on_pointer_enter(void* data, wl_pointer* pointer, uint32_t serial, wl_surface* surface, wl_fixed_t x, wl_fixed_t y);
+            static void on_pointer_leave(void* data, wl_pointer* pointer, uint32_t serial, wl_surface* surface);
+            static void on_pointer_motion(void* data, wl_pointer* pointer, uint32_t time, wl_fixed_t x, wl_fixed_t y);
+            static void on_pointer_button(void* data, wl_pointer* pointer, uint32_t serial, uint32_t time, uint32_t button, uint32_t state);
+            static void on_pointer_axis(void* data, wl_pointer* pointer, uint32_t time, uint32_t axis, wl_fixed_t value);
+            static void on_pointer_axis_discrete(void* data, wl_pointer* pointer, uint32_t axis, int32_t discrete);
+            static void on_pointer_frame(void* data, wl_pointer* pointer);
+
+            /**
+             * Sends the scrolling gathered over a pointer frame as one mouse_scroll event.
+             */
+            void flush_scroll();
+
+            void bind_output(uint32_t name, uint32_t version);
+            void send_key(uint32_t key, bool down, bool repeat, uint64_t timestamp);
+            void generate_repeats(uint64_t now);
+
+            windowing_engine_config m_config;
+
+            std::vector<std::shared_ptr<monitor_wayland>> m_monitors;
+            uint64_t m_monitors_generation = 0;
+
+            wl_seat* m_seat = nullptr;
+            uint32_t m_seat_name = 0;
+            wl_keyboard* m_keyboard = nullptr;
+            wl_pointer* m_pointer = nullptr;
+
+            xkb_context* m_xkb_context = nullptr;
+            xkb_keymap* m_xkb_keymap = nullptr;
+            xkb_state* m_xkb_state = nullptr;
+            xkb_mod_index_t m_mod_shift = XKB_MOD_INVALID, m_mod_control = XKB_MOD_INVALID, m_mod_alt = XKB_MOD_INVALID, m_mod_super = XKB_MOD_INVALID;
+            uint16_t m_modifiers = key_modifier_none;
+
+            wl_surface* m_keyboard_focus = nullptr;
+            wl_surface* m_pointer_focus = nullptr;
+            glm::ivec2 m_pointer_position{0, 0};
+
+            // scrolling of the pointer frame in progress, summed until wl_pointer.frame
+            struct pending_scroll {
+                glm::dvec2 continuous{0, 0};
+                glm::ivec2 discrete{0, 0};
+                bool pending = false;
+            } m_scroll;
+
+            // client-side key repeat, in event_timestamp_now() nanoseconds
+            int32_t m_repeat_rate = 25, m_repeat_delay = 600;
+            uint32_t m_repeat_key = 0;
+            bool m_repeating = false;
+            uint64_t m_repeat_next = 0;
+
+            uint64_t m_dispatch_timestamp = 0;
+        };
+
+        class monitor_wayland final : public ::kat::window::monitor {
+        public:
+            monitor_wayland(engine_state_wayland* platform, uint32_t name, wl_output* output);
+            ~monitor_wayland();
+
+            monitor_wayland(const monitor_wayland&) = delete;
+            monitor_wayland& operator=(const monitor_wayland&) = delete;
+
+            /**
+             * KAT_BASE_DPI times the output scale. Wayland clients are meant to render at the scale, not at
+             * whatever the EDID says.
+             */
+            [[nodiscard]] glm::vec2 dpi() const override;
+            [[nodiscard]] glm::vec2 scale() const override;
+
+            [[nodiscard]] glm::uvec2 physical_size() const override;
+
+            /**
+             * Size and position are in the compositor's logical space (xdg-output), the only space Wayland shares
+             * between outputs. Without xdg-output they are the mode's size divided by the scale, at the origin the
+             * compositor put in wl_output.geometry.
+             */
+            [[nodiscard]] glm::uvec2 size() const override;
+            [[nodiscard]] glm::ivec2 position() const override;
+
+            [[nodiscard]] std::string_view name() const override;
+
+            /**
+             * Wayland has no primary output; the one the compositor announced first stands in for it.
+             */
+            [[nodiscard]] bool is_primary() const override;
+
+            [[nodiscard]] ::kat::window::video_mode video_mode() const override;
+
+            /**
+             * Only what the compositor advertises, which since wl_output version 4 is just the current mode.
+             */
+            [[nodiscard]] std::span<const ::kat::window::video_mode> video_modes() const override;
+            [[nodiscard]] const ::kat::window::video_mode* closest_video_mode(const video_mode_request& request) const override;
+
+            /**
+             * The wl_output's registry name, stable for as long as the output is connected.
+             */
+            [[nodiscard]] uint64_t id() const override;
+
+            [[nodiscard]] wl_output* get_output() const;
+            [[nodiscard]] int32_t buffer_scale() const;
+            [[nodiscard]] bool is_done() const;
+
+            void primary(bool is_primary);
+
+            /**
+             * Starts listening to the output's xdg-output, for outputs announced before the output manager.
+             */
+            void attach_xdg_output(zxdg_output_manager_v1* manager);
+
+            /**
+             * Destroys the protocol objects. Called by the platform before it disconnects, monitors handed out
+             * through monitors() can outlive the connection.
+             */
+            void release();
+
+        private:
+            static void on_geometry(void* data, wl_output* output, int32_t x, int32_t y, int32_t physical_width, int32_t physical_height,
+                                    int32_t subpixel, const char* make, const char* model, int32_t transform);
+            static void on_mode(void* data, wl_output* output, uint32_t flags, int32_t width, int32_t height, int32_t refresh);
+            static void on_done(void* data, wl_output* output);
+            static void on_scale(void* data, wl_output* output, int32_t factor);
+            static void on_name(void* data, wl_output* output, const char* name);
+            static void on_description(void* data, wl_output* output, const char* description);
+
+            static void on_logical_position(void* data, zxdg_output_v1* output, int32_t x, int32_t y);
+            static void on_logical_size(void* data, zxdg_output_v1* output, int32_t width, int32_t height);
+            static void on_xdg_done(void* data, zxdg_output_v1* output);
+            static void on_xdg_name(void* data, zxdg_output_v1* output, const char* name);
+            static void on_xdg_description(void* data, zxdg_output_v1* output, const char* description);
+
+            engine_state_wayland* m_platform;
+            uint32_t m_name;
+            wl_output* m_output;
+            zxdg_output_v1* m_xdg_output = nullptr;
+
+            glm::uvec2 m_physical_size{0, 0};
+            glm::ivec2 m_position{0, 0};
+            glm::uvec2 m_logical_size{0, 0};
+            bool m_has_logical_geometry = false;
+            int32_t m_scale = 1;
+            std::string m_output_name;
+            bool m_is_primary = false;
+            bool m_done = false;
+
+            std::vector<::kat::window::video_mode> m_video_modes;
+            ::kat::window::video_mode m_video_mode{};
+
+            // modes of the batch of events the next done completes
+            std::vector<::kat::window::video_mode> m_pending_modes;
+            bool m_in_batch = false;
+        };
+
+        class window_wayland final : public ::kat::window::window {
+        public:
+            /**
+             * Use windowing_engine::create_window(), the engine owns its windows and destroys them before itself.
+             * Returns once the compositor has sent the first configure, so the window can be drawn to right away.
+             * `position_` is ignored, Wayland clients don't place their toplevels.
+             */
+            window_wayland(windowing_engine& engine, std::string_view title_, glm::uvec2 size_, glm::ivec2 position_);
+            ~window_wayland();
+
+            window_wayland(const window_wayland&) = delete;
+            window_wayland& operator=(const window_wayland&) = delete;
+
+            [[nodiscard]] std::string title() const override;
+            void title(std::string_view new_title) override;
+
+            /**
+             * From the largest scale of the outputs the surface is on.
+             */
+            [[nodiscard]] glm::vec2 dpi() const override;
+            [[nodiscard]] glm::vec2 scale() const override;
+
+            /**
+             * Surface size in surface-local coordinates, as last configured or set.
+             */
+            [[nodiscard]] glm::uvec2 size() const override;
+
+            /**
+             * Wayland doesn't tell clients where their windows are. This is the logical position of the output the
+             * surface entered first, which is enough for windowing_engine::monitor_for() to find the right monitor.
+             */
+            [[nodiscard]] glm::ivec2 position() const override;
+
+            /**
+             * Takes effect with the next buffer while the window is floating. A resize event is queued right away,
+             * there is nothing for the compositor to confirm.
+             */
+            void size(glm::uvec2 new_size) override;
+
+            /**
+             * Not possible on Wayland, does nothing.
+             */
+            void position(glm::ivec2 new_position) override;
+
+            [[nodiscard]] bool decorated() const override;
+
+            /**
+             * Asks for server-side decorations through xdg-decoration. Compositors without it (GNOME) never
+             * decorate, so this only records the wish there.
+             */
+            void decorated(bool new_mode) override;
+
+            [[nodiscard]] fullscreen_mode fullscreen() const override;
+
+            /**
+             * borderless and exclusive both map to xdg_toplevel.set_fullscreen; compositors scan a fullscreen surface
+             * out directly when its buffers allow it, there is no mode switching on Wayland.
+             */
+            void fullscreen(fullscreen_mode new_mode) override;
+            // no mode switching here, the monitor overload stays the default that refuses
+            using ::kat::window::window::fullscreen;
+
+            void restore() override;
+            void maximize() override;
+            void minimize() override;
+
+            void show() override;
+
+            /**
+             * Unmaps the surface by committing a null buffer. show() maps it again, which repeats the initial
+             * configure handshake.
+             */
+            void hide() override;
+
+            /**
+             * Configured, mapped and ready for a buffer.
+             */
+            [[nodiscard]] bool can_present() const;
+
+            [[nodiscard]] wl_surface* platform_handle() const;
+            [[nodiscard]] uint64_t native_handle() const override;
+
+        private:
+            static void on_surface_enter(void* data, wl_surface* surface, wl_output* output);
+            static void on_surface_leave(void* data, wl_surface* surface, wl_output* output);
+            static void on_xdg_surface_configure(void* data, xdg_surface* surface, uint32_t serial);
+            static void on_toplevel_configure(void* data, xdg_toplevel* toplevel, int32_t width, int32_t height, wl_array* states);
+            static void on_toplevel_close(void* data, xdg_toplevel* toplevel);
+
+            void wait_for_configure();
+            void update_scale();
+
+            windowing_engine* m_windowing_engine;
+            wl_surface* m_surface = nullptr;
+            xdg_surface* m_xdg_surface = nullptr;
+            xdg_toplevel* m_toplevel = nullptr;
+            zxdg_toplevel_decoration_v1* m_decoration = nullptr;
+
+            std::string m_title;
+            bool m_decorated = true;
+
+            glm::uvec2 m_size;
+            glm::uvec2 m_pending_size{0, 0};
+            bool m_pending_maximized = false, m_pending_fullscreen = false;
+            bool m_maximized = false;
+            fullscreen_mode m_fullscreen = fullscreen_mode::windowed;
+
+            bool m_configured = false;
+            bool m_hidden = false;
+
+            // registry names of the outputs the surface is on, in the order it entered them
+            std::vector<uint64_t> m_outputs;
+            int32_t m_scale = 1;
+        };
+    }
+}
+
+#endif
@@ -4,6 +4,8 @@
 #include "platform_win32.hpp"
 #include "kat/window/window.hpp"
 #include "spdlog/spdlog.h"
+#include <windowsx.h>
+#include <numeric>
 
 namespace kat::window {
 
@@ -23,12 +25,64 @@ namespace kat::window {
         return dd;
     }
 
+    rational_refresh_rate make_refresh_rate_win32(DWORD frequency) {
+        // Whole Hz, EnumDisplaySettings truncates the real rate (59.94Hz comes back as 59). Guessing the fraction
+        // back would turn real 71, 143 or 239Hz panel modes into NTSC rates; the exact rate of the current mode
+        // comes from query_current_timing_win32() instead.
+        return { frequency, 1 };
+    }
+
     video_mode create_video_mode(const DEVMODEA& devMode) {
-        return {
-                { devMode.dmPelsWidth, devMode.dmPelsHeight },
-                static_cast<int>(devMode.dmDisplayFrequency),
-                make_display_depth_win32(devMode.dmBitsPerPel)
-        };
+        video_mode mode{};
+        mode.resolution = { devMode.dmPelsWidth, devMode.dmPelsHeight };
+        mode.refresh_rate = make_refresh_rate_win32(devMode.dmDisplayFrequency);
+        mode.depth = make_display_depth_win32(devMode.dmBitsPerPel);
+        mode.timing.interlaced = (devMode.dmDisplayFlags & DM_INTERLACED) != 0;
+        return mode;
+    }
+
+    // Fills in the exact signal timing of the adapter's current mode from the DisplayConfig API, which (unlike
+    // EnumDisplaySettings) reports the vsync frequency as a fraction along with the pixel rate and totals.
+    bool query_current_timing_win32(const char* adapter_name, video_mode& mode) {
+        UINT32 path_count = 0, mode_count = 0;
+        if (GetDisplayConfigBufferSizes(QDC_ONLY_ACTIVE_PATHS, &path_count, &mode_count) != ERROR_SUCCESS) return false;
+
+        std::vector<DISPLAYCONFIG_PATH_INFO> paths(path_count);
+        std::vector<DISPLAYCONFIG_MODE_INFO> modes(mode_count);
+        if (QueryDisplayConfig(QDC_ONLY_ACTIVE_PATHS, &path_count, paths.data(), &mode_count, modes.data(), nullptr) != ERROR_SUCCESS) return false;
+
+        for (UINT32 i = 0 ; i < path_count ; i++) {
+            const auto& path = paths[i];
+
+            DISPLAYCONFIG_SOURCE_DEVICE_NAME source_name{};
+            source_name.header.type = DISPLAYCONFIG_DEVICE_INFO_GET_SOURCE_NAME;
+            source_name.header.size = sizeof(source_name);
+            source_name.header.adapterId = path.sourceInfo.adapterId;
+            source_name.header.id = path.sourceInfo.id;
+            if (DisplayConfigGetDeviceInfo(&source_name.header) != ERROR_SUCCESS) continue;
+
+            char gdi_name[CCHDEVICENAME]{};
+            WideCharToMultiByte(CP_ACP, 0, source_name.viewGdiDeviceName, -1, gdi_name, sizeof(gdi_name), nullptr, nullptr);
+            if (strcmp(gdi_name, adapter_name) != 0) continue;
+
+            UINT32 idx = path.targetInfo.modeInfoIdx;
+            if (idx == DISPLAYCONFIG_PATH_MODE_IDX_INVALID || idx >= mode_count || modes[idx].infoType != DISPLAYCONFIG_MODE_INFO_TYPE_TARGET) continue;
+
+            const auto& signal = modes[idx].targetMode.targetVideoSignalInfo;
+            if (signal.vSyncFreq.Numerator == 0 || signal.vSyncFreq.Denominator == 0) continue;
+
+            mode.timing.dot_clock = signal.pixelRate;
+            mode.timing.htotal = signal.totalSize.cx;
+            mode.timing.vtotal = signal.totalSize.cy;
+            mode.timing.interlaced = signal.scanLineOrdering == DISPLAYCONFIG_SCANLINE_ORDERING_INTERLACED_UPPERFIELDFIRST ||
+                                     signal.scanLineOrdering == DISPLAYCONFIG_SCANLINE_ORDERING_INTERLACED_LOWERFIELDFIRST;
+
+            uint64_t g = std::gcd<uint64_t, uint64_t>(signal.vSyncFreq.Numerator, signal.vSyncFreq.Denominator);
+            mode.refresh_rate = { signal.vSyncFreq.Numerator / g, signal.vSyncFreq.Denominator / g };
+            return true;
+        }
+
+        return false;
     }
 
     struct mep_params {
@@ -50,7 +104,7 @@ namespace kat::window {
         return true;
     }
 
-    win32::monitor_win32::monitor_win32(const DISPLAY_DEVICE &adapter, const DISPLAY_DEVICE &display, const std::shared_ptr<windowing_engine>& engine) : m_windowing_engine(engine) {
+    win32::monitor_win32::monitor_win32(const DISPLAY_DEVICE &adapter, const DISPLAY_DEVICE &display, const std::shared_ptr<windowing_engine>& engine) {
         m_display_name = display.DeviceName;
         m_adapter_name = adapter.DeviceName;
 
@@ -73,6 +127,17 @@ namespace kat::window {
 
         EnumDisplaySettingsA(adapter.DeviceName, ENUM_CURRENT_SETTINGS, &devMode);
         m_video_mode = create_video_mode(devMode);
+        auto enumerated_hz = m_video_mode.refresh_rate.numerator;
+        if (query_current_timing_win32(adapter.DeviceName, m_video_mode)) {
+            // keep the enumerated entry for the current mode identical to m_video_mode so == still finds it
+            for (auto& vm : m_video_modes) {
+                if (vm.resolution == m_video_mode.resolution && vm.depth == m_video_mode.depth &&
+                    vm.refresh_rate == rational_refresh_rate{ enumerated_hz, 1 }) {
+                    vm = m_video_mode;
+                }
+            }
+        }
+        sort_video_modes(m_video_modes);
 
         m_position.x = devMode.dmPosition.x;
         m_position.y = devMode.dmPosition.y;
@@ -100,8 +165,9 @@ namespace kat::window {
         m_is_primary = m_position == glm::ivec2(0, 0);
     }
 
-    std::vector<std::shared_ptr<monitor>> get_all_monitors(const std::shared_ptr<windowing_engine> &engine) {
-        std::vector<std::shared_ptr<monitor>> monitors;
+    std::vector<std::shared_ptr<win32::monitor_win32>> win32::get_all_monitors_win32(const std::shared_ptr<windowing_engine> &engine) {
+        KAT_PROFILE_ZONE("get_all_monitors_win32");
+        std::vector<std::shared_ptr<monitor_win32>> monitors;
         DISPLAY_DEVICEA adapter;
         adapter.cb = sizeof(DISPLAY_DEVICEA);
         int i = 0;
@@ -126,7 +192,7 @@ namespace kat::window {
                     if (!(display.StateFlags & DISPLAY_DEVICE_ACTIVE)) {
                         SPDLOG_INFO("{} Inactive", display.DeviceName);
                     } else {
-                        monitors.push_back(std::make_shared<monitor>(adapter, display, engine));
+                        monitors.push_back(std::make_shared<monitor_win32>(adapter, display, engine));
                     }
                     ZeroMemory(&display, sizeof(DISPLAY_DEVICEA));
                     display.cb = sizeof(DISPLAY_DEVICEA);
@@ -134,7 +200,7 @@ namespace kat::window {
 
                 if (j == 0) {
                     SPDLOG_INFO("{} Inactive");
-                    monitors.push_back(std::make_shared<monitor>(adapter, adapter, engine)); // im the monitor now
+                    monitors.push_back(std::make_shared<monitor_win32>(adapter, adapter, engine)); // im the monitor now
                 }
             }
 
@@ -177,18 +243,41 @@ namespace kat::window {
         return m_video_mode;
     }
 
-    std::vector<kat::window::video_mode> win32::monitor_win32::video_modes() const {
+    std::span<const kat::window::video_mode> win32::monitor_win32::video_modes() const {
         return m_video_modes;
     }
 
+    const kat::window::video_mode* win32::monitor_win32::closest_video_mode(const video_mode_request &request) const {
+        return find_closest_video_mode(m_video_modes, request);
+    }
 
+    uint64_t win32::monitor_win32::id() const {
+        return reinterpret_cast<uint64_t>(m_handle);
+    }
 
-    win32::engine_state_win32::engine_state_win32() {
+    win32::engine_state_win32::engine_state_win32(const windowing_engine_config& config) {
         SetProcessDpiAwarenessContext(DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2);
+
+        if (config.event_thread) {
+            // window messages are delivered to the thread that created the window, so there is nothing to move
+            SPDLOG_WARN("Dedicated event thread is not supported on Win32, events will be pumped by process_events()");
+        }
     }
 
     std::vector<std::shared_ptr<monitor>> win32::engine_state_win32::monitors() const {
-        return m_monitors;
+        if (!m_monitors_enumerated) {
+            if (auto engine = m_engine.lock()) {
+                m_monitors = get_all_monitors_win32(engine);
+                m_monitors_enumerated = true;
+                m_monitors_generation++;
+            }
+        }
+
+        return { m_monitors.begin(), m_monitors.end() };
+    }
+
+    uint64_t win32::engine_state_win32::monitors_generation() const {
+        return m_monitors_generation;
     }
 
     LRESULT CALLBACK wndproc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
@@ -202,11 +291,10 @@ namespace kat::window {
 
         LONG_PTR lpUserData = GetWindowLongPtrA(hWnd, GWLP_USERDATA);
         if (lpUserData) {
-            auto* w = reinterpret_cast<window*>(lpUserData);
+            auto* w = reinterpret_cast<win32::window_win32*>(lpUserData);
             return w->window_proc(hWnd, uMsg, wParam, lParam);
         }
 
-
         return DefWindowProcA(hWnd, uMsg, wParam, lParam);
     }
 
@@ -214,8 +302,7 @@ namespace kat::window {
 
     void win32::engine_state_win32::setup(const std::shared_ptr<windowing_engine> &engine) {
         m_instance = GetModuleHandleA(nullptr);
-
-        m_monitors = get_all_monitors(engine);
+        m_engine = engine;
 
         WNDCLASSEXA wc;
         ZeroMemory(&wc, sizeof(WNDCLASSEXA));
@@ -243,17 +330,60 @@ namespace kat::window {
 
     }
 
-    bool win32::engine_state_win32::is_app_exit() const {
-        return m_app_exit;
+    uint16_t win32::make_key_modifiers_win32() {
+        uint16_t mods = key_modifier_none;
+        if (GetKeyState(VK_SHIFT) & 0x8000) mods |= key_modifier_shift;
+        if (GetKeyState(VK_CONTROL) & 0x8000) mods |= key_modifier_control;
+        if (GetKeyState(VK_MENU) & 0x8000) mods |= key_modifier_alt;
+        if ((GetKeyState(VK_LWIN) | GetKeyState(VK_RWIN)) & 0x8000) mods |= key_modifier_super;
+        return mods;
+    }
+
+    uint32_t win32::make_scancode_win32(LPARAM lParam) {
+        uint32_t code = (lParam >> 16) & 0xff;
+        bool extended = (lParam & (1 << 24)) != 0;
+
+        if (!extended) {
+            // Set 1 scancodes and evdev codes are the same for the original keyboard, except that Pause arrives
+            // as the Num Lock code (it is sent with an E1 prefix Windows doesn't flag)
+            if (code == 0x45) return 119;
+            return code <= 0x58 ? code : 0;
+        }
+
+        switch (code) {
+            case 0x1c: return 96;  // keypad enter
+            case 0x1d: return 97;  // right control
+            case 0x35: return 98;  // keypad divide
+            case 0x37: return 99;  // print screen
+            case 0x38: return 100; // right alt
+            case 0x45: return 69;  // num lock
+            case 0x47: return 102; // home
+            case 0x48: return 103; // up
+            case 0x49: return 104; // page up
+            case 0x4b: return 105; // left
+            case 0x4d: return 106; // right
+            case 0x4f: return 107; // end
+            case 0x50: return 108; // down
+            case 0x51: return 109; // page down
+            case 0x52: return 110; // insert
+            case 0x53: return 111; // delete
+            case 0x5b: return 125; // left windows
+            case 0x5c: return 126; // right windows
+            case 0x5d: return 127; // menu
+            default: return 0;
+        }
     }
 
-    win32::window_win32::window_win32(const std::shared_ptr<kat::window::windowing_engine> &engine,
-                                      const std::string_view title, const glm::uvec2 &size, const glm::ivec2 &position) : m_windowing_engine(engine) {
-        m_hwnd = CreateWindowExA(WS_EX_OVERLAPPEDWINDOW, wc_name, title.data(), WS_OVERLAPPEDWINDOW, position.x, position.y, size.x, size.y, nullptr, nullptr /* TODO: maybe support idk */, engine->platform->m_instance, this);
+    win32::window_win32::window_win32(kat::window::windowing_engine &engine,
+                                      const std::string_view title, const glm::uvec2 &size, const glm::ivec2 &position) : m_windowing_engine(&engine) {
+        KAT_PROFILE_ZONE("window_win32::window_win32");
+        m_hwnd = CreateWindowExA(WS_EX_OVERLAPPEDWINDOW, wc_name, title.data(), WS_OVERLAPPEDWINDOW, position.x, position.y, size.x, size.y, nullptr, nullptr /* TODO: maybe support idk */, engine.platform_as<engine_state_win32>()->m_instance, this);
         ShowWindow(m_hwnd, SW_NORMAL);
     }
 
     win32::window_win32::~window_win32() {
+        // WM_DESTROY and friends are sent synchronously, don't let them reach a half-destroyed object
+        SetWindowLongPtrA(m_hwnd, GWLP_USERDATA, 0);
         DestroyWindow(m_hwnd);
     }
 
@@ -355,14 +485,111 @@ namespace kat::window {
         return m_hwnd;
     }
 
+    uint64_t win32::window_win32::native_handle() const {
+        return reinterpret_cast<uintptr_t>(m_hwnd);
+    }
+
     LRESULT win32::window_win32::window_proc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
+        auto& events = m_windowing_engine->platform_as<engine_state_win32>()->events();
+        auto handle = reinterpret_cast<uint64_t>(hWnd);
+
         switch (uMsg) {
-            case WM_CLOSE:
-                DestroyWindow(hWnd);
+            case WM_KEYDOWN:
+            case WM_SYSKEYDOWN:
+            case WM_KEYUP:
+            case WM_SYSKEYUP: {
+                bool down = uMsg == WM_KEYDOWN || uMsg == WM_SYSKEYDOWN;
+                auto ev = make_event(down ? event_type::key_down : event_type::key_up, handle);
+                ev.key.scancode = make_scancode_win32(lParam);
+                ev.key.keycode = static_cast<uint32_t>(wParam);
+                ev.key.modifiers = make_key_modifiers_win32();
+                ev.key.repeat = down && (lParam & (1 << 30));
+                events.push(ev);
+                break;
+            }
+            case WM_MOUSEMOVE: {
+                auto ev = make_event(event_type::mouse_move, handle);
+                ev.mouse_move.x = GET_X_LPARAM(lParam);
+                ev.mouse_move.y = GET_Y_LPARAM(lParam);
+                events.push(ev);
+                break;
+            }
+            case WM_LBUTTONDOWN:
+            case WM_LBUTTONUP:
+            case WM_RBUTTONDOWN:
+            case WM_RBUTTONUP:
+            case WM_MBUTTONDOWN:
+            case WM_MBUTTONUP:
+            case WM_XBUTTONDOWN:
+            case WM_XBUTTONUP: {
+                bool down = uMsg == WM_LBUTTONDOWN || uMsg == WM_RBUTTONDOWN || uMsg == WM_MBUTTONDOWN || uMsg == WM_XBUTTONDOWN;
+                auto ev = make_event(down ? event_type::mouse_button_down : event_type::mouse_button_up, handle);
+                switch (uMsg) {
+                    case WM_LBUTTONDOWN: case WM_LBUTTONUP: ev.mouse_button.button = mouse_button::left; break;
+                    case WM_RBUTTONDOWN: case WM_RBUTTONUP: ev.mouse_button.button = mouse_button::right; break;
+                    case WM_MBUTTONDOWN: case WM_MBUTTONUP: ev.mouse_button.button = mouse_button::middle; break;
+                    default: ev.mouse_button.button = GET_XBUTTON_WPARAM(wParam) == XBUTTON1 ? mouse_button::x1 : mouse_button::x2; break;
+                }
+                ev.mouse_button.x = GET_X_LPARAM(lParam);
+                ev.mouse_button.y = GET_Y_LPARAM(lParam);
+                events.push(ev);
+                break;
+            }
+            case WM_MOUSEWHEEL:
+            case WM_MOUSEHWHEEL: {
+                auto ev = make_event(event_type::mouse_scroll, handle);
+                float delta = static_cast<float>(GET_WHEEL_DELTA_WPARAM(wParam)) / WHEEL_DELTA;
+                ev.mouse_scroll.x = uMsg == WM_MOUSEHWHEEL ? delta : 0.f;
+                ev.mouse_scroll.y = uMsg == WM_MOUSEWHEEL ? delta : 0.f;
+                events.push(ev);
+                break;
+            }
+            case WM_SIZE: {
+                auto ev = make_event(event_type::resize, handle);
+                ev.resize.width = LOWORD(lParam);
+                ev.resize.height = HIWORD(lParam);
+                events.push(ev);
+                break;
+            }
+            case WM_MOVE: {
+                auto ev = make_event(event_type::move, handle);
+                ev.move.x = GET_X_LPARAM(lParam);
+                ev.move.y = GET_Y_LPARAM(lParam);
+                events.push(ev);
+                break;
+            }
+            case WM_SETFOCUS:
+                events.push(make_event(event_type::focus_gained, handle));
+                break;
+            case WM_KILLFOCUS:
+                events.push(make_event(event_type::focus_lost, handle));
                 break;
-            case WM_DESTROY:
-                PostQuitMessage(0);
+            case WM_DPICHANGED: {
+                auto ev = make_event(event_type::dpi_changed, handle);
+                ev.dpi.x = LOWORD(wParam);
+                ev.dpi.y = HIWORD(wParam);
+                events.push(ev);
+
+                auto* suggested = reinterpret_cast<RECT*>(lParam);
+                SetWindowPos(hWnd, nullptr, suggested->left, suggested->top, suggested->right - suggested->left, suggested->bottom - suggested->top, SWP_NOZORDER | SWP_NOACTIVATE);
+                return 0;
+            }
+            case WM_DISPLAYCHANGE: {
+                // Win32 doesn't say which display changed, so the monitor list is rebuilt on next use
+                m_windowing_engine->platform_as<engine_state_win32>()->m_monitors_enumerated = false;
+                m_windowing_engine->platform_as<engine_state_win32>()->m_monitors_generation++;
+                auto ev = make_event(event_type::monitor_changed, 0);
+                ev.monitor.monitor = 0;
+                ev.monitor.change = monitor_change::configuration;
+                events.push(ev);
                 break;
+            }
+            case WM_CLOSE:
+                // the window belongs to the engine, it goes away when the game destroys it
+                events.push(make_event(event_type::close_requested, handle));
+                m_windowing_engine->platform_as<engine_state_win32>()->m_app_exit = true;
+                SPDLOG_INFO("Exit");
+                return 0;
         }
 
         return DefWindowProcA(hWnd, uMsg, wParam, lParam);
@@ -1,8 +1,11 @@
 #pragma once
 #include "kat/cfg.hpp"
 #include "kat/window/utils.hpp"
+#include "kat/window/events.hpp"
+#include "kat/window/platform.hpp"
 #include <vector>
 #include <memory>
+#include <span>
 #include <glm/glm.hpp>
 #include <string_view>
 #include <string>
@@ -23,39 +26,55 @@ namespace kat::window {
 
     namespace win32 {
         class monitor_win32;
+        class window_win32;
 
-        struct engine_state_win32 {
-            std::vector<std::shared_ptr<monitor_win32>> m_monitors;
+        struct engine_state_win32 final : public platform_state_base<window_win32> {
+            mutable std::vector<std::shared_ptr<monitor_win32>> m_monitors;
+            mutable bool m_monitors_enumerated = false;
+            mutable uint64_t m_monitors_generation = 0;
+            std::weak_ptr<windowing_engine> m_engine;
             HINSTANCE m_instance;
 
-            engine_state_win32();
+            explicit engine_state_win32(const windowing_engine_config& config);
 
-            [[nodiscard]] std::vector<std::shared_ptr<monitor_win32>> monitors() const;
-            void setup(const std::shared_ptr<windowing_engine>& engine);
+            [[nodiscard]] std::vector<std::shared_ptr<monitor>> monitors() const override;
+            [[nodiscard]] uint64_t monitors_generation() const override;
+            void setup(const std::shared_ptr<windowing_engine>& engine) override;
 
-            void process_events();
-            bool is_app_exit() const;
+            void process_events() override;
 
-            bool m_app_exit = false;
         };
 
-        class monitor_win32 {
+        uint16_t make_key_modifiers_win32();
+
+        /**
+         * The scancode in a WM_KEY* lParam, translated to the evdev code every platform reports.
+         */
+        uint32_t make_scancode_win32(LPARAM lParam);
+
+        class monitor_win32 final : public ::kat::window::monitor {
         public:
             monitor_win32(const DISPLAY_DEVICE &adapter, const DISPLAY_DEVICE &display, const std::shared_ptr<windowing_engine>& engine);
 
-            [[nodiscard]] glm::vec2 dpi() const;
-            [[nodiscard]] glm::vec2 scale() const;
+            [[nodiscard]] glm::vec2 dpi() const override;
+            [[nodiscard]] glm::vec2 scale() const override;
+
+            [[nodiscard]] glm::uvec2 physical_size() const override;
+            [[nodiscard]] glm::uvec2 size() const override;
+            [[nodiscard]] glm::ivec2 position() const override;
 
-            [[nodiscard]] glm::uvec2 physical_size() const;
-            [[nodiscard]] glm::uvec2 size() const;
-            [[nodiscard]] glm::ivec2 position() const;
+            [[nodiscard]] std::string_view name() const override;
 
-            [[nodiscard]] std::string_view name() const;
+            [[nodiscard]] bool is_primary() const override;
 
-            [[nodiscard]] bool is_primary() const;
+            [[nodiscard]] kat::window::video_mode video_mode() const override;
+            /**
+             * Sorted and deduplicated once at enumeration, see sort_video_modes().
+             */
+            [[nodiscard]] std::span<const kat::window::video_mode> video_modes() const override;
+            [[nodiscard]] const kat::window::video_mode* closest_video_mode(const video_mode_request& request) const override;
 
-            [[nodiscard]] kat::window::video_mode video_mode() const;
-            [[nodiscard]] std::vector<kat::window::video_mode> video_modes() const;
+            [[nodiscard]] uint64_t id() const override;
 
         private:
 
@@ -66,7 +85,6 @@ namespace kat::window {
             bool m_is_primary;
             glm::uvec2 m_dpi;
 
-            std::shared_ptr<windowing_engine> m_windowing_engine;
             window::video_mode m_video_mode;
 
             std::string m_display_name, m_adapter_name;
@@ -74,51 +92,51 @@ namespace kat::window {
 
         };
 
-        class window_win32 {
+        class window_win32 final : public ::kat::window::window {
         public:
 
-            window_win32(const std::shared_ptr<kat::window::windowing_engine>& engine, std::string_view title, const glm::uvec2 &size, const glm::ivec2 &position);
+            /**
+             * Use windowing_engine::create_window(), the engine owns its windows and destroys them before itself.
+             */
+            window_win32(kat::window::windowing_engine& engine, std::string_view title, const glm::uvec2 &size, const glm::ivec2 &position);
             ~window_win32();
 
-            [[nodiscard]] std::string title() const;
-            void title(std::string_view new_title);
+            [[nodiscard]] std::string title() const override;
+            void title(std::string_view new_title) override;
 
-            [[nodiscard]] glm::vec2 dpi() const;
-            [[nodiscard]] glm::vec2 scale() const;
+            [[nodiscard]] glm::vec2 dpi() const override;
+            [[nodiscard]] glm::vec2 scale() const override;
 
-            [[nodiscard]] glm::uvec2 size() const;
-            [[nodiscard]] glm::ivec2 position() const;
+            [[nodiscard]] glm::uvec2 size() const override;
+            [[nodiscard]] glm::ivec2 position() const override;
 
-            void size(glm::uvec2 new_size);
-            void position(glm::ivec2 new_position);
+            void size(glm::uvec2 new_size) override;
+            void position(glm::ivec2 new_position) override;
 
-            [[nodiscard]] bool decorated() const;
-            void decorated(bool new_mode);
+            [[nodiscard]] bool decorated() const override;
+            void decorated(bool new_mode) override;
 
-            void restore();
-            void maximize();
-            void minimize();
+            void restore() override;
+            void maximize() override;
+            void minimize() override;
 
-            void show();
-            void hide();
+            void show() override;
+            void hide() override;
 
             [[nodiscard]] HWND platform_handle() const;
+            [[nodiscard]] uint64_t native_handle() const override;
 
             LRESULT window_proc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
 
         private:
-            std::shared_ptr<kat::window::windowing_engine> m_windowing_engine;
+            kat::window::windowing_engine* m_windowing_engine;
             HMENU m_menu = nullptr;
             HWND m_hwnd;
             bool m_decorated = true;
         };
-    }
-
 
-    using platform_state = win32::engine_state_win32;
-    using monitor = win32::monitor_win32;
-    using window = win32::window_win32;
-    std::vector<std::shared_ptr<monitor>> get_all_monitors(const std::shared_ptr<windowing_engine>& engine);
+        std::vector<std::shared_ptr<monitor_win32>> get_all_monitors_win32(const std::shared_ptr<windowing_engine>& engine);
+    }
 }
 
 #endif
\ No newline at end of file
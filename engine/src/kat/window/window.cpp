@@ -1,25 +1,140 @@
 #include "kat/window/window.hpp"
 #include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cstring>
 
 namespace kat::window {
-    windowing_engine::windowing_engine() : platform(new platform_state()) {
+    windowing_engine::windowing_engine(const windowing_engine_config& config) {
+        // in the body, m_backend's initializer would run after platform's and reset it
+        platform = connect_platform(config, m_backend).release();
     }
 
     windowing_engine::~windowing_engine() {
+        // windows talk to the platform on their way out
+        platform->destroy_windows();
         delete platform;
     }
 
+    const backend& windowing_engine::active_backend() const {
+        return *m_backend;
+    }
+
     std::vector<std::shared_ptr<monitor>> windowing_engine::monitors() const {
         return platform->monitors();
     }
 
+    std::span<const monitor_info> windowing_engine::monitor_infos() const {
+        // the first call always misses, which is also what triggers the platform's lazy enumeration
+        if (platform->monitors_generation() != m_monitor_generation) {
+            refresh_monitor_infos();
+        }
+
+        return m_monitor_infos;
+    }
+
+    std::span<const video_mode> windowing_engine::video_modes(const monitor_info &info) const {
+        return std::span<const video_mode>(m_monitor_modes).subspan(info.first_mode, info.mode_count);
+    }
+
+    const video_mode* windowing_engine::closest_video_mode(const monitor_info &info, const video_mode_request &request) const {
+        return find_closest_video_mode(video_modes(info), request);
+    }
+
+    void windowing_engine::refresh_monitor_infos() const {
+        auto all = platform->monitors();
+        // read after monitors(), enumerating bumps it
+        m_monitor_generation = platform->monitors_generation();
+
+        m_monitor_infos.clear();
+        m_monitor_modes.clear();
+        for (const auto& mon : all) {
+            monitor_info info{};
+            info.id = mon->id();
+            info.position = mon->position();
+            info.size = mon->size();
+            info.physical_size = mon->physical_size();
+            info.dpi = mon->dpi();
+            info.scale = mon->scale();
+            info.current_mode = mon->video_mode();
+            info.primary = mon->is_primary();
+
+            auto name = mon->name();
+            auto length = std::min(name.size(), monitor_info::max_name_length);
+            std::memcpy(info.name_storage, name.data(), length);
+            info.name_storage[length] = '\0';
+
+            auto modes = mon->video_modes();
+            info.first_mode = static_cast<uint32_t>(m_monitor_modes.size());
+            info.mode_count = static_cast<uint32_t>(modes.size());
+            m_monitor_modes.insert(m_monitor_modes.end(), modes.begin(), modes.end());
+
+            m_monitor_infos.push_back(info);
+        }
+    }
+
+    const monitor_info* windowing_engine::monitor_for(const window &w) const {
+        auto all = monitor_infos();
+
+        glm::ivec2 w_min = w.position();
+        glm::ivec2 w_max = w_min + glm::ivec2(w.size());
+
+        const monitor_info* best = nullptr;
+        int64_t best_area = 0;
+        for (const auto& mon : all) {
+            glm::ivec2 m_min = mon.position;
+            glm::ivec2 m_max = m_min + glm::ivec2(mon.size);
+
+            int64_t width = std::min(w_max.x, m_max.x) - std::max(w_min.x, m_min.x);
+            int64_t height = std::min(w_max.y, m_max.y) - std::max(w_min.y, m_min.y);
+            if (width > 0 && height > 0 && width * height > best_area) {
+                best_area = width * height;
+                best = &mon;
+            }
+        }
+
+        if (!best) {
+            for (const auto& mon : all) {
+                if (mon.primary || !best) best = &mon;
+            }
+        }
+
+        return best;
+    }
+
+    window_handle windowing_engine::create_window(std::string_view title, glm::uvec2 size, glm::ivec2 position) {
+        // a platform that never connected has nothing to create the window on
+        if (platform->is_app_exit()) return {};
+        return platform->create_window(*this, title, size, position);
+    }
+
+    void windowing_engine::destroy_window(window_handle handle) {
+        platform->destroy_window(handle);
+    }
+
+    window* windowing_engine::get_window(window_handle handle) const {
+        return platform->get_window(handle);
+    }
+
+    window* windowing_engine::find_window(uint64_t native) const {
+        return platform->find_window(native);
+    }
+
+    window_handle windowing_engine::find_window_handle(uint64_t native) const {
+        return platform->find_window_handle(native);
+    }
+
     void windowing_engine::process_events() const {
+        KAT_PROFILE_ZONE("windowing_engine::process_events");
         platform->process_events();
     }
 
     bool windowing_engine::is_app_exit() const {
         return platform->is_app_exit();
     }
+
+    bool windowing_engine::poll_event(event &out) const {
+        return platform->events().poll(out);
+    }
 }
 
 
@@ -1,25 +1,100 @@
 #pragma once
 
 #include <memory>
+#include <span>
+#include <vector>
 #include "kat/cfg.hpp"
+#include "kat/window/events.hpp"
+#include "kat/core/profiler.hpp"
 #include <concepts>
 
+#include "kat/window/platform.hpp"
+#include "kat/window/backend.hpp"
+
+// Xlib's macros (None, Bool, Status...) would leak into the others, so it comes last
+#ifdef KATWINDOW_TARGET_WAYLAND
+#include "kat/window/wayland/platform_wayland.hpp"
+#endif
+#ifdef KATWINDOW_TARGET_XCB
+#include "kat/window/xcb/platform_xcb.hpp"
+#endif
+#ifdef KATWINDOW_TARGET_WIN32
+#include "kat/window/win32/platform_win32.hpp"
+#endif
+#ifdef KATWINDOW_TARGET_HEADLESS
+#include "kat/window/headless/platform_headless.hpp"
+#endif
 #ifdef KATWINDOW_TARGET_X11
 #include "kat/window/x11/platform_x11.hpp"
-#elif defined(KATWINDOW_TARGET_WIN32)
-#include "kat/window/win32/platform_win32.hpp"
 #endif
 
 namespace kat::window {
     struct windowing_engine : public std::enable_shared_from_this<windowing_engine> {
         kat::window::platform_state* platform;
 
+        /**
+         * The backend picked at startup, see backend.hpp.
+         */
+        [[nodiscard]] const backend& active_backend() const;
+
+        /**
+         * The platform as the concrete type of the running backend, for that backend's own code.
+         */
+        template<typename Platform>
+        [[nodiscard]] Platform* platform_as() const {
+            return static_cast<Platform*>(platform);
+        }
+
         [[nodiscard]] std::vector<std::shared_ptr<monitor>> monitors() const;
 
+        /**
+         * Snapshot of every monitor. Only rebuilt when the platform reports a change (hotplug, mode switch, DPI),
+         * otherwise this returns the same array without allocating. The span and anything pointing into it stay
+         * valid until the next process_events().
+         */
+        [[nodiscard]] std::span<const monitor_info> monitor_infos() const;
+
+        /**
+         * The modes of a monitor from monitor_infos(), same lifetime.
+         */
+        [[nodiscard]] std::span<const video_mode> video_modes(const monitor_info& info) const;
+
+        /**
+         * The mode of `info` closest to `request`, see find_closest_video_mode(). Same lifetime as video_modes().
+         */
+        [[nodiscard]] const video_mode* closest_video_mode(const monitor_info& info, const video_mode_request& request) const;
+
+        /**
+         * The monitor covering most of `w`, or the primary monitor if it isn't on any. Null if there are no monitors.
+         * Points into monitor_infos().
+         */
+        [[nodiscard]] const monitor_info* monitor_for(const window& w) const;
+
+        /**
+         * Creates a window owned by the engine. It lives until destroy_window() or until the engine is destroyed,
+         * whichever comes first. Returns an invalid handle once is_app_exit() is set, which includes when no backend
+         * could connect.
+         */
+        window_handle create_window(std::string_view title, glm::uvec2 size, glm::ivec2 position);
+        void destroy_window(window_handle handle);
+
+        /**
+         * Null once the window has been destroyed.
+         */
+        [[nodiscard]] window* get_window(window_handle handle) const;
+
+        /**
+         * The window an event belongs to, by event::window. Null for events that don't belong to one of ours, or
+         * that were queued before their window was destroyed.
+         */
+        [[nodiscard]] window* find_window(uint64_t native) const;
+        [[nodiscard]] window_handle find_window_handle(uint64_t native) const;
+
         ~windowing_engine();
 
-        [[nodiscard]] static inline std::shared_ptr<windowing_engine> create() {
-            auto sp = std::shared_ptr<windowing_engine>(new windowing_engine());
+        [[nodiscard]] static inline std::shared_ptr<windowing_engine> create(const windowing_engine_config& config = {}) {
+            KAT_PROFILE_ZONE("windowing_engine::create");
+            auto sp = std::shared_ptr<windowing_engine>(new windowing_engine(config));
             sp->platform->setup(sp);
             return sp;
         };
@@ -28,29 +103,28 @@ namespace kat::window {
 
         bool is_app_exit() const;
 
+        /**
+         * Pops the oldest pending event into `out`. Returns false once the queue is empty.
+         * Events are collected by process_events(); polling never allocates or talks to the platform.
+         */
+        bool poll_event(event& out) const;
+
     private:
-        explicit windowing_engine();
+        explicit windowing_engine(const windowing_engine_config& config);
 
+        void refresh_monitor_infos() const;
+
+        const backend* m_backend = nullptr;
+        mutable std::vector<monitor_info> m_monitor_infos;
+        mutable std::vector<video_mode> m_monitor_modes;
+        mutable uint64_t m_monitor_generation = ~0ull;
     };
 
 
-    /**
-     * Monitor Interface API
-     *
-     * The monitor type for the target platform **must** implement:
-     * - glm::vec2 dpi() const
-     * - glm::vec2 scale() const
-     * - glm::uvec2 physical_size() const
-     * - glm::uvec2 size() const
-     * - std::string_view name() const
-     * - bool is_primary() const
-     * - video_mode video_mode() const
-     * - std::vector<video_mode> video_modes()
-     */
 #ifdef KAT_PLATFORM_VERIFYINTERFACES
     namespace {
         template<typename T>
-        concept is_monitor = requires(const T &value) {
+        concept is_monitor = std::derived_from<T, monitor> && requires(const T &value) {
             { value.dpi() } -> std::same_as<glm::vec2>;
             { value.scale() } -> std::same_as<glm::vec2>;
             { value.position() } -> std::same_as<glm::ivec2>;
@@ -59,17 +133,20 @@ namespace kat::window {
             { value.name() } -> std::same_as<std::string_view>;
             { value.is_primary() } -> std::same_as<bool>;
             { value.video_mode() } -> std::same_as<::kat::window::video_mode>;
-            { value.video_modes() } -> std::same_as<std::vector<::kat::window::video_mode>>;
+            { value.video_modes() } -> std::same_as<std::span<const ::kat::window::video_mode>>;
+            { value.closest_video_mode(video_mode_request{}) } -> std::same_as<const ::kat::window::video_mode*>;
+            { value.id() } -> std::same_as<uint64_t>;
         };
 
         template<typename T>
-        concept is_window = requires(const T &value) {
+        concept is_window = std::derived_from<T, window> && std::constructible_from<T, windowing_engine&, std::string_view, glm::uvec2, glm::ivec2> && requires(const T &value) {
             { value.dpi() } -> std::same_as<glm::vec2>;
             { value.scale() } -> std::same_as<glm::vec2>;
             { value.position() } -> std::same_as<glm::ivec2>;
             { value.size() } -> std::same_as<glm::uvec2>;
             { value.title() } -> std::same_as<std::string>;
             { value.decorated() } -> std::same_as<bool>;
+            { value.native_handle() } -> std::same_as<uint64_t>;
         } && requires(T& value, glm::uvec2 new_uvec2, glm::ivec2 new_ivec2, std::string_view new_string, bool new_bool) {
             { value.size(new_uvec2) } -> std::same_as<void>;
             { value.position(new_ivec2) } -> std::same_as<void>;
@@ -82,18 +159,39 @@ namespace kat::window {
             { value.hide() } -> std::same_as<void>;
         };
 
-        template<typename T>
-        concept is_platform_state = requires(T& value, const std::shared_ptr<windowing_engine>& engine) {
+        template<typename T, typename Window>
+        concept is_platform_state = std::derived_from<T, platform_state> && std::constructible_from<T, const windowing_engine_config&>
+                && requires(T& value, const std::shared_ptr<windowing_engine>& engine) {
             { value.setup(engine) } -> std::same_as<void>;
             { value.process_events() } -> std::same_as<void>;
+            { value.events() } -> std::same_as<event_queue&>;
+            { value.windows() } -> std::same_as<window_registry<Window>&>;
         } && requires(const T& value) {
             { value.monitors() } -> std::same_as<std::vector<std::shared_ptr<monitor>>>;
             { value.is_app_exit() } -> std::same_as<bool>;
+            { value.monitors_generation() } -> std::same_as<uint64_t>;
         };
 
-        static_assert(is_monitor<monitor>, "monitor interface not implemented correctly.");
-        static_assert(is_window<window>, "window interface not implemented correctly.");
-        static_assert(is_platform_state<platform_state>, "platform_state interface not implemented correctly.");
+        // final, so backend code calling its own types never goes through the vtable
+        template<typename Platform, typename Monitor, typename Window>
+        constexpr bool is_backend = is_platform_state<Platform, Window> && is_monitor<Monitor> && is_window<Window>
+                && std::is_final_v<Platform> && std::is_final_v<Monitor> && std::is_final_v<Window>;
+
+#ifdef KATWINDOW_TARGET_X11
+        static_assert(is_backend<x11::engine_state_x11, x11::monitor_x11, x11::window_x11>, "x11 backend doesn't implement the platform interface.");
+#endif
+#ifdef KATWINDOW_TARGET_XCB
+        static_assert(is_backend<xcb::engine_state_xcb, xcb::monitor_xcb, xcb::window_xcb>, "xcb backend doesn't implement the platform interface.");
+#endif
+#ifdef KATWINDOW_TARGET_WAYLAND
+        static_assert(is_backend<wayland::engine_state_wayland, wayland::monitor_wayland, wayland::window_wayland>, "wayland backend doesn't implement the platform interface.");
+#endif
+#ifdef KATWINDOW_TARGET_WIN32
+        static_assert(is_backend<win32::engine_state_win32, win32::monitor_win32, win32::window_win32>, "win32 backend doesn't implement the platform interface.");
+#endif
+#ifdef KATWINDOW_TARGET_HEADLESS
+        static_assert(is_backend<headless::engine_state_headless, headless::monitor_headless, headless::window_headless>, "headless backend doesn't implement the platform interface.");
+#endif
     }
 #endif
 }
\ No newline at end of file
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace kat::window {
+    /**
+     * Refers to a window owned by the windowing engine. Destroying the window bumps its slot's generation, so a
+     * handle kept around afterwards looks the window up as null instead of finding whatever reused the slot.
+     */
+    struct window_handle {
+        uint32_t index = ~0u;
+        uint32_t generation = 0;
+
+        [[nodiscard]] explicit operator bool() const noexcept { return index != ~0u; }
+        bool operator==(const window_handle& rhs) const noexcept = default;
+    };
+
+    /**
+     * Owns the windows of one windowing engine.
+     *
+     * Windows live in a slot pool addressed by window_handle. Next to it sits an open-addressing hash table from
+     * native handle (what event::window carries) to slot, so routing an event to its window is one hash and
+     * usually one probe however many windows are open. Native handle 0 is never a real window on any platform and
+     * marks empty buckets.
+     */
+    template<typename Window>
+    class window_registry {
+    public:
+        window_registry() = default;
+        ~window_registry() { clear(); }
+
+        window_registry(const window_registry&) = delete;
+        window_registry& operator=(const window_registry&) = delete;
+
+        /**
+         * Takes ownership of `window`. A native handle of 0 or one that is already registered can't be told apart
+         * from an empty bucket or the window that has it, so the window is dropped and an invalid handle returned.
+         */
+        window_handle insert(uint64_t native, std::unique_ptr<Window> window) {
+            if (native == 0 || lookup(native) != ~0u) return {};
+
+            uint32_t index;
+            if (!m_free.empty()) {
+                index = m_free.back();
+                m_free.pop_back();
+            } else {
+                index = static_cast<uint32_t>(m_slots.size());
+                m_slots.emplace_back();
+            }
+
+            auto& slot = m_slots[index];
+            slot.window = std::move(window);
+            slot.native = native;
+
+            if ((m_count + 1) * 2 > m_buckets.size()) {
+                rehash(m_buckets.empty() ? 16 : m_buckets.size() * 2);
+            }
+            place(native, index);
+            m_count++;
+
+            return { index, slot.generation };
+        }
+
+        /**
+         * Destroys the window. Does nothing for a stale handle.
+         */
+        void erase(window_handle handle) {
+            auto* slot = live_slot(handle);
+            if (!slot) return;
+
+            remove(slot->native);
+            m_count--;
+
+            // unlinked before it's destroyed, so a destructor that calls back into the registry sees it gone
+            auto window = std::move(slot->window);
+            slot->native = 0;
+            slot->generation++;
+            m_free.push_back(handle.index);
+            window.reset();
+        }
+
+        void clear() {
+            for (uint32_t i = 0 ; i < m_slots.size() ; i++) {
+                if (m_slots[i].window) {
+                    erase({ i, m_slots[i].generation });
+                }
+            }
+        }
+
+        [[nodiscard]] Window* get(window_handle handle) const noexcept {
+            auto* slot = live_slot(handle);
+            return slot ? slot->window.get() : nullptr;
+        }
+
+        [[nodiscard]] Window* find(uint64_t native) const noexcept {
+            auto index = lookup(native);
+            return index == ~0u ? nullptr : m_slots[index].window.get();
+        }
+
+        [[nodiscard]] window_handle handle_of(uint64_t native) const noexcept {
+            auto index = lookup(native);
+            return index == ~0u ? window_handle{} : window_handle{ index, m_slots[index].generation };
+        }
+
+        [[nodiscard]] std::size_t size() const noexcept { return m_count; }
+
+    private:
+        struct slot {
+            std::unique_ptr<Window> window;
+            uint64_t native = 0;
+            uint32_t generation = 0;
+        };
+
+        struct bucket {
+            uint64_t native = 0;
+            uint32_t index = 0;
+        };
+
+        [[nodiscard]] const slot* live_slot(window_handle handle) const noexcept {
+            if (handle.index >= m_slots.size()) return nullptr;
+            const auto& s = m_slots[handle.index];
+            return s.window && s.generation == handle.generation ? &s : nullptr;
+        }
+
+        [[nodiscard]] slot* live_slot(window_handle handle) noexcept {
+            return const_cast<slot*>(std::as_const(*this).live_slot(handle));
+        }
+
+        // X ids and HWNDs are sequential or pointer-aligned, Fibonacci hashing spreads them over the top bits
+        [[nodiscard]] std::size_t home(uint64_t native) const noexcept {
+            return static_cast<std::size_t>((native * 0x9e3779b97f4a7c15ull) >> m_shift);
+        }
+
+        [[nodiscard]] uint32_t lookup(uint64_t native) const noexcept {
+            if (native == 0 || m_buckets.empty()) return ~0u;
+
+            std::size_t mask = m_buckets.size() - 1;
+            for (std::size_t i = home(native) ; m_buckets[i].native != 0 ; i = (i + 1) & mask) {
+                if (m_buckets[i].native == native) return m_buckets[i].index;
+            }
+            return ~0u;
+        }
+
+        void place(uint64_t native, uint32_t index) noexcept {
+            std::size_t mask = m_buckets.size() - 1;
+            std::size_t i = home(native);
+            while (m_buckets[i].native != 0 && m_buckets[i].native != native) {
+                i = (i + 1) & mask;
+            }
+            m_buckets[i] = { native, index };
+        }
+
+        void remove(uint64_t native) noexcept {
+            if (m_buckets.empty()) return;
+
+            std::size_t mask = m_buckets.size() - 1;
+            std::size_t hole = home(native);
+            while (m_buckets[hole].native != native) {
+                if (m_buckets[hole].native == 0) return;
+                hole = (hole + 1) & mask;
+            }
+
+            // backward shift instead of tombstones, so lookups never have to walk over dead buckets
+            for (std::size_t i = (hole + 1) & mask ; m_buckets[i].native != 0 ; i = (i + 1) & mask) {
+                std::size_t h = home(m_buckets[i].native);
+                if (((i - h) & mask) >= ((i - hole) & mask)) {
+                    m_buckets[hole] = m_buckets[i];
+                    hole = i;
+                }
+            }
+            m_buckets[hole] = {};
+        }
+
+        void rehash(std::size_t bucket_count) {
+            m_buckets.assign(bucket_count, {});
+            m_shift = 64;
+            for (std::size_t n = bucket_count ; n > 1 ; n >>= 1) m_shift--;
+
+            for (uint32_t i = 0 ; i < m_slots.size() ; i++) {
+                if (m_slots[i].window) {
+                    place(m_slots[i].native, i);
+                }
+            }
+        }
+
+        std::vector<slot> m_slots;
+        std::vector<uint32_t> m_free;
+        std::vector<bucket> m_buckets;
+        std::size_t m_count = 0;
+        int m_shift = 64;
+    };
+}
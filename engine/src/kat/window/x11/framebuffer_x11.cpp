@@ -0,0 +1,203 @@
+#include "kat/cfg.hpp"
+#ifdef KATWINDOW_TARGET_X11
+#include "framebuffer_x11.hpp"
+#include "kat/window/window.hpp"
+#include <spdlog/spdlog.h>
+#include <X11/Xlib-xcb.h>
+#include <xcb/shm.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <cstdlib>
+
+namespace kat::window::x11 {
+    namespace {
+        bool serial_processed(Display* display, unsigned long serial) {
+            return static_cast<long>(LastKnownRequestProcessed(display) - serial) >= 0;
+        }
+    }
+
+    framebuffer_x11::framebuffer_x11(const std::shared_ptr<windowing_engine> &engine, const window_x11 &window) : framebuffer_x11(engine, window, window.size()) {
+    }
+
+    framebuffer_x11::framebuffer_x11(const std::shared_ptr<windowing_engine> &engine, const window_x11 &window, glm::uvec2 size_) : m_windowing_engine(engine), m_size(size_) {
+        m_display = engine->platform_as<engine_state_x11>()->display;
+        m_window = window.platform_handle();
+        m_gc = XCreateGC(m_display, m_window, 0, nullptr);
+        m_use_shm = XShmQueryExtension(m_display);
+
+        create_buffers();
+    }
+
+    framebuffer_x11::~framebuffer_x11() {
+        destroy_buffers();
+        XFreeGC(m_display, m_gc);
+    }
+
+    std::span<uint32_t> framebuffer_x11::pixels() {
+        auto& buf = m_buffers[m_back];
+        if (!buf.image) return {};
+
+        wait_for(buf);
+        return { reinterpret_cast<uint32_t*>(buf.image->data), static_cast<std::size_t>(buf.image->bytes_per_line / 4) * m_size.y };
+    }
+
+    uint32_t framebuffer_x11::stride() const {
+        const auto* image = m_buffers[m_back].image;
+        return image ? image->bytes_per_line / 4 : 0;
+    }
+
+    glm::uvec2 framebuffer_x11::size() const {
+        return m_size;
+    }
+
+    void framebuffer_x11::resize(glm::uvec2 new_size) {
+        if (new_size == m_size) return;
+
+        destroy_buffers();
+        m_size = new_size;
+        create_buffers();
+    }
+
+    void framebuffer_x11::present() {
+        auto& buf = m_buffers[m_back];
+        if (!buf.image) return;
+
+        if (m_use_shm) {
+            // Completion events let the pump advance Xlib's idea of the last processed request,
+            // which is how wait_for() knows the buffer is free again without a round trip.
+            buf.present_serial = NextRequest(m_display);
+            XShmPutImage(m_display, m_window, m_gc, buf.image, 0, 0, 0, 0, m_size.x, m_size.y, true);
+            buf.in_flight = true;
+        } else {
+            // XPutImage copies the pixels into the request before returning, so the buffer is reusable immediately
+            XPutImage(m_display, m_window, m_gc, buf.image, 0, 0, 0, 0, m_size.x, m_size.y);
+        }
+
+        XFlush(m_display);
+        m_back ^= 1;
+    }
+
+    bool framebuffer_x11::is_shared_memory() const {
+        return m_use_shm;
+    }
+
+    void framebuffer_x11::wait_for(buffer &buf) {
+        if (!buf.in_flight) return;
+
+        if (!serial_processed(m_display, buf.present_serial)) {
+            // non-blocking read first, the completion is usually already on the socket
+            XEventsQueued(m_display, QueuedAfterReading);
+            if (!serial_processed(m_display, buf.present_serial)) {
+                XSync(m_display, false);
+            }
+        }
+
+        buf.in_flight = false;
+    }
+
+    void framebuffer_x11::create_buffers() {
+        for (auto& buf : m_buffers) {
+            if (m_use_shm && !create_shm_buffer(buf)) {
+                SPDLOG_INFO("MIT-SHM unavailable, falling back to XPutImage");
+                m_use_shm = false;
+                // the other buffer may already be in shared memory, keep them consistent
+                destroy_buffers();
+                create_buffers();
+                return;
+            }
+
+            if (!m_use_shm && !create_plain_buffer(buf)) {
+                SPDLOG_ERROR("Can't allocate a {}x{} framebuffer, presenting nothing until the next resize", m_size.x, m_size.y);
+                destroy_buffers();
+                return;
+            }
+        }
+
+        if (m_buffers[0].image->bits_per_pixel != 32) {
+            SPDLOG_WARN("Framebuffer visual uses {} bits per pixel, expected 32", m_buffers[0].image->bits_per_pixel);
+        }
+
+        m_back = 0;
+        SPDLOG_DEBUG("Created {}x{} framebuffer ({})", m_size.x, m_size.y, m_use_shm ? "MIT-SHM" : "XPutImage");
+    }
+
+    void framebuffer_x11::destroy_buffers() {
+        for (auto& buf : m_buffers) {
+            if (!buf.image) continue;
+            wait_for(buf);
+
+            if (buf.shm.shmaddr) {
+                XShmDetach(m_display, &buf.shm);
+                buf.image->data = nullptr; // owned by the segment, not malloc
+                XDestroyImage(buf.image);
+                shmdt(buf.shm.shmaddr);
+            } else {
+                XDestroyImage(buf.image); // frees the malloc'd pixel data as well
+            }
+
+            buf = buffer{};
+        }
+    }
+
+    bool framebuffer_x11::create_shm_buffer(buffer &buf) {
+        Screen* screen = m_windowing_engine->platform_as<engine_state_x11>()->screen;
+        buf.image = XShmCreateImage(m_display, DefaultVisualOfScreen(screen), DefaultDepthOfScreen(screen), ZPixmap, nullptr, &buf.shm, m_size.x, m_size.y);
+        if (!buf.image) return false;
+
+        buf.shm.shmid = shmget(IPC_PRIVATE, static_cast<std::size_t>(buf.image->bytes_per_line) * buf.image->height, IPC_CREAT | 0600);
+        if (buf.shm.shmid < 0) {
+            XDestroyImage(buf.image);
+            buf = buffer{};
+            return false;
+        }
+
+        void* addr = shmat(buf.shm.shmid, nullptr, 0);
+        if (addr == reinterpret_cast<void*>(-1)) {
+            shmctl(buf.shm.shmid, IPC_RMID, nullptr);
+            XDestroyImage(buf.image);
+            buf = buffer{};
+            return false;
+        }
+
+        buf.shm.shmaddr = buf.image->data = static_cast<char*>(addr);
+        buf.shm.readOnly = false;
+
+        // Attaching fails asynchronously on remote displays even though the extension is advertised. Sent as a
+        // checked request through Xlib's own XCB connection the error comes back to us alone, instead of going to
+        // the process-wide Xlib error handler that the event thread may be relying on at the same time.
+        auto* connection = XGetXCBConnection(m_display);
+        buf.shm.shmseg = xcb_generate_id(connection);
+        auto cookie = xcb_shm_attach_checked(connection, buf.shm.shmseg, buf.shm.shmid, buf.shm.readOnly);
+        xcb_generic_error_t* error = xcb_request_check(connection, cookie);
+        bool attach_failed = error != nullptr;
+        std::free(error);
+
+        // marked for removal now, the segment lives until both sides detach
+        shmctl(buf.shm.shmid, IPC_RMID, nullptr);
+
+        if (attach_failed) {
+            buf.image->data = nullptr;
+            XDestroyImage(buf.image);
+            shmdt(buf.shm.shmaddr);
+            buf = buffer{};
+            return false;
+        }
+
+        return true;
+    }
+
+    bool framebuffer_x11::create_plain_buffer(buffer &buf) {
+        Screen* screen = m_windowing_engine->platform_as<engine_state_x11>()->screen;
+        buf.image = XCreateImage(m_display, DefaultVisualOfScreen(screen), DefaultDepthOfScreen(screen), ZPixmap, 0, nullptr, m_size.x, m_size.y, 32, 0);
+        if (!buf.image) return false;
+
+        buf.image->data = static_cast<char*>(std::calloc(static_cast<std::size_t>(buf.image->bytes_per_line) * buf.image->height, 1));
+        if (!buf.image->data) {
+            XDestroyImage(buf.image);
+            buf = buffer{};
+            return false;
+        }
+        return true;
+    }
+}
+#endif
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "kat/cfg.hpp"
+
+#ifdef KATWINDOW_TARGET_X11
+
+#include "kat/window/x11/platform_x11.hpp"
+
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <glm/glm.hpp>
+
+namespace kat::window::x11 {
+    /**
+     * CPU-side pixel surface presented to a window_x11.
+     *
+     * Pixels are 32-bit words in the visual's native layout (0xXXRRGGBB on every TrueColor visual we care about).
+     * Two buffers are kept so the game can fill frame N+1 while the server is still reading frame N. When the
+     * MIT-SHM extension is usable the buffers live in shared memory and presenting copies nothing through the socket;
+     * otherwise (remote displays, servers without SHM) they fall back to plain XPutImage.
+     */
+    class framebuffer_x11 {
+    public:
+        framebuffer_x11(const std::shared_ptr<windowing_engine>& engine, const window_x11& window);
+        framebuffer_x11(const std::shared_ptr<windowing_engine>& engine, const window_x11& window, glm::uvec2 size_);
+        ~framebuffer_x11();
+
+        framebuffer_x11(const framebuffer_x11&) = delete;
+        framebuffer_x11& operator=(const framebuffer_x11&) = delete;
+
+        /**
+         * The buffer the next present() will show. If the server hasn't finished reading it from an earlier
+         * present this waits until it has, which only happens when the game runs more than a frame ahead.
+         * Empty if the buffers couldn't be allocated, present() does nothing then.
+         */
+        [[nodiscard]] std::span<uint32_t> pixels();
+
+        /**
+         * Distance between rows of pixels(), in pixels.
+         */
+        [[nodiscard]] uint32_t stride() const;
+        [[nodiscard]] glm::uvec2 size() const;
+
+        /**
+         * Reallocates both buffers. Contents are lost.
+         */
+        void resize(glm::uvec2 new_size);
+
+        /**
+         * Queues the current back buffer for display and swaps buffers.
+         */
+        void present();
+
+        [[nodiscard]] bool is_shared_memory() const;
+
+    private:
+        struct buffer {
+            XImage* image = nullptr;
+            XShmSegmentInfo shm{};
+            unsigned long present_serial = 0;
+            bool in_flight = false;
+        };
+
+        void create_buffers();
+        void destroy_buffers();
+        bool create_shm_buffer(buffer& buf);
+        bool create_plain_buffer(buffer& buf);
+        void wait_for(buffer& buf);
+
+        std::shared_ptr<windowing_engine> m_windowing_engine;
+        Display* m_display;
+        Window m_window;
+        GC m_gc;
+
+        glm::uvec2 m_size;
+        buffer m_buffers[2];
+        uint32_t m_back = 0;
+        bool m_use_shm;
+    };
+}
+
+#endif
@@ -0,0 +1,309 @@
+#include "kat/cfg.hpp"
+#ifdef KATWINDOW_TARGET_X11
+#include "platform_x11.hpp"
+#include "kat/window/window.hpp"
+#include <spdlog/spdlog.h>
+#include <X11/Xproto.h>
+#include <X11/extensions/randrproto.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <unistd.h>
+
+namespace kat::window::x11 {
+    namespace {
+        // Plain fixed-size records so the crash path can read them without allocating or locking.
+        struct saved_crtc {
+            RRCrtc crtc;
+            RRMode mode;
+            int x, y;
+            Rotation rotation;
+            RROutput outputs[8];
+            int noutput;
+        };
+
+        constexpr int max_saved_crtcs = 16;
+        saved_crtc saved_crtcs[max_saved_crtcs];
+        std::atomic<int> saved_crtc_count = 0;
+
+        // A second connection that only the crash path talks to, opened while something is switched. Xlib can't be
+        // used from a signal handler (the engine's connection may hold its lock, and requests allocate), so the
+        // handler writes RandR requests built on its own stack straight to this socket.
+        Display* crash_display = nullptr;
+        std::atomic<int> crash_fd = -1;
+        CARD8 crash_randr_opcode = 0;
+        Window crash_root = None;
+
+        // Crashes only. SIGINT and SIGTERM are for the application to turn into a normal shutdown, which restores
+        // the modes from ~engine_state_x11.
+        constexpr int crash_signals[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT };
+        bool handlers_installed = false;
+
+        Status apply(Display* display, XRRScreenResources* resources, const saved_crtc& saved) {
+            return XRRSetCrtcConfig(display, resources, saved.crtc, CurrentTime, saved.x, saved.y, saved.mode, saved.rotation,
+                                    const_cast<RROutput*>(saved.outputs), saved.noutput);
+        }
+
+        bool write_all(int fd, const void* data, std::size_t size) {
+            auto* bytes = static_cast<const char*>(data);
+            while (size > 0) {
+                ssize_t written = write(fd, bytes, size);
+                if (written < 0 && errno == EINTR) continue;
+                if (written <= 0) return false;
+                bytes += written;
+                size -= static_cast<std::size_t>(written);
+            }
+            return true;
+        }
+
+        bool read_all(int fd, void* data, std::size_t size) {
+            auto* bytes = static_cast<char*>(data);
+            while (size > 0) {
+                ssize_t got = read(fd, bytes, size);
+                if (got < 0 && errno == EINTR) continue;
+                if (got <= 0) return false;
+                bytes += got;
+                size -= static_cast<std::size_t>(got);
+            }
+            return true;
+        }
+
+        /**
+         * Puts every saved crtc back over the crash connection using nothing but write() and read(), so it is safe
+         * from a signal handler. Only the crash connection's protocol stream is touched, which nothing else uses
+         * once it has been synced.
+         */
+        void restore_over_crash_connection() {
+            int fd = crash_fd.load();
+            if (fd < 0) return;
+            int count = saved_crtc_count.exchange(0);
+            if (count == 0) return;
+
+            // SetCrtcConfig is refused unless it carries the current config timestamp, which a hotplug since the
+            // switch may have changed, so ask for it first
+            xRRGetScreenResourcesCurrentReq query{};
+            query.reqType = crash_randr_opcode;
+            query.randrReqType = X_RRGetScreenResourcesCurrent;
+            query.length = sz_xRRGetScreenResourcesCurrentReq / 4;
+            query.window = static_cast<CARD32>(crash_root);
+            xRRGetScreenResourcesCurrentReply resources{};
+            if (!write_all(fd, &query, sz_xRRGetScreenResourcesCurrentReq) || !read_all(fd, &resources, sz_xRRGetScreenResourcesCurrentReply)) return;
+            if (resources.type != X_Reply) return;
+
+            char discard[256];
+            for (std::size_t left = resources.length * 4ull ; left > 0 ; ) {
+                std::size_t chunk = std::min(left, sizeof(discard));
+                if (!read_all(fd, discard, chunk)) return;
+                left -= chunk;
+            }
+
+            // the outputs follow the fixed part directly on the wire
+            static_assert(sizeof(xRRSetCrtcConfigReq) == sz_xRRSetCrtcConfigReq);
+            for (int i = 0 ; i < count ; i++) {
+                const saved_crtc& saved = saved_crtcs[i];
+                struct {
+                    xRRSetCrtcConfigReq header;
+                    CARD32 outputs[std::size(saved_crtc{}.outputs)];
+                } request{};
+                std::size_t size = sz_xRRSetCrtcConfigReq + 4 * static_cast<std::size_t>(saved.noutput);
+                request.header.reqType = crash_randr_opcode;
+                request.header.randrReqType = X_RRSetCrtcConfig;
+                request.header.length = static_cast<CARD16>(size / 4);
+                request.header.crtc = static_cast<CARD32>(saved.crtc);
+                request.header.timestamp = CurrentTime;
+                request.header.configTimestamp = resources.configTimestamp;
+                request.header.x = static_cast<INT16>(saved.x);
+                request.header.y = static_cast<INT16>(saved.y);
+                request.header.mode = static_cast<CARD32>(saved.mode);
+                request.header.rotation = saved.rotation;
+                for (int o = 0 ; o < saved.noutput ; o++) {
+                    request.outputs[o] = static_cast<CARD32>(saved.outputs[o]);
+                }
+                if (!write_all(fd, &request, size)) return;
+            }
+
+            // wait until the server has answered every request, so it has applied them before the process is gone
+            xRRSetCrtcConfigReply reply{};
+            for (int i = 0 ; i < count ; i++) {
+                if (!read_all(fd, &reply, sz_xRRSetCrtcConfigReply)) return;
+            }
+        }
+
+        void crash_signal_handler(int signal) {
+            restore_over_crash_connection();
+
+            // SA_RESETHAND put the default action back, let it kill the process
+            std::raise(signal);
+        }
+
+        void install_restore_handlers() {
+            if (handlers_installed) return;
+            handlers_installed = true;
+
+            std::atexit(restore_over_crash_connection);
+
+            struct sigaction action{};
+            action.sa_handler = crash_signal_handler;
+            action.sa_flags = SA_RESETHAND;
+            sigemptyset(&action.sa_mask);
+            for (int signal : crash_signals) {
+                // an application that ignores or handles the signal itself keeps it
+                struct sigaction previous{};
+                sigaction(signal, nullptr, &previous);
+                if ((previous.sa_flags & SA_SIGINFO) || previous.sa_handler != SIG_DFL) continue;
+                sigaction(signal, &action, nullptr);
+            }
+        }
+
+        /**
+         * Opens the crash connection. Everything the handler needs from Xlib is fetched here, after which the
+         * connection is synced and never used through Xlib again until it is closed.
+         */
+        bool open_crash_connection(Display* display) {
+            if (crash_display) return true;
+
+            int opcode = 0, event_base = 0, error_base = 0;
+            if (!XQueryExtension(display, RANDR_NAME, &opcode, &event_base, &error_base)) return false;
+
+            crash_display = XOpenDisplay(DisplayString(display));
+            if (!crash_display) {
+                SPDLOG_WARN("Couldn't open the connection that restores modes after a crash, not switching");
+                return false;
+            }
+
+            crash_randr_opcode = static_cast<CARD8>(opcode);
+            crash_root = DefaultRootWindow(crash_display);
+            XSync(crash_display, false);
+            crash_fd.store(ConnectionNumber(crash_display));
+            install_restore_handlers();
+            return true;
+        }
+
+        void close_crash_connection() {
+            if (!crash_display) return;
+            crash_fd.store(-1);
+            XCloseDisplay(crash_display);
+            crash_display = nullptr;
+        }
+
+        saved_crtc* find_saved(RRCrtc crtc) {
+            auto* end = saved_crtcs + saved_crtc_count.load();
+            auto* it = std::find_if(saved_crtcs, end, [crtc](const saved_crtc& s) { return s.crtc == crtc; });
+            return it == end ? nullptr : it;
+        }
+
+        void forget_saved(saved_crtc* saved) {
+            int count = saved_crtc_count.load();
+            *saved = saved_crtcs[count - 1];
+            saved_crtc_count.store(count - 1);
+            if (count == 1) {
+                close_crash_connection();
+            }
+        }
+    }
+
+    bool engine_state_x11::switch_mode(const monitor_x11 &monitor, const ::kat::window::video_mode &mode) {
+        RRCrtc crtc = monitor.get_crtc();
+        if (crtc == None) {
+            SPDLOG_WARN("Monitor {} has no crtc, can't switch its mode", monitor.name());
+            return false;
+        }
+
+        // video_mode doesn't carry the RandR id, find the output's mode that produces it
+        RRMode mode_id = None;
+        if (auto* output_info = fetch_output_info(monitor.get_output())) {
+            for (int i = 0 ; i < output_info->nmode && mode_id == None ; i++) {
+                if (make_video_mode_x11(mode_infos[output_info->modes[i]], screen) == mode) {
+                    mode_id = output_info->modes[i];
+                }
+            }
+            XRRFreeOutputInfo(output_info);
+        }
+
+        if (mode_id == None) {
+            SPDLOG_WARN("Monitor {} has no {}x{} @ {:.3f}Hz mode", monitor.name(), mode.resolution.x, mode.resolution.y, mode.refresh_rate.hz());
+            return false;
+        }
+
+        XRRCrtcInfo* crtc_info = XRRGetCrtcInfo(display, scr_res, crtc);
+        if (!crtc_info) return false;
+
+        bool sideways = crtc_info->rotation & (RR_Rotate_90 | RR_Rotate_270);
+        int width = static_cast<int>(sideways ? mode.resolution.y : mode.resolution.x);
+        int height = static_cast<int>(sideways ? mode.resolution.x : mode.resolution.y);
+        if (crtc_info->x + width > WidthOfScreen(screen) || crtc_info->y + height > HeightOfScreen(screen)) {
+            // growing the screen would move every other monitor around, only switch within the current layout
+            SPDLOG_WARN("{}x{} doesn't fit the current screen layout", mode.resolution.x, mode.resolution.y);
+            XRRFreeCrtcInfo(crtc_info);
+            return false;
+        }
+
+        bool remembered = find_saved(crtc) != nullptr;
+        if (!remembered) {
+            if (saved_crtc_count.load() == max_saved_crtcs || crtc_info->noutput > static_cast<int>(std::size(saved_crtc{}.outputs))) {
+                XRRFreeCrtcInfo(crtc_info);
+                return false;
+            }
+
+            saved_crtc saved{};
+            saved.crtc = crtc;
+            saved.mode = crtc_info->mode;
+            saved.x = crtc_info->x;
+            saved.y = crtc_info->y;
+            saved.rotation = crtc_info->rotation;
+            saved.noutput = crtc_info->noutput;
+            std::copy_n(crtc_info->outputs, crtc_info->noutput, saved.outputs);
+
+            // a crash without this would leave the panel in the switched mode, so only carry on if it opened
+            if (!open_crash_connection(display)) {
+                XRRFreeCrtcInfo(crtc_info);
+                return false;
+            }
+            saved_crtcs[saved_crtc_count.load()] = saved;
+            saved_crtc_count.fetch_add(1);
+        }
+
+        Status status = XRRSetCrtcConfig(display, scr_res, crtc, CurrentTime, crtc_info->x, crtc_info->y, mode_id,
+                                         crtc_info->rotation, crtc_info->outputs, crtc_info->noutput);
+        if (status == RRSetConfigInvalidConfigTime) {
+            // somebody else reconfigured since scr_res was fetched
+            refresh_screen_resources();
+            status = XRRSetCrtcConfig(display, scr_res, crtc, CurrentTime, crtc_info->x, crtc_info->y, mode_id,
+                                      crtc_info->rotation, crtc_info->outputs, crtc_info->noutput);
+        }
+        XRRFreeCrtcInfo(crtc_info);
+
+        if (status != RRSetConfigSuccess) {
+            SPDLOG_WARN("Switching {} to {}x{} failed ({})", monitor.name(), mode.resolution.x, mode.resolution.y, status);
+            if (!remembered) {
+                forget_saved(find_saved(crtc));
+            }
+            return false;
+        }
+
+        SPDLOG_DEBUG("Switched {} to {}x{} @ {:.3f}Hz", monitor.name(), mode.resolution.x, mode.resolution.y, mode.refresh_rate.hz());
+        return true;
+    }
+
+    void engine_state_x11::restore_mode(RRCrtc crtc) {
+        saved_crtc* saved = find_saved(crtc);
+        if (!saved) return;
+
+        if (apply(display, scr_res, *saved) == RRSetConfigInvalidConfigTime) {
+            refresh_screen_resources();
+            apply(display, scr_res, *saved);
+        }
+        XFlush(display);
+        forget_saved(saved);
+        SPDLOG_DEBUG("Restored crtc {}", crtc);
+    }
+
+    void engine_state_x11::restore_modes() {
+        while (saved_crtc_count.load() > 0) {
+            restore_mode(saved_crtcs[0].crtc);
+        }
+    }
+}
+#endif
@@ -4,25 +4,87 @@
 #include "kat/window/window.hpp"
 #include <spdlog/spdlog.h>
 #include <X11/Xresource.h>
+#include <X11/Xatom.h>
 #include <X11/cursorfont.h>
+#include <X11/XKBlib.h>
 #include <set>
+#include <algorithm>
 #include <unordered_map>
 #include <Xm/Xm.h>
 #include <Xm/XmAll.h>
 #include <Xm/MwmUtil.h>
+#include <poll.h>
+#include <unistd.h>
+#include <climits>
+#include <cstring>
 
 namespace kat::window::x11 {
-    engine_state_x11::engine_state_x11() {
+    namespace {
+        std::optional<float> parse_xft_dpi(const char* resources) {
+            if (!resources) return std::nullopt;
+
+            XrmDatabase db = XrmGetStringDatabase(resources);
+            if (!db) return std::nullopt;
+
+            std::optional<float> dpi;
+            XrmValue value;
+            char* type = nullptr;
+            if (XrmGetResource(db, "Xft.dpi", "Xft.Dpi", &type, &value) && type && std::strcmp(type, "String") == 0) {
+                float parsed = static_cast<float>(std::atof(value.addr));
+                if (parsed > 0.f) dpi = parsed;
+            }
+
+            XrmDestroyDatabase(db);
+            return dpi;
+        }
+    }
+
+    engine_state_x11::engine_state_x11(const windowing_engine_config& config) : m_config(config) {
+        KAT_PROFILE_ZONE("engine_state_x11::engine_state_x11");
+        if (m_config.event_thread) {
+            // has to happen before any other Xlib call so the display gets its locks
+            XInitThreads();
+        }
+
         display = XOpenDisplay(nullptr);
+        if (!display) {
+            SPDLOG_ERROR("Can't open the X display, is DISPLAY set?");
+            m_app_exit = true;
+            return;
+        }
+
         screen_id = DefaultScreen(display);
         screen = ScreenOfDisplay(display, screen_id);
         root = RootWindowOfScreen(screen);
 
-        scr_res = XRRGetScreenResources(display, root);
+        refresh_screen_resources();
 
-        for (int i = 0 ; i < scr_res->nmode ; i++) {
-            auto modei = scr_res->modes[i];
-            mode_infos[modei.id] = modei;
+        // RESOURCE_MANAGER changes are how Xft.dpi updates reach us
+        XSelectInput(display, root, PropertyChangeMask);
+
+        int randr_error_base;
+        if (XRRQueryExtension(display, &m_randr_event_base, &randr_error_base)) {
+            // keeps monitors and the mode table current across hotplug and mode switches
+            XRRSelectInput(display, root, RRScreenChangeNotifyMask | RRCrtcChangeNotifyMask | RROutputChangeNotifyMask);
+        } else {
+            m_randr_event_base = -1;
+        }
+
+        atoms.intern(display);
+
+        // report held keys as repeated presses instead of synthetic release/press pairs
+        XkbSetDetectableAutoRepeat(display, true, nullptr);
+        load_keysyms();
+
+        int xi_event_base, xi_error_base;
+        if (XQueryExtension(display, "XInputExtension", &m_xi_opcode, &xi_event_base, &xi_error_base)) {
+            // 2.1 changed raw events to keep arriving while another client holds a grab
+            int major = 2, minor = 2;
+            if (XIQueryVersion(display, &major, &minor) != Success) {
+                m_xi_opcode = -1;
+            }
+        } else {
+            m_xi_opcode = -1;
         }
 
         SPDLOG_DEBUG("Opened Display {}", XDisplayString(display));
@@ -30,73 +92,741 @@ namespace kat::window::x11 {
         SPDLOG_DEBUG("Screen Virtual Size: {} x {}", screen->width, screen->height);
     }
 
+    namespace {
+        constexpr std::pair<const char*, Atom atom_table_x11::*> atom_names[] = {
+                { "WM_PROTOCOLS", &atom_table_x11::wm_protocols },
+                { "WM_DELETE_WINDOW", &atom_table_x11::wm_delete_window },
+                { "_NET_WM_PING", &atom_table_x11::net_wm_ping },
+                { "_NET_WM_NAME", &atom_table_x11::net_wm_name },
+                { "_NET_WM_ICON_NAME", &atom_table_x11::net_wm_icon_name },
+                { "_NET_WM_STATE", &atom_table_x11::net_wm_state },
+                { "_NET_WM_STATE_FULLSCREEN", &atom_table_x11::net_wm_state_fullscreen },
+                { "_NET_WM_STATE_MAXIMIZED_VERT", &atom_table_x11::net_wm_state_maximized_vert },
+                { "_NET_WM_STATE_MAXIMIZED_HORZ", &atom_table_x11::net_wm_state_maximized_horz },
+                { "_NET_WM_BYPASS_COMPOSITOR", &atom_table_x11::net_wm_bypass_compositor },
+                { _XA_MWM_HINTS, &atom_table_x11::motif_wm_hints },
+                { "UTF8_STRING", &atom_table_x11::utf8_string },
+        };
+    }
+
+    void atom_table_x11::intern(Display *display) {
+        constexpr auto count = std::size(atom_names);
+        char* names[count];
+        Atom values[count];
+        for (std::size_t i = 0 ; i < count ; i++) {
+            names[i] = const_cast<char*>(atom_names[i].first);
+        }
+
+        XInternAtoms(display, names, static_cast<int>(count), false, values);
+        for (std::size_t i = 0 ; i < count ; i++) {
+            this->*atom_names[i].second = values[i];
+        }
+    }
+
     engine_state_x11::~engine_state_x11() {
+        if (!display) return;
+
+        stop_event_thread();
+        restore_modes();
+        if (m_blank_cursor != None) {
+            XFreeCursor(display, m_blank_cursor);
+        }
         XRRFreeScreenResources(scr_res);
         XCloseDisplay(display);
         SPDLOG_DEBUG("Closed Display");
     }
 
+    void engine_state_x11::refresh_screen_resources() {
+        if (scr_res) {
+            XRRFreeScreenResources(scr_res);
+        }
+
+        // The Current variant returns the server's cached configuration instead of making it re-probe every
+        // output, which can take tens of milliseconds per connector. Hotplug already made the server probe.
+        scr_res = XRRGetScreenResourcesCurrent(display, root);
+        m_screen_resources_stale = false;
+
+        for (int i = 0 ; i < scr_res->nmode ; i++) {
+            mode_infos.try_emplace(scr_res->modes[i].id, scr_res->modes[i]);
+        }
+    }
+
+    XRROutputInfo* engine_state_x11::fetch_output_info(RROutput output) {
+        auto* output_info = XRRGetOutputInfo(display, scr_res, output);
+        if (!output_info) return nullptr;
+
+        bool known = std::all_of(output_info->modes, output_info->modes + output_info->nmode, [this](RRMode mode) {
+            return mode_infos.contains(mode);
+        });
+
+        if (!known) {
+            XRRFreeOutputInfo(output_info);
+            refresh_screen_resources();
+            output_info = XRRGetOutputInfo(display, scr_res, output);
+        }
+
+        return output_info;
+    }
+
+    std::optional<float> engine_state_x11::xft_dpi() {
+        if (!m_xft_dpi_loaded) {
+            // Xlib kept a copy of the property from when the display was opened, so this needs no round trip
+            m_xft_dpi = parse_xft_dpi(XResourceManagerString(display));
+            m_xft_dpi_loaded = true;
+        }
+
+        return m_xft_dpi;
+    }
+
+    void engine_state_x11::send_wm_state(Window window, bool add, Atom first, Atom second) {
+        XEvent event{};
+        event.xclient.type = ClientMessage;
+        event.xclient.window = window;
+        event.xclient.message_type = atoms.net_wm_state;
+        event.xclient.format = 32;
+        event.xclient.data.l[0] = add ? 1 : 0; // _NET_WM_STATE_ADD / _NET_WM_STATE_REMOVE
+        event.xclient.data.l[1] = static_cast<long>(first);
+        event.xclient.data.l[2] = static_cast<long>(second);
+        event.xclient.data.l[3] = 1; // normal application
+        XSendEvent(display, root, false, SubstructureNotifyMask | SubstructureRedirectMask, &event);
+    }
+
     glm::vec2 engine_state_x11::dpi() {
-        float x, y;
-        x = y = KAT_BASE_DPI;
-        char* rms = XResourceManagerString(display);
-        if (rms) {
-            XrmDatabase db = XrmGetStringDatabase(rms);
-            if (db) {
-                XrmValue value;
-                char* type = nullptr;
-                if (XrmGetResource(db, "Xft.dpi", "Xft.Dpi", &type, &value)) {
-                    if (type && strcmp(type, "String") == 0) {
-                        x = y = std::atof(value.addr);
+        float d = xft_dpi().value_or(KAT_BASE_DPI);
+        return {d, d};
+    }
+
+    void engine_state_x11::handle_resource_manager_change(uint64_t timestamp) {
+        // XResourceManagerString never changes after XOpenDisplay, read the new value from the property itself
+        Atom type;
+        int format;
+        unsigned long count, remaining;
+        unsigned char* data = nullptr;
+        std::optional<float> new_dpi;
+        if (XGetWindowProperty(display, root, XA_RESOURCE_MANAGER, 0, LONG_MAX, false, XA_STRING,
+                               &type, &format, &count, &remaining, &data) == Success && data) {
+            new_dpi = parse_xft_dpi(reinterpret_cast<const char*>(data));
+            XFree(data);
+        }
+
+        bool changed = !m_xft_dpi_loaded || new_dpi != m_xft_dpi;
+        m_xft_dpi = new_dpi;
+        m_xft_dpi_loaded = true;
+
+        if (changed) {
+            // monitor DPI depends on it
+            m_monitors_generation++;
+            auto current = dpi();
+            auto ev = make_event(event_type::dpi_changed, 0, timestamp);
+            ev.dpi.x = current.x;
+            ev.dpi.y = current.y;
+            m_events.push(ev);
+            SPDLOG_DEBUG("Xft.dpi changed to {}", current.x);
+        }
+    }
+
+    glm::vec2 engine_state_x11::scale() {
+        return kat::window::conv_dpi_to_scale(dpi());
+    }
+
+    void engine_state_x11::setup(const std::shared_ptr<windowing_engine> &engine) {
+        // monitor discovery is a handful of round trips per output, so it waits until someone asks
+        m_engine = engine;
+
+        if (m_config.raw_mouse_input && !raw_mouse_input(true)) {
+            SPDLOG_WARN("XInput 2 is not available, raw mouse input is disabled");
+        }
+
+        if (m_config.event_thread) {
+            if (pipe(m_event_thread_wake) == 0) {
+                m_event_thread_running.store(true, std::memory_order_release);
+                m_event_thread = std::thread(&engine_state_x11::event_thread_main, this);
+                SPDLOG_DEBUG("Started event thread");
+            } else {
+                SPDLOG_WARN("Failed to create event thread wake pipe, events will be pumped by process_events()");
+            }
+        }
+    }
+
+    void engine_state_x11::stop_event_thread() {
+        if (m_event_thread.joinable()) {
+            m_event_thread_running.store(false, std::memory_order_release);
+            char byte = 0;
+            [[maybe_unused]] auto written = write(m_event_thread_wake[1], &byte, 1);
+            m_event_thread.join();
+            SPDLOG_DEBUG("Stopped event thread");
+        }
+
+        for (int& fd : m_event_thread_wake) {
+            if (fd >= 0) {
+                close(fd);
+                fd = -1;
+            }
+        }
+    }
+
+    void engine_state_x11::event_thread_main() {
+        KAT_PROFILE_THREAD("kat-events");
+        pollfd fds[2] = {
+                { ConnectionNumber(display), POLLIN, 0 },
+                { m_event_thread_wake[0], POLLIN, 0 },
+        };
+        int timeout = static_cast<int>(std::max<std::chrono::milliseconds::rep>(m_config.event_thread_poll_interval.count(), 1));
+
+        while (m_event_thread_running.load(std::memory_order_acquire)) {
+            // Non-blocking read of whatever is on the socket. Another thread's round trip can also pull events into
+            // Xlib's queue without waking poll(), which is what the poll timeout is there to catch.
+            int pending = XEventsQueued(display, QueuedAfterReading);
+            if (pending == 0) {
+                poll(fds, 2, timeout);
+                continue;
+            }
+
+            uint64_t read_at = event_timestamp_now();
+            for (; pending > 0 ; pending--) {
+                stamped_event_x11 se;
+                XNextEvent(display, &se.event);
+                se.timestamp = event_time(se.event, read_at);
+                se.translated = false;
+
+                // answered here so a long frame on the game thread never looks like a hang to the window manager
+                if (answer_ping(se.event)) continue;
+
+                if (se.event.type == GenericEvent) {
+                    if (!translate_generic_event(se.event, read_at, se.translated_event)) continue;
+                    se.translated = true;
+                }
+
+                if (!m_thread_events.try_push(se)) {
+                    m_thread_events_dropped.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        }
+    }
+
+    bool engine_state_x11::answer_ping(const XEvent &event) {
+        if (event.type != ClientMessage || event.xclient.message_type != atoms.wm_protocols || static_cast<Atom>(event.xclient.data.l[0]) != atoms.net_wm_ping) {
+            return false;
+        }
+
+        XEvent reply = event;
+        reply.xclient.window = root;
+        XSendEvent(display, root, false, SubstructureNotifyMask | SubstructureRedirectMask, &reply);
+        XFlush(display);
+        return true;
+    }
+
+    std::vector<std::shared_ptr<monitor>> engine_state_x11::monitors() const {
+        if (!m_monitors_enumerated && display) {
+            if (auto engine = m_engine.lock()) {
+                m_monitors = get_all_monitors_x11(engine);
+                m_monitors_enumerated = true;
+                m_monitors_generation++;
+            }
+        }
+
+        return { m_monitors.begin(), m_monitors.end() };
+    }
+
+    uint64_t engine_state_x11::monitors_generation() const {
+        return m_monitors_generation;
+    }
+
+    void engine_state_x11::process_events() {
+        if (!display) return;
+
+        if (m_event_thread.joinable()) {
+            // the event thread only reads, anything we queued still has to go out from here
+            XFlush(display);
+
+            stamped_event_x11 se;
+            while (m_thread_events.try_pop(se)) {
+                if (se.translated) {
+                    m_events.push(se.translated_event);
+                } else {
+                    handle_event(se.event, se.timestamp);
+                }
+            }
+
+            if (auto dropped = m_thread_events_dropped.exchange(0, std::memory_order_relaxed)) {
+                SPDLOG_WARN("Event thread dropped {} events while the queue was full", dropped);
+            }
+            return;
+        }
+
+        // QueuedAfterFlush sends any buffered requests and then does a non-blocking read of whatever the server has
+        // already written to the socket. It never waits for a reply, so an empty queue returns immediately.
+        int pending = XEventsQueued(display, QueuedAfterFlush);
+
+        while (pending > 0) {
+            uint64_t read_at = event_timestamp_now();
+            XEvent event;
+            for (; pending > 0 ; pending--) {
+                // the event is already in the local queue, so this can't block
+                XNextEvent(display, &event);
+                if (event.type == GenericEvent) {
+                    ::kat::window::event translated;
+                    if (translate_generic_event(event, read_at, translated)) {
+                        m_events.push(translated);
                     }
+                } else {
+                    handle_event(event, event_time(event, read_at));
                 }
+            }
+
+            // pick up anything a handler pulled into the queue without touching the connection again
+            pending = XEventsQueued(display, QueuedAlready);
+        }
+    }
 
-                XrmDestroyDatabase(db);
+    uint64_t server_clock_x11::to_steady(Time server_time, uint64_t read_at) {
+        auto now = static_cast<uint32_t>(server_time);
+        if (!m_synced) {
+            m_synced = true;
+            m_extended_ms = now;
+            m_offset_ns = static_cast<int64_t>(read_at) - m_extended_ms * 1'000'000;
+        } else {
+            // signed difference, so a wrap (or an event older than the last one) moves the right way
+            m_extended_ms += static_cast<int32_t>(now - m_last);
+        }
+        m_last = now;
+
+        int64_t stamp = m_extended_ms * 1'000'000 + m_offset_ns;
+        if (stamp > static_cast<int64_t>(read_at)) {
+            m_offset_ns -= stamp - static_cast<int64_t>(read_at);
+            stamp = static_cast<int64_t>(read_at);
+        }
+        return static_cast<uint64_t>(stamp);
+    }
+
+    uint64_t engine_state_x11::event_time(const XEvent &event, uint64_t read_at) {
+        switch (event.type) {
+            case KeyPress:
+            case KeyRelease:
+                return m_server_clock.to_steady(event.xkey.time, read_at);
+            case ButtonPress:
+            case ButtonRelease:
+                return m_server_clock.to_steady(event.xbutton.time, read_at);
+            case MotionNotify:
+                return m_server_clock.to_steady(event.xmotion.time, read_at);
+            case EnterNotify:
+            case LeaveNotify:
+                return m_server_clock.to_steady(event.xcrossing.time, read_at);
+            default:
+                return read_at;
+        }
+    }
+
+    void engine_state_x11::forget_window(Window window) {
+        // the server can't send a FocusOut to a window that no longer exists
+        m_focus_window.compare_exchange_strong(window, None, std::memory_order_relaxed);
+    }
+
+    void engine_state_x11::load_keysyms() {
+        int min_keycode, max_keycode;
+        XDisplayKeycodes(display, &min_keycode, &max_keycode);
+        max_keycode = std::min(max_keycode, static_cast<int>(m_keysyms.size()) - 1);
+
+        int per_keycode;
+        KeySym* map = XGetKeyboardMapping(display, static_cast<KeyCode>(min_keycode), max_keycode - min_keycode + 1, &per_keycode);
+        if (!map) return;
+
+        m_keysyms.fill(NoSymbol);
+        for (int keycode = min_keycode ; keycode <= max_keycode ; keycode++) {
+            const KeySym* syms = map + static_cast<std::ptrdiff_t>(keycode - min_keycode) * per_keycode;
+            KeySym sym = syms[0];
+            if (per_keycode == 1 || syms[1] == NoSymbol) {
+                // a lone letter keysym stands for both cases, Xlib reports the lower case one for column 0
+                KeySym lower, upper;
+                XConvertCase(sym, &lower, &upper);
+                sym = lower;
             }
+            m_keysyms[keycode] = sym;
+        }
+
+        XFree(map);
+        SPDLOG_DEBUG("Loaded keyboard mapping for keycodes {}-{}", min_keycode, max_keycode);
+    }
+
+    bool make_mouse_button_x11(unsigned int button, mouse_button &out) {
+        switch (button) {
+            case Button1: out = mouse_button::left; return true;
+            case Button2: out = mouse_button::middle; return true;
+            case Button3: out = mouse_button::right; return true;
+            case 8: out = mouse_button::x1; return true;
+            case 9: out = mouse_button::x2; return true;
+            default: return false;
         }
+    }
 
-        // if other ways to get dpi exist, maybe use those.
+    bool engine_state_x11::raw_mouse_input(bool enable) {
+        if (m_xi_opcode < 0) return false;
+        if (enable == m_raw_mouse_input) return true;
+
+        unsigned char mask[XIMaskLen(XI_LASTEVENT)] = {};
+        if (enable) {
+            XISetMask(mask, XI_RawMotion);
+            XISetMask(mask, XI_RawButtonPress);
+            XISetMask(mask, XI_RawButtonRelease);
+        }
 
-        return {x, y};
+        // raw events are only ever delivered to the root window
+        XIEventMask event_mask{ XIAllMasterDevices, sizeof(mask), mask };
+        XISelectEvents(display, root, &event_mask, 1);
+        XFlush(display);
+
+        m_raw_mouse_input = enable;
+        return true;
     }
 
-    glm::vec2 engine_state_x11::scale() {
-        return kat::window::conv_dpi_to_scale(dpi());
+    bool engine_state_x11::raw_mouse_input() const {
+        return m_raw_mouse_input;
     }
 
-    void engine_state_x11::setup(const std::shared_ptr<windowing_engine> &engine) {
-        m_monitors = get_all_monitors(engine);
+    const windowing_engine_config &engine_state_x11::config() const {
+        return m_config;
     }
 
-    std::vector<std::shared_ptr<monitor_x11>> engine_state_x11::monitors() const {
-        return m_monitors;
+    Cursor engine_state_x11::blank_cursor() {
+        if (m_blank_cursor == None) {
+            char data = 0;
+            Pixmap pixmap = XCreateBitmapFromData(display, root, &data, 1, 1);
+            XColor black{};
+            m_blank_cursor = XCreatePixmapCursor(display, pixmap, pixmap, &black, &black, 0, 0);
+            XFreePixmap(display, pixmap);
+        }
+
+        return m_blank_cursor;
+    }
+
+    bool engine_state_x11::translate_generic_event(XEvent &event, uint64_t read_at, ::kat::window::event &out) {
+        auto& cookie = event.xcookie;
+        if (cookie.extension != m_xi_opcode || !XGetEventData(display, &cookie)) {
+            return false;
+        }
+
+        // Raw events go to every client that asked for them, only report them while one of our windows has focus
+        bool translated = false;
+        Window focus = m_focus_window.load(std::memory_order_relaxed);
+        const auto* raw = static_cast<const XIRawEvent*>(cookie.data);
+        // several raw motions arrive per frame at high polling rates, each keeps its own time
+        uint64_t timestamp = m_server_clock.to_steady(raw->time, read_at);
+
+        if (focus != None) {
+            switch (cookie.evtype) {
+                case XI_RawMotion: {
+                    out = make_event(event_type::raw_mouse_motion, focus, timestamp);
+                    // raw_values only holds the valuators set in the mask, x and y are axes 0 and 1
+                    const double* value = raw->raw_values;
+                    for (int axis = 0 ; axis < 2 && axis < raw->valuators.mask_len * 8 ; axis++) {
+                        if (!XIMaskIsSet(raw->valuators.mask, axis)) continue;
+                        (axis == 0 ? out.raw_mouse_motion.dx : out.raw_mouse_motion.dy) = static_cast<float>(*value++);
+                    }
+                    translated = true;
+                    break;
+                }
+                case XI_RawButtonPress:
+                case XI_RawButtonRelease: {
+                    mouse_button button;
+                    if (make_mouse_button_x11(raw->detail, button)) {
+                        out = make_event(cookie.evtype == XI_RawButtonPress ? event_type::raw_mouse_button_down : event_type::raw_mouse_button_up, focus, timestamp);
+                        out.mouse_button.button = button;
+                        translated = true;
+                    }
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+
+        XFreeEventData(display, &cookie);
+        return translated;
     }
 
-    monitor_x11::monitor_x11(const std::shared_ptr<windowing_engine>& engine, const XRRMonitorInfo &monitor_info, const XRROutputInfo& output_info, RROutput output) : m_output(output), m_windowing_engine(engine) {
+    uint16_t make_key_modifiers_x11(unsigned int state) {
+        uint16_t mods = key_modifier_none;
+        if (state & ShiftMask) mods |= key_modifier_shift;
+        if (state & ControlMask) mods |= key_modifier_control;
+        if (state & Mod1Mask) mods |= key_modifier_alt;
+        if (state & Mod4Mask) mods |= key_modifier_super;
+        return mods;
+    }
+
+    void engine_state_x11::handle_event(const XEvent &event, uint64_t timestamp) {
+        switch (event.type) {
+            case KeyPress:
+            case KeyRelease: {
+                bool down = event.type == KeyPress;
+                auto ev = make_event(down ? event_type::key_down : event_type::key_up, event.xkey.window, timestamp);
+                // X keycodes are evdev codes offset by 8 on every server that still matters
+                ev.key.scancode = event.xkey.keycode >= 8 ? event.xkey.keycode - 8 : 0;
+                ev.key.keycode = m_keysyms[event.xkey.keycode & 0xff];
+                ev.key.modifiers = make_key_modifiers_x11(event.xkey.state);
+                ev.key.repeat = down && m_keys_down[event.xkey.keycode & 0xff];
+                m_keys_down[event.xkey.keycode & 0xff] = down;
+                m_events.push(ev);
+                break;
+            }
+            case ButtonPress:
+            case ButtonRelease: {
+                const auto& be = event.xbutton;
+                if (be.button >= Button4 && be.button <= 7) {
+                    // wheel clicks come in as press/release pairs, only the press is interesting
+                    if (event.type == ButtonPress) {
+                        auto ev = make_event(event_type::mouse_scroll, be.window, timestamp);
+                        ev.mouse_scroll.y = be.button == Button4 ? 1.f : be.button == Button5 ? -1.f : 0.f;
+                        ev.mouse_scroll.x = be.button == 6 ? -1.f : be.button == 7 ? 1.f : 0.f;
+                        m_events.push(ev);
+                    }
+                    break;
+                }
+
+                mouse_button button;
+                if (!make_mouse_button_x11(be.button, button)) break;
+
+                auto ev = make_event(event.type == ButtonPress ? event_type::mouse_button_down : event_type::mouse_button_up, be.window, timestamp);
+                ev.mouse_button.button = button;
+                ev.mouse_button.x = be.x;
+                ev.mouse_button.y = be.y;
+                m_events.push(ev);
+                break;
+            }
+            case MotionNotify: {
+                auto ev = make_event(event_type::mouse_move, event.xmotion.window, timestamp);
+                ev.mouse_move.x = event.xmotion.x;
+                ev.mouse_move.y = event.xmotion.y;
+                m_events.push(ev);
+                break;
+            }
+            case ConfigureNotify: {
+                const auto& ce = event.xconfigure;
+                auto* window = m_windows.find(ce.window);
+                if (!window) break;
+
+                auto [resized, moved] = window->handle_configure(ce);
+                if (resized) {
+                    auto ev = make_event(event_type::resize, ce.window, timestamp);
+                    ev.resize.width = ce.width;
+                    ev.resize.height = ce.height;
+                    m_events.push(ev);
+                }
+
+                if (moved) {
+                    auto position = window->position();
+                    auto ev = make_event(event_type::move, ce.window, timestamp);
+                    ev.move.x = position.x;
+                    ev.move.y = position.y;
+                    m_events.push(ev);
+                }
+                break;
+            }
+            case ReparentNotify: {
+                if (auto* window = m_windows.find(event.xreparent.window)) {
+                    window->handle_reparent(event.xreparent);
+                }
+                break;
+            }
+            case FocusIn:
+            case FocusOut:
+                // ignore the focus shuffling caused by keyboard grabs
+                if (event.xfocus.mode == NotifyNormal || event.xfocus.mode == NotifyWhileGrabbed) {
+                    m_events.push(make_event(event.type == FocusIn ? event_type::focus_gained : event_type::focus_lost, event.xfocus.window, timestamp));
+
+                    if (event.type == FocusIn) {
+                        m_focus_window.store(event.xfocus.window, std::memory_order_relaxed);
+                        if (auto* window = m_windows.find(event.xfocus.window)) {
+                            window->handle_focus_in();
+                        }
+                    } else {
+                        Window expected = event.xfocus.window;
+                        m_focus_window.compare_exchange_strong(expected, None, std::memory_order_relaxed);
+                    }
+                }
+                break;
+            case ClientMessage:
+                if (answer_ping(event)) break;
+                if (event.xclient.message_type == atoms.wm_protocols && static_cast<Atom>(event.xclient.data.l[0]) == atoms.wm_delete_window) {
+                    m_events.push(make_event(event_type::close_requested, event.xclient.window, timestamp));
+                    m_app_exit = true;
+                    SPDLOG_INFO("Exit");
+                }
+                break;
+            case MappingNotify:
+                if (event.xmapping.request == MappingKeyboard || event.xmapping.request == MappingModifier) {
+                    XRefreshKeyboardMapping(const_cast<XMappingEvent*>(&event.xmapping));
+                    if (event.xmapping.request == MappingKeyboard) {
+                        load_keysyms();
+                    }
+                }
+                break;
+            case PropertyNotify:
+                if (event.xproperty.window == root && event.xproperty.atom == XA_RESOURCE_MANAGER) {
+                    handle_resource_manager_change(timestamp);
+                }
+                break;
+            default:
+                if (m_randr_event_base >= 0 && event.type >= m_randr_event_base && event.type <= m_randr_event_base + RRNotify) {
+                    handle_randr_event(event, timestamp);
+                }
+                break;
+        }
+    }
+
+    void engine_state_x11::handle_randr_event(const XEvent &event, uint64_t timestamp) {
+        if (event.type == m_randr_event_base + RRScreenChangeNotify) {
+            // lets Xlib update the screen size it reports
+            XRRUpdateConfiguration(const_cast<XEvent*>(&event));
+            return;
+        }
+
+        if (!m_monitors_enumerated) {
+            // nothing handed out yet that could go stale, catch up once monitors are asked for
+            m_screen_resources_stale = true;
+            return;
+        }
+
+        const auto& notify = reinterpret_cast<const XRRNotifyEvent&>(event);
+        switch (notify.subtype) {
+            case RRNotify_CrtcChange: {
+                const auto& ce = reinterpret_cast<const XRRCrtcChangeNotifyEvent&>(event);
+                if (ce.mode != None && !mode_infos.contains(ce.mode)) {
+                    refresh_screen_resources();
+                }
+
+                for (const auto& m : m_monitors) {
+                    if (m->get_crtc() == ce.crtc && m->handle_crtc_change(ce)) {
+                        m_monitors_generation++;
+                        auto ev = make_event(event_type::monitor_changed, 0, timestamp);
+                        ev.monitor.monitor = m->get_output();
+                        ev.monitor.change = monitor_change::configuration;
+                        m_events.push(ev);
+                    }
+                }
+                break;
+            }
+            case RRNotify_OutputChange:
+                handle_output_change(reinterpret_cast<const XRROutputChangeNotifyEvent&>(event), timestamp);
+                break;
+            default:
+                break;
+        }
+    }
+
+    void engine_state_x11::handle_output_change(const XRROutputChangeNotifyEvent &event, uint64_t timestamp) {
+        auto it = std::find_if(m_monitors.begin(), m_monitors.end(), [&](const auto& m) {
+            return m->get_output() == event.output;
+        });
+
+        auto ev = make_event(event_type::monitor_changed, 0, timestamp);
+        ev.monitor.monitor = event.output;
+
+        // an output only counts as a monitor while it is driven by a crtc
+        if (event.connection != RR_Connected || event.crtc == None) {
+            if (it != m_monitors.end()) {
+                m_monitors.erase(it);
+                m_monitors_generation++;
+                ev.monitor.change = monitor_change::disconnected;
+                m_events.push(ev);
+                SPDLOG_DEBUG("Monitor on output {} went away", event.output);
+            }
+            return;
+        }
+
+        auto* output_info = fetch_output_info(event.output);
+        if (!output_info) return;
+
+        if (it != m_monitors.end()) {
+            (*it)->update_output(*output_info);
+            m_monitors_generation++;
+            ev.monitor.change = monitor_change::configuration;
+            m_events.push(ev);
+        } else if (auto engine = m_engine.lock()) {
+            // the RandR monitor holding this output carries the geometry and primary flag
+            int count;
+            XRRMonitorInfo* monitor_infos = XRRGetMonitors(display, root, true, &count);
+            for (int i = 0 ; i < count ; i++) {
+                auto* outputs_end = monitor_infos[i].outputs + monitor_infos[i].noutput;
+                if (std::find(monitor_infos[i].outputs, outputs_end, event.output) != outputs_end) {
+                    m_monitors.push_back(std::make_shared<monitor_x11>(engine, monitor_infos[i], *output_info, event.output));
+                    m_monitors_generation++;
+                    ev.monitor.change = monitor_change::connected;
+                    m_events.push(ev);
+                    SPDLOG_DEBUG("Monitor {} connected", output_info->name);
+                    break;
+                }
+            }
+            XRRFreeMonitors(monitor_infos);
+        }
+
+        XRRFreeOutputInfo(output_info);
+    }
+
+    monitor_x11::monitor_x11(const std::shared_ptr<windowing_engine>& engine, const XRRMonitorInfo &monitor_info, const XRROutputInfo& output_info, RROutput output) : m_output(output), m_platform(engine->platform_as<engine_state_x11>()) {
         m_size = { monitor_info.width, monitor_info.height };
         m_position = { monitor_info.x, monitor_info.y };
+        m_is_primary = monitor_info.primary;
+        m_monitor_idname = monitor_info.name;
+        update_output(output_info);
+    }
+
+    void monitor_x11::update_output(const XRROutputInfo &output_info) {
         m_name = output_info.name;
         m_physical_size = { output_info.mm_width, output_info.mm_height };
         m_crtc = output_info.crtc;
-        m_is_primary = monitor_info.primary;
-        m_monitor_idname = monitor_info.name;
         m_video_modes.resize(output_info.nmode);
-        auto* crtc_info = XRRGetCrtcInfo(engine->platform->display, engine->platform->scr_res, m_crtc);
+        auto* crtc_info = m_crtc != None ? XRRGetCrtcInfo(m_platform->display, m_platform->scr_res, m_crtc) : nullptr;
 
         for (int i = 0 ; i < output_info.nmode ; i++) {
             auto mode = output_info.modes[i];
-            XRRModeInfo modeinfo = engine->platform->mode_infos[mode];
-            m_video_modes[i] = make_video_mode_x11(modeinfo, crtc_info, engine->platform->screen);
+            XRRModeInfo modeinfo = m_platform->mode_infos[mode];
+            m_video_modes[i] = make_video_mode_x11(modeinfo, m_platform->screen);
+        }
+        sort_video_modes(m_video_modes);
+
+        if (crtc_info) {
+            RRMode mode = crtc_info->mode;
+            XRRModeInfo modeinfo = m_platform->mode_infos[mode];
+            m_video_mode = make_video_mode_x11(modeinfo, m_platform->screen);
+            keep_video_mode(m_video_modes, m_video_mode);
+            m_position = { crtc_info->x, crtc_info->y };
+            m_size = { crtc_info->width, crtc_info->height };
+            XRRFreeCrtcInfo(crtc_info);
+        } else {
+            m_video_mode = {};
         }
+    }
 
-        RRMode mode = crtc_info->mode;
-        XRRModeInfo modeinfo = engine->platform->mode_infos[mode];
-        kat::window::video_mode vm = make_video_mode_x11(modeinfo, crtc_info, engine->platform->screen);
-        m_video_mode = vm;
+    bool monitor_x11::handle_crtc_change(const XRRCrtcChangeNotifyEvent &event) {
+        if (event.mode == None) {
+            // the crtc was turned off, the output change that follows removes the monitor
+            return false;
+        }
+
+        auto mode = make_video_mode_x11(m_platform->mode_infos[event.mode], m_platform->screen);
+        glm::ivec2 position = { event.x, event.y };
+        glm::uvec2 size = { event.width, event.height };
+
+        bool changed = !(mode == m_video_mode) || position != m_position || size != m_size;
+        m_video_mode = mode;
+        keep_video_mode(m_video_modes, m_video_mode);
+        m_position = position;
+        m_size = size;
+        return changed;
     }
 
     glm::vec2 monitor_x11::dpi() const {
-        return m_windowing_engine->platform->dpi();
+        // an explicit Xft.dpi is what every other X client renders with, so it wins over the EDID size
+        if (auto xft = m_platform->xft_dpi()) {
+            return { *xft, *xft };
+        }
+
+        if (m_physical_size.x == 0 || m_physical_size.y == 0) {
+            // projectors and some virtual outputs report no physical size
+            return { KAT_BASE_DPI, KAT_BASE_DPI };
+        }
+
+        return glm::vec2(m_size) / (glm::vec2(m_physical_size) / 25.4f);
     }
 
     glm::vec2 monitor_x11::scale() const {
@@ -127,26 +857,49 @@ namespace kat::window::x11 {
         return m_output;
     }
 
+    const ::kat::window::video_mode* monitor_x11::closest_video_mode(const video_mode_request &request) const {
+        return find_closest_video_mode(m_video_modes, request);
+    }
+
+    uint64_t monitor_x11::id() const {
+        return m_output;
+    }
+
+    RRCrtc monitor_x11::get_crtc() const {
+        return m_crtc;
+    }
+
+    engine_state_x11* monitor_x11::get_platform() const {
+        return m_platform;
+    }
+
     ::kat::window::video_mode monitor_x11::video_mode() const {
         return m_video_mode;
     }
 
-    std::vector<::kat::window::video_mode> monitor_x11::video_modes() const {
+    std::span<const ::kat::window::video_mode> monitor_x11::video_modes() const {
         return m_video_modes;
     }
 
-    int calc_refresh_rate(const XRRModeInfo &modeInfo) {
-        if (modeInfo.hTotal != 0 && modeInfo.vTotal != 0) {
-            return static_cast<int>(round(static_cast<double>(modeInfo.dotClock) / static_cast<double>(modeInfo.hTotal * modeInfo.vTotal)));
-        } else {
-            return 0;
-        }
+    mode_timing make_mode_timing_x11(const XRRModeInfo &modeInfo) {
+        mode_timing timing{};
+        timing.dot_clock = modeInfo.dotClock;
+        timing.htotal = modeInfo.hTotal;
+        timing.vtotal = modeInfo.vTotal;
+        timing.interlaced = (modeInfo.modeFlags & RR_Interlace) != 0;
+        timing.double_scan = (modeInfo.modeFlags & RR_DoubleScan) != 0;
+        return timing;
     }
 
-    ::kat::window::video_mode make_video_mode_x11(const XRRModeInfo &mode_info, const XRRCrtcInfo* crtc_info, Screen* screen) {
+    rational_refresh_rate calc_refresh_rate(const XRRModeInfo &modeInfo) {
+        return make_mode_timing_x11(modeInfo).refresh_rate();
+    }
+
+    ::kat::window::video_mode make_video_mode_x11(const XRRModeInfo &mode_info, Screen* screen) {
         ::kat::window::video_mode mode{};
 
-        mode.refresh_rate = calc_refresh_rate(mode_info);
+        mode.timing = make_mode_timing_x11(mode_info);
+        mode.refresh_rate = mode.timing.refresh_rate();
         mode.resolution = { mode_info.width, mode_info.height };
         mode.depth = make_display_depth_x11(DefaultDepthOfScreen(screen));
 
@@ -168,14 +921,13 @@ namespace kat::window::x11 {
 
         return dd;
     }
-}
 
-namespace kat::window {
-    std::vector<std::shared_ptr<monitor>> get_all_monitors(const std::shared_ptr<windowing_engine> &engine) {
+    std::vector<std::shared_ptr<monitor_x11>> get_all_monitors_x11(const std::shared_ptr<windowing_engine> &engine) {
+        KAT_PROFILE_ZONE("get_all_monitors_x11");
         int count;
-        XRRMonitorInfo* monitorInfos = XRRGetMonitors(engine->platform->display, engine->platform->root, 0, &count);
+        XRRMonitorInfo* monitorInfos = XRRGetMonitors(engine->platform_as<engine_state_x11>()->display, engine->platform_as<engine_state_x11>()->root, 0, &count);
 
-        std::vector<std::shared_ptr<monitor>> monitors;
+        std::vector<std::shared_ptr<monitor_x11>> monitors;
 
         std::unordered_map<RROutput, XRRMonitorInfo> active_outputs;
 
@@ -185,68 +937,104 @@ namespace kat::window {
             }
         }
 
-        auto sr = XRRGetScreenResources(engine->platform->display, engine->platform->root);
+        // reuse the resources fetched when the display was opened instead of asking again
+        if (engine->platform_as<engine_state_x11>()->m_screen_resources_stale) {
+            engine->platform_as<engine_state_x11>()->refresh_screen_resources();
+        }
+        auto sr = engine->platform_as<engine_state_x11>()->scr_res;
 
         for (int i = 0 ; i < sr->noutput ; i++) {
             auto output = sr->outputs[i];
-            auto output_info = XRRGetOutputInfo(engine->platform->display, sr, output);
-            if (output_info->connection != RR_Disconnected && active_outputs.find(output) != active_outputs.end()) {
-                auto monitor_info = active_outputs[output];
-                monitors.push_back(std::make_shared<monitor>(engine, monitor_info, *output_info, output));
+            auto active = active_outputs.find(output);
+            if (active == active_outputs.end()) {
+                // not part of any monitor, no need to spend a round trip on it
+                continue;
+            }
+
+            auto output_info = XRRGetOutputInfo(engine->platform_as<engine_state_x11>()->display, sr, output);
+            if (!output_info) {
+                // unplugged since XRRGetMonitors, the output change notify for it follows
+                continue;
+            }
+            if (output_info->connection != RR_Disconnected) {
+                monitors.push_back(std::make_shared<monitor_x11>(engine, active->second, *output_info, output));
             }
 
             XRRFreeOutputInfo(output_info);
         }
 
-
-        XRRFreeScreenResources(sr);
         XRRFreeMonitors(monitorInfos);
 
         return monitors;
     }
+}
 
-    x11::window_x11::window_x11(const std::shared_ptr<windowing_engine>& engine, std::string_view title_, glm::uvec2 size_, glm::uvec2 position_) : m_windowing_engine(engine) {
-        Cursor cursor = XCreateFontCursor(engine->platform->display, XC_left_side);
+namespace kat::window {
+    x11::window_x11::window_x11(windowing_engine& engine, std::string_view title_, glm::uvec2 size_, glm::ivec2 position_) : m_windowing_engine(&engine), m_size(size_), m_position(position_) {
+        KAT_PROFILE_ZONE("window_x11::window_x11");
+        Cursor cursor = XCreateFontCursor(engine.platform_as<engine_state_x11>()->display, XC_left_side);
 
         XSetWindowAttributes swa{};
-        swa.colormap = engine->platform->screen->cmap;
-        swa.event_mask = StructureNotifyMask | KeyPressMask | ExposureMask | ControlMask;
+        swa.colormap = engine.platform_as<engine_state_x11>()->screen->cmap;
+        swa.event_mask = StructureNotifyMask | KeyPressMask | KeyReleaseMask | ButtonPressMask | ButtonReleaseMask |
+                         PointerMotionMask | FocusChangeMask | ExposureMask;
         swa.cursor = cursor;
 
-        m_window = XCreateWindow(m_windowing_engine->platform->display, m_windowing_engine->platform->root,
+        m_window = XCreateWindow(m_windowing_engine->platform_as<engine_state_x11>()->display, m_windowing_engine->platform_as<engine_state_x11>()->root,
                       position_.x, position_.y, size_.x, size_.y, 0,
                       CopyFromParent, InputOutput, CopyFromParent,
                       CWEventMask | CWColormap | CWCursor,
                       &swa);
 
-
-
-        XStoreName(engine->platform->display, m_window, title_.data());
-        XMapWindow(engine->platform->display, m_window);
+        title(title_);
+        Atom protocols[] = { engine.platform_as<engine_state_x11>()->atoms.wm_delete_window, engine.platform_as<engine_state_x11>()->atoms.net_wm_ping };
+        XSetWMProtocols(engine.platform_as<engine_state_x11>()->display, m_window, protocols, 2);
+        XMapWindow(engine.platform_as<engine_state_x11>()->display, m_window);
 
 //        //code to remove decoration
 //        PropMwmHints hints;
 //        Atom property;
 //        hints.flags = MWM_HINTS_DECORATIONS;
 //        hints.decorations = 0;
-//        property = XInternAtom(m_windowing_engine->platform->display, _XA_MWM_HINTS, true);
-//        XChangeProperty(m_windowing_engine->platform->display,m_window,property,property,32,PropModeReplace,(unsigned char *)&hints,5);
-
-        XMapWindow(m_windowing_engine->platform->display, m_window);
+//        property = XInternAtom(m_windowing_engine->platform_as<engine_state_x11>()->display, _XA_MWM_HINTS, true);
+//        XChangeProperty(m_windowing_engine->platform_as<engine_state_x11>()->display,m_window,property,property,32,PropModeReplace,(unsigned char *)&hints,5);
 
+        XMapWindow(m_windowing_engine->platform_as<engine_state_x11>()->display, m_window);
 
     }
 
     x11::window_x11::~window_x11() {
+        if (m_pointer_locked) {
+            pointer_lock(false);
+        }
+        if (m_switched_crtc != None) {
+            m_windowing_engine->platform_as<engine_state_x11>()->restore_mode(m_switched_crtc);
+        }
 
+        // events already queued for it still name this id, windowing_engine::find_window() just won't find it
+        m_windowing_engine->platform_as<engine_state_x11>()->forget_window(m_window);
+        XDestroyWindow(m_windowing_engine->platform_as<engine_state_x11>()->display, m_window);
+        XFlush(m_windowing_engine->platform_as<engine_state_x11>()->display);
     }
 
     std::string x11::window_x11::title() const {
-        return std::string();
+        return m_title;
     }
 
     void x11::window_x11::title(std::string_view new_title) {
-
+        if (new_title == m_title && m_title_set) return;
+        m_title = new_title;
+        m_title_set = true;
+
+        auto* platform = m_windowing_engine->platform_as<engine_state_x11>();
+        auto* data = reinterpret_cast<const unsigned char*>(m_title.data());
+        auto length = static_cast<int>(m_title.size());
+
+        // EWMH window managers show the UTF-8 _NET_WM_NAME, WM_NAME is only there for the ones that predate it
+        XChangeProperty(platform->display, m_window, platform->atoms.net_wm_name, platform->atoms.utf8_string, 8, PropModeReplace, data, length);
+        XChangeProperty(platform->display, m_window, platform->atoms.net_wm_icon_name, platform->atoms.utf8_string, 8, PropModeReplace, data, length);
+        XStoreName(platform->display, m_window, m_title.c_str());
+        XFlush(platform->display);
     }
 
     glm::vec2 x11::window_x11::dpi() const {
@@ -258,37 +1046,112 @@ namespace kat::window {
     }
 
     glm::uvec2 x11::window_x11::size() const {
-        XWindowAttributes wa;
-        XGetWindowAttributes(m_windowing_engine->platform->display, m_window, &wa);
-
-        return { wa.width, wa.height };
+        return m_size;
     }
 
     glm::ivec2 x11::window_x11::position() const {
-        Window root;
-        int x, y;
-        unsigned int w, h, bw, d;
-        XTranslateCoordinates(m_windowing_engine->platform->display, m_window, m_windowing_engine->platform->root, 0, 0, &x, &y, &root);
-
-        return { x, y };
+        return m_position;
     }
 
     void x11::window_x11::size(glm::uvec2 new_size) {
-        XMoveWindow(m_windowing_engine->platform->display, m_window, new_size.x, new_size.y);
-        XFlush(m_windowing_engine->platform->display);
+        XResizeWindow(m_windowing_engine->platform_as<engine_state_x11>()->display, m_window, new_size.x, new_size.y);
+        XFlush(m_windowing_engine->platform_as<engine_state_x11>()->display);
     }
 
     void x11::window_x11::position(glm::ivec2 new_position) {
         XWindowChanges changes{};
         changes.x = new_position.x;
         changes.y = new_position.y;
-        XConfigureWindow(m_windowing_engine->platform->display, m_window, CWX | CWY, &changes);
+        XConfigureWindow(m_windowing_engine->platform_as<engine_state_x11>()->display, m_window, CWX | CWY, &changes);
+    }
+
+    void x11::window_x11::sync_geometry() {
+        XWindowAttributes wa;
+        XGetWindowAttributes(m_windowing_engine->platform_as<engine_state_x11>()->display, m_window, &wa);
+        m_size = { wa.width, wa.height };
+
+        Window child;
+        int x, y;
+        XTranslateCoordinates(m_windowing_engine->platform_as<engine_state_x11>()->display, m_window, m_windowing_engine->platform_as<engine_state_x11>()->root, 0, 0, &x, &y, &child);
+        m_position = { x, y };
+    }
+
+    std::pair<bool, bool> x11::window_x11::handle_configure(const XConfigureEvent &event) {
+        glm::uvec2 new_size = { event.width, event.height };
+        bool resized = new_size != m_size;
+        m_size = new_size;
+
+        // Once a window manager has reparented us, real ConfigureNotify coordinates are relative to its frame.
+        // ICCCM requires it to send a synthetic event with root coordinates whenever we move, so only trust those.
+        bool moved = false;
+        if (event.send_event || !m_reparented) {
+            glm::ivec2 new_position = { event.x, event.y };
+            moved = new_position != m_position;
+            m_position = new_position;
+        }
+
+        return { resized, moved };
+    }
+
+    void x11::window_x11::handle_reparent(const XReparentEvent &event) {
+        m_reparented = event.parent != m_windowing_engine->platform_as<engine_state_x11>()->root;
+    }
+
+    void x11::window_x11::handle_focus_in() {
+        // window managers break grabs when switching away, take the pointer back when we get focus again
+        if (m_pointer_locked) {
+            grab_pointer();
+        }
+    }
+
+    bool x11::window_x11::grab_pointer() {
+        auto* platform = m_windowing_engine->platform_as<engine_state_x11>();
+        int result = XGrabPointer(platform->display, m_window, true, ButtonPressMask | ButtonReleaseMask | PointerMotionMask,
+                                  GrabModeAsync, GrabModeAsync, m_window, platform->blank_cursor(), CurrentTime);
+        return result == GrabSuccess;
+    }
+
+    bool x11::window_x11::pointer_lock(bool lock) {
+        auto* platform = m_windowing_engine->platform_as<engine_state_x11>();
+        if (lock == m_pointer_locked) return true;
+
+        if (lock) {
+            if (!platform->raw_mouse_input(true)) {
+                SPDLOG_WARN("Pointer lock needs XInput 2 raw input, which the server doesn't have");
+                return false;
+            }
+
+            // start in the middle so confinement doesn't pin the pointer to an edge; raw deltas ignore it anyway
+            XWarpPointer(platform->display, None, m_window, 0, 0, 0, 0, static_cast<int>(m_size.x / 2), static_cast<int>(m_size.y / 2));
+            if (!grab_pointer()) {
+                // not viewable yet or someone else holds a grab, handle_focus_in() tries again
+                SPDLOG_DEBUG("Pointer grab deferred");
+            }
+            m_pointer_locked = true;
+        } else {
+            XUngrabPointer(platform->display, CurrentTime);
+            m_pointer_locked = false;
+            if (!platform->config().raw_mouse_input) {
+                platform->raw_mouse_input(false);
+            }
+        }
+
+        XFlush(platform->display);
+        return true;
+    }
+
+    bool x11::window_x11::pointer_locked() const {
+        return m_pointer_locked;
     }
 
     Window x11::window_x11::platform_handle() const {
         return m_window;
     }
 
+    uint64_t x11::window_x11::native_handle() const {
+        return m_window;
+    }
+
     bool x11::window_x11::decorated() const {
         return m_decorated;
     }
@@ -303,8 +1166,8 @@ namespace kat::window {
                 Atom property;
                 hints.flags = MWM_HINTS_DECORATIONS;
                 hints.decorations = MWM_DECOR_ALL;
-                property = XInternAtom(m_windowing_engine->platform->display, _XA_MWM_HINTS, true);
-                XChangeProperty(m_windowing_engine->platform->display, m_window, property,
+                property = m_windowing_engine->platform_as<engine_state_x11>()->atoms.motif_wm_hints;
+                XChangeProperty(m_windowing_engine->platform_as<engine_state_x11>()->display, m_window, property,
                                 property, 32, PropModeReplace, (unsigned char *)&hints,
                                 PROP_MWM_HINTS_ELEMENTS);
                 SPDLOG_INFO("DECORATE");
@@ -313,27 +1176,102 @@ namespace kat::window {
                 Atom property;
                 hints.flags = MWM_HINTS_DECORATIONS;
                 hints.decorations = 0;
-                property = XInternAtom(m_windowing_engine->platform->display, _XA_MWM_HINTS, true);
-                XChangeProperty(m_windowing_engine->platform->display, m_window, property,
+                property = m_windowing_engine->platform_as<engine_state_x11>()->atoms.motif_wm_hints;
+                XChangeProperty(m_windowing_engine->platform_as<engine_state_x11>()->display, m_window, property,
                                 property, 32, PropModeReplace, (unsigned char *)&hints,
                                 PROP_MWM_HINTS_ELEMENTS);
                 SPDLOG_INFO("UNDECORATE");
             }
         }
 
+    }
+
+    fullscreen_mode x11::window_x11::fullscreen() const {
+        return m_fullscreen;
+    }
+
+    void x11::window_x11::fullscreen(fullscreen_mode new_mode) {
+        auto* platform = m_windowing_engine->platform_as<engine_state_x11>();
+
+        if (new_mode != fullscreen_mode::exclusive && m_switched_crtc != None) {
+            platform->restore_mode(m_switched_crtc);
+            m_switched_crtc = None;
+        }
+
+        // Bypassing is only a hint, compositors unredirect the window and stop the extra full-screen copy
+        if (new_mode == fullscreen_mode::exclusive) {
+            long bypass = 1;
+            XChangeProperty(platform->display, m_window, platform->atoms.net_wm_bypass_compositor, XA_CARDINAL, 32,
+                            PropModeReplace, reinterpret_cast<unsigned char*>(&bypass), 1);
+        } else {
+            XDeleteProperty(platform->display, m_window, platform->atoms.net_wm_bypass_compositor);
+        }
+
+        bool was_fullscreen = m_fullscreen != fullscreen_mode::windowed;
+        bool is_fullscreen = new_mode != fullscreen_mode::windowed;
+        if (was_fullscreen != is_fullscreen) {
+            platform->send_wm_state(m_window, is_fullscreen, platform->atoms.net_wm_state_fullscreen);
+        }
+
+        m_fullscreen = new_mode;
+        XFlush(platform->display);
+    }
+
+    bool x11::window_x11::fullscreen(const ::kat::window::monitor &monitor, const ::kat::window::video_mode &mode) {
+        auto* platform = m_windowing_engine->platform_as<engine_state_x11>();
+        const auto* found = dynamic_cast<const monitor_x11*>(&monitor);
+        if (!found || found->get_platform() != platform) {
+            SPDLOG_WARN("Exclusive fullscreen asked for on a monitor of another windowing engine");
+            return false;
+        }
+        const auto& target = *found;
+
+        if (m_switched_crtc != None && m_switched_crtc != target.get_crtc()) {
+            platform->restore_mode(m_switched_crtc);
+            m_switched_crtc = None;
+        }
 
+        if (!platform->switch_mode(target, mode)) {
+            return false;
+        }
+        m_switched_crtc = target.get_crtc();
+
+        // window managers fullscreen a window onto the monitor it is on, so put it there first
+        XMoveWindow(platform->display, m_window, target.position().x, target.position().y);
+        fullscreen(fullscreen_mode::exclusive);
+        return true;
     }
 
     void x11::window_x11::restore() {
+        auto* platform = m_windowing_engine->platform_as<engine_state_x11>();
+        if (m_fullscreen != fullscreen_mode::windowed) {
+            fullscreen(fullscreen_mode::windowed);
+        }
 
+        platform->send_wm_state(m_window, false, platform->atoms.net_wm_state_maximized_vert, platform->atoms.net_wm_state_maximized_horz);
+        // mapping an iconified window is how ICCCM says to bring it back
+        XMapRaised(platform->display, m_window);
+        XFlush(platform->display);
     }
 
     void x11::window_x11::maximize() {
-
+        auto* platform = m_windowing_engine->platform_as<engine_state_x11>();
+        platform->send_wm_state(m_window, true, platform->atoms.net_wm_state_maximized_vert, platform->atoms.net_wm_state_maximized_horz);
+        XFlush(platform->display);
     }
 
     void x11::window_x11::minimize() {
+        auto* platform = m_windowing_engine->platform_as<engine_state_x11>();
+        XIconifyWindow(platform->display, m_window, platform->screen_id);
+        XFlush(platform->display);
+    }
+
+    void x11::window_x11::show() {
+        XMapWindow(m_windowing_engine->platform_as<engine_state_x11>()->display, m_window);
+    }
 
+    void x11::window_x11::hide() {
+        XUnmapWindow(m_windowing_engine->platform_as<engine_state_x11>()->display, m_window);
     }
 }
 #endif
\ No newline at end of file
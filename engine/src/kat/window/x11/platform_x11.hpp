@@ -5,68 +5,275 @@
 #ifdef KATWINDOW_TARGET_X11
 
 #include "kat/window/utils.hpp"
+#include "kat/window/events.hpp"
+#include "kat/window/platform.hpp"
+#include "kat/core/spsc_queue.hpp"
 
 #include <X11/Xlib.h>
 #include <X11/extensions/Xrandr.h>
+#include <X11/extensions/XInput2.h>
 #include <vector>
 #include <memory>
 #include <glm/glm.hpp>
 #include <string_view>
 #include <string>
 #include <unordered_map>
+#include <bitset>
+#include <array>
+#include <utility>
+#include <atomic>
+#include <thread>
+#include <optional>
+#include <span>
 
 namespace kat::window {
     struct windowing_engine;
 
     namespace x11 {
-        ::kat::window::video_mode make_video_mode_x11(const XRRModeInfo& mode_info, const XRRCrtcInfo* crtc_info, Screen* screen);
+        ::kat::window::video_mode make_video_mode_x11(const XRRModeInfo& mode_info, Screen* screen);
 
         display_depth make_display_depth_x11(int depth);
 
+        uint16_t make_key_modifiers_x11(unsigned int state);
+
+        /**
+         * Core/XInput2 button number to mouse_button. False for wheel and unknown buttons.
+         */
+        bool make_mouse_button_x11(unsigned int button, mouse_button& out);
+
         class monitor_x11;
+        class window_x11;
+
+        struct stamped_event_x11 {
+            XEvent event;
+            uint64_t timestamp;
+
+            // XInput2 events have to be decoded on the thread that read them, their cookie data is gone after the
+            // next XNextEvent. Those are handed over already translated.
+            bool translated;
+            ::kat::window::event translated_event;
+        };
+
+        /**
+         * Maps X server timestamps onto event_timestamp_now()'s clock, so input is stamped with when the server saw
+         * it rather than when a frame got around to reading it. Server time is milliseconds and wraps every 49.7
+         * days. The offset comes from the first event and is pulled earlier whenever an event would otherwise be
+         * stamped after it was read, which leaves it at the quickest read seen.
+         */
+        class server_clock_x11 {
+        public:
+            uint64_t to_steady(Time server_time, uint64_t read_at);
 
-        struct engine_state_x11 {
-            Display* display;
+        private:
+            bool m_synced = false;
+            uint32_t m_last = 0;
+            int64_t m_extended_ms = 0;
+            int64_t m_offset_ns = 0;
+        };
+
+        /**
+         * Every atom the engine uses, interned with one XInternAtoms round trip when the display is opened so
+         * nothing after that has to ask the server for one.
+         */
+        struct atom_table_x11 {
+            Atom wm_protocols = None;
+            Atom wm_delete_window = None;
+            Atom net_wm_ping = None;
+            Atom net_wm_name = None;
+            Atom net_wm_icon_name = None;
+            Atom net_wm_state = None;
+            Atom net_wm_state_fullscreen = None;
+            Atom net_wm_state_maximized_vert = None;
+            Atom net_wm_state_maximized_horz = None;
+            Atom net_wm_bypass_compositor = None;
+            Atom motif_wm_hints = None;
+            Atom utf8_string = None;
+
+            void intern(Display* display);
+        };
+
+        struct engine_state_x11 final : public platform_state_base<window_x11> {
+            Display* display = nullptr;
             int screen_id;
             Screen* screen;
             Window root;
             std::unordered_map<RRMode, XRRModeInfo> mode_infos;
-            XRRScreenResources* scr_res;
+            XRRScreenResources* scr_res = nullptr;
 
-            std::vector<std::shared_ptr<monitor_x11>> m_monitors;
+            atom_table_x11 atoms;
 
-            engine_state_x11();
+            mutable std::vector<std::shared_ptr<monitor_x11>> m_monitors;
+            mutable bool m_monitors_enumerated = false;
+            mutable uint64_t m_monitors_generation = 0;
+            std::weak_ptr<windowing_engine> m_engine;
+
+            // set when RandR reported a change before anything was enumerated, scr_res is refetched on first use
+            bool m_screen_resources_stale = false;
+
+            explicit engine_state_x11(const windowing_engine_config& config);
             ~engine_state_x11();
 
+            /**
+             * Xft.dpi from the resource database, or KAT_BASE_DPI when it isn't set. Resolved once and kept until
+             * the RESOURCE_MANAGER property on the root window changes.
+             */
             [[nodiscard]] glm::vec2 dpi();
             [[nodiscard]] glm::vec2 scale();
 
-            std::vector<std::shared_ptr<monitor_x11>> monitors() const;
-            void setup(const std::shared_ptr<windowing_engine>& engine);
+            /**
+             * Xft.dpi if the user set one. Cached like dpi().
+             */
+            [[nodiscard]] std::optional<float> xft_dpi();
+
+            /**
+             * Enumerated on first use rather than at startup, most programs open a window long before they care.
+             */
+            [[nodiscard]] std::vector<std::shared_ptr<monitor>> monitors() const override;
+
+            /**
+             * Bumped whenever a monitor is added, removed or changes, so snapshots know when to rebuild.
+             */
+            [[nodiscard]] uint64_t monitors_generation() const override;
+
+            void setup(const std::shared_ptr<windowing_engine>& engine) override;
+
+            void process_events() override;
+
+            /**
+             * Drops any state still pointing at `window`, called as it is destroyed.
+             */
+            void forget_window(Window window);
+
+            /**
+             * Refetches scr_res and adds any modes the server gained to mode_infos. Existing rows are left alone,
+             * mode ids are never reused for different timings while the server is running.
+             */
+            void refresh_screen_resources();
+
+            /**
+             * Output info for `output`, refreshing the screen resources first if it references modes we haven't
+             * seen yet. Free with XRRFreeOutputInfo.
+             */
+            XRROutputInfo* fetch_output_info(RROutput output);
+
+            /**
+             * Asks the window manager to add or remove up to two _NET_WM_STATE atoms on a mapped window.
+             */
+            void send_wm_state(Window window, bool add, Atom first, Atom second = None);
+
+            /**
+             * Starts or stops selecting XInput2 raw mouse events on the root window. Returns false if the server
+             * doesn't have XInput 2.
+             */
+            bool raw_mouse_input(bool enable);
+            [[nodiscard]] bool raw_mouse_input() const;
+
+            [[nodiscard]] const windowing_engine_config& config() const;
+
+            /**
+             * Invisible cursor shown while the pointer is locked, created on first use.
+             */
+            Cursor blank_cursor();
+
+            /**
+             * Switches the crtc driving `monitor` to `mode`. The crtc's original configuration is remembered the
+             * first time and put back by restore_mode() or restore_modes(), when the engine is destroyed, at exit,
+             * or when the process crashes (SIGSEGV, SIGBUS, SIGFPE, SIGILL or SIGABRT, unless the application
+             * already handles or ignores that signal). SIGINT and SIGTERM are left alone, an application that wants
+             * its modes back on those has to shut the engine down. Returns false if the output doesn't offer the
+             * mode or the server refused it.
+             */
+            bool switch_mode(const monitor_x11& monitor, const ::kat::window::video_mode& mode);
+            void restore_mode(RRCrtc crtc);
+            void restore_modes();
+
+        private:
+            void handle_event(const XEvent& event, uint64_t timestamp);
+
+            /**
+             * The server's time for input events that carry one, `read_at` for everything else.
+             */
+            uint64_t event_time(const XEvent& event, uint64_t read_at);
+            void handle_resource_manager_change(uint64_t timestamp);
+
+            /**
+             * Rebuilds m_keysyms from the server's keyboard mapping.
+             */
+            void load_keysyms();
+            void handle_randr_event(const XEvent& event, uint64_t timestamp);
+            bool translate_generic_event(XEvent& event, uint64_t read_at, ::kat::window::event& out);
+            void handle_output_change(const XRROutputChangeNotifyEvent& event, uint64_t timestamp);
+            bool answer_ping(const XEvent& event);
+
+            void event_thread_main();
+            void stop_event_thread();
+
+            windowing_engine_config m_config;
+            std::thread m_event_thread;
+            std::atomic<bool> m_event_thread_running = false;
+            int m_event_thread_wake[2] = { -1, -1 };
+            core::spsc_queue<stamped_event_x11, event_queue::capacity> m_thread_events;
+            std::atomic<std::size_t> m_thread_events_dropped = 0;
+
+            int m_randr_event_base = -1;
+
+            std::optional<float> m_xft_dpi;
+            bool m_xft_dpi_loaded = false;
+
+            // only used by whichever thread reads the connection
+            server_clock_x11 m_server_clock;
+
+            int m_xi_opcode = -1;
+            bool m_raw_mouse_input = false;
+            // read by the event thread to decide whether raw events belong to us
+            std::atomic<Window> m_focus_window = None;
+            Cursor m_blank_cursor = None;
+
+            std::bitset<256> m_keys_down;
+            // unshifted keysym per keycode, the same thing XLookupKeysym(event, 0) answers, refreshed on MappingNotify
+            std::array<KeySym, 256> m_keysyms{};
         };
 
-        int calc_refresh_rate(const XRRModeInfo& modeInfo);
+        mode_timing make_mode_timing_x11(const XRRModeInfo& modeInfo);
+        rational_refresh_rate calc_refresh_rate(const XRRModeInfo& modeInfo);
 
-        class monitor_x11 {
+        class monitor_x11 final : public ::kat::window::monitor {
         public:
             monitor_x11(const std::shared_ptr<windowing_engine>& engine, const XRRMonitorInfo &monitor_info, const XRROutputInfo& output_info, RROutput output);
 
-            [[nodiscard]] glm::vec2 dpi() const;
-            [[nodiscard]] glm::vec2 scale() const;
+            /**
+             * Re-reads everything that comes from the output: crtc, physical size, mode list and current mode.
+             */
+            void update_output(const XRROutputInfo& output_info);
+
+            /**
+             * Applies a crtc change for this monitor's crtc. Returns whether geometry or mode actually changed.
+             */
+            bool handle_crtc_change(const XRRCrtcChangeNotifyEvent& event);
 
-            [[nodiscard]] glm::uvec2 physical_size() const;
-            [[nodiscard]] glm::uvec2 size() const;
-            [[nodiscard]] glm::ivec2 position() const;
+            [[nodiscard]] glm::vec2 dpi() const override;
+            [[nodiscard]] glm::vec2 scale() const override;
 
-            [[nodiscard]] std::string_view name() const;
+            [[nodiscard]] glm::uvec2 physical_size() const override;
+            [[nodiscard]] glm::uvec2 size() const override;
+            [[nodiscard]] glm::ivec2 position() const override;
 
-            [[nodiscard]] bool is_primary() const;
+            [[nodiscard]] std::string_view name() const override;
 
-            [[nodiscard]] ::kat::window::video_mode video_mode() const;
-            [[nodiscard]] std::vector<::kat::window::video_mode> video_modes() const;
+            [[nodiscard]] bool is_primary() const override;
 
+            [[nodiscard]] ::kat::window::video_mode video_mode() const override;
+            /**
+             * Sorted and deduplicated once when the output is read, see sort_video_modes().
+             */
+            [[nodiscard]] std::span<const ::kat::window::video_mode> video_modes() const override;
+            [[nodiscard]] const ::kat::window::video_mode* closest_video_mode(const video_mode_request& request) const override;
+
+            [[nodiscard]] uint64_t id() const override;
 
             [[nodiscard]] RROutput get_output() const;
+            [[nodiscard]] RRCrtc get_crtc() const;
+            [[nodiscard]] engine_state_x11* get_platform() const;
 
         private:
             RROutput m_output;
@@ -78,51 +285,113 @@ namespace kat::window {
             bool m_is_primary;
             Atom m_monitor_idname;
 
-            std::shared_ptr<windowing_engine> m_windowing_engine;
+            // not a shared_ptr, the platform owns its monitors
+            engine_state_x11* m_platform;
             ::kat::window::video_mode m_video_mode;
         };
 
-        class window_x11 {
+        class window_x11 final : public ::kat::window::window {
         public:
 
-            window_x11(const std::shared_ptr<windowing_engine>& engine, std::string_view title_, glm::uvec2 size_, glm::uvec2 position_);
+            /**
+             * Use windowing_engine::create_window(), the engine owns its windows and destroys them before itself.
+             */
+            window_x11(windowing_engine& engine, std::string_view title_, glm::uvec2 size_, glm::ivec2 position_);
             ~window_x11();
 
-            [[nodiscard]] std::string title() const;
-            void title(std::string_view new_title);
-
-            [[nodiscard]] glm::vec2 dpi() const;
-            [[nodiscard]] glm::vec2 scale() const;
-
-            [[nodiscard]] glm::uvec2 size() const;
-            [[nodiscard]] glm::ivec2 position() const;
-
-            void size(glm::uvec2 new_size);
-            void position(glm::ivec2 new_position);
-
-            [[nodiscard]] bool decorated() const;
-            void decorated(bool new_mode);
-
-            void restore();
-            void maximize();
-            void minimize();
-
+            window_x11(const window_x11&) = delete;
+            window_x11& operator=(const window_x11&) = delete;
+
+            /**
+             * The last title set through this window, kept locally rather than read back from _NET_WM_NAME.
+             */
+            [[nodiscard]] std::string title() const override;
+            void title(std::string_view new_title) override;
+
+            [[nodiscard]] glm::vec2 dpi() const override;
+            [[nodiscard]] glm::vec2 scale() const override;
+
+            /**
+             * Size and position are answered from a cache kept up to date by ConfigureNotify events, so they never
+             * talk to the server. Changes requested through the setters show up once the server (and window
+             * manager) have applied them and the resulting events have been processed.
+             */
+            [[nodiscard]] glm::uvec2 size() const override;
+            [[nodiscard]] glm::ivec2 position() const override;
+
+            void size(glm::uvec2 new_size) override;
+            void position(glm::ivec2 new_position) override;
+
+            /**
+             * Refreshes the cached geometry straight from the server. This costs two round trips, only use it when
+             * the authoritative value is needed right now.
+             */
+            void sync_geometry();
+
+            /**
+             * Applies a ConfigureNotify to the geometry cache. Returns which of size/position actually changed.
+             */
+            std::pair<bool, bool> handle_configure(const XConfigureEvent& event);
+            void handle_reparent(const XReparentEvent& event);
+            void handle_focus_in();
+
+            /**
+             * Hides the cursor and keeps it inside the window, for mouselook. Motion is then read from the
+             * raw_mouse_motion events, which this turns on. Returns false if raw input isn't available.
+             */
+            bool pointer_lock(bool lock);
+            [[nodiscard]] bool pointer_locked() const;
+
+            [[nodiscard]] bool decorated() const override;
+            void decorated(bool new_mode) override;
+
+            [[nodiscard]] fullscreen_mode fullscreen() const override;
+
+            /**
+             * borderless covers the monitor the window is on through _NET_WM_STATE_FULLSCREEN. exclusive does the
+             * same and sets _NET_WM_BYPASS_COMPOSITOR so the compositor stops copying the window, keeping the
+             * current mode. windowed goes back to normal and undoes any mode switch made by the overload below.
+             */
+            void fullscreen(fullscreen_mode new_mode) override;
+
+            /**
+             * Switches the monitor's crtc with engine_state_x11::switch_mode(). False without trying when `monitor`
+             * belongs to another backend or another windowing_engine.
+             */
+            bool fullscreen(const ::kat::window::monitor& monitor, const ::kat::window::video_mode& mode) override;
+
+            void restore() override;
+            void maximize() override;
+            void minimize() override;
+
+            void show() override;
+            void hide() override;
 
             [[nodiscard]] Window platform_handle() const;
+            [[nodiscard]] uint64_t native_handle() const override;
 
 
 
         private:
             Window m_window;
-            std::shared_ptr<windowing_engine> m_windowing_engine;
+            windowing_engine* m_windowing_engine;
+            std::string m_title;
+            bool m_title_set = false;
             bool m_decorated = true;
+
+            glm::uvec2 m_size;
+            glm::ivec2 m_position;
+            bool m_reparented = false;
+
+            fullscreen_mode m_fullscreen = fullscreen_mode::windowed;
+            RRCrtc m_switched_crtc = None;
+
+            bool m_pointer_locked = false;
+            bool grab_pointer();
         };
-    }
 
-    using platform_state = x11::engine_state_x11;
-    using monitor = x11::monitor_x11;
-    using window = x11::window_x11;
-    std::vector<std::shared_ptr<monitor>> get_all_monitors(const std::shared_ptr<windowing_engine>& engine);
+        std::vector<std::shared_ptr<monitor_x11>> get_all_monitors_x11(const std::shared_ptr<windowing_engine>& engine);
+    }
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,892 @@
+#include "kat/cfg.hpp"
+#ifdef KATWINDOW_TARGET_XCB
+#include "platform_xcb.hpp"
+#include "kat/window/window.hpp"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+namespace kat::window::xcb {
+    namespace {
+        constexpr std::pair<const char*, xcb_atom_t atom_table_xcb::*> atom_names[] = {
+                { "WM_PROTOCOLS", &atom_table_xcb::wm_protocols },
+                { "WM_DELETE_WINDOW", &atom_table_xcb::wm_delete_window },
+                { "WM_CHANGE_STATE", &atom_table_xcb::wm_change_state },
+                { "_NET_WM_PING", &atom_table_xcb::net_wm_ping },
+                { "_NET_WM_NAME", &atom_table_xcb::net_wm_name },
+                { "_NET_WM_ICON_NAME", &atom_table_xcb::net_wm_icon_name },
+                { "_NET_WM_STATE", &atom_table_xcb::net_wm_state },
+                { "_NET_WM_STATE_FULLSCREEN", &atom_table_xcb::net_wm_state_fullscreen },
+                { "_NET_WM_STATE_MAXIMIZED_VERT", &atom_table_xcb::net_wm_state_maximized_vert },
+                { "_NET_WM_STATE_MAXIMIZED_HORZ", &atom_table_xcb::net_wm_state_maximized_horz },
+                { "_NET_WM_BYPASS_COMPOSITOR", &atom_table_xcb::net_wm_bypass_compositor },
+                { "_MOTIF_WM_HINTS", &atom_table_xcb::motif_wm_hints },
+                { "UTF8_STRING", &atom_table_xcb::utf8_string },
+        };
+
+        // ICCCM WM_STATE values and Motif hint bits, Xlib's headers aren't available to an XCB build
+        constexpr uint32_t iconic_state = 3;
+        constexpr uint32_t mwm_hints_decorations = 1u << 1;
+        constexpr uint32_t mwm_decor_all = 1u << 0;
+
+        // without a length limit GetProperty returns nothing, ask for everything there is
+        constexpr uint32_t whole_property = std::numeric_limits<uint32_t>::max() / 4;
+
+        template<typename T>
+        struct reply_deleter {
+            void operator()(T* reply) const { std::free(reply); }
+        };
+
+        template<typename T>
+        using reply_ptr = std::unique_ptr<T, reply_deleter<T>>;
+
+        /**
+         * Xft.dpi out of the resource database text. Only exact "Xft.dpi:" entries, which is what every desktop
+         * writes; Xrm's wildcard matching isn't worth reimplementing for it.
+         */
+        std::optional<float> parse_xft_dpi(std::string_view resources) {
+            constexpr std::string_view key = "Xft.dpi:";
+            while (!resources.empty()) {
+                auto end = resources.find('\n');
+                auto line = resources.substr(0, end);
+                resources = end == std::string_view::npos ? std::string_view() : resources.substr(end + 1);
+
+                if (!line.starts_with(key)) continue;
+                std::string value(line.substr(key.size()));
+                float parsed = static_cast<float>(std::atof(value.c_str()));
+                if (parsed > 0.f) return parsed;
+            }
+            return std::nullopt;
+        }
+
+        std::optional<float> parse_xft_dpi(xcb_get_property_reply_t* reply) {
+            if (!reply || reply->format != 8) return std::nullopt;
+            auto* data = static_cast<const char*>(xcb_get_property_value(reply));
+            return parse_xft_dpi(std::string_view(data, static_cast<std::size_t>(xcb_get_property_value_length(reply))));
+        }
+
+        /**
+         * Lower case for a lone letter keysym, which stands for both cases. Covers ASCII and Latin-1, XConvertCase
+         * knows more scripts but lives in Xlib.
+         */
+        uint32_t lower_keysym(uint32_t sym) {
+            if (sym >= 'A' && sym <= 'Z') return sym + 0x20;
+            if (sym >= 0xc0 && sym <= 0xde && sym != 0xd7) return sym + 0x20;
+            return sym;
+        }
+
+        display_depth make_display_depth_xcb(uint8_t depth) {
+            if (depth == 32) depth = 24;
+            display_depth dd{};
+            dd.red = dd.green = dd.blue = depth / 3;
+            int delta = depth % 3;
+            if (delta >= 1) {
+                dd.green += 1;
+            }
+
+            if (delta == 2) {
+                dd.red += 1;
+            }
+
+            return dd;
+        }
+    }
+
+    engine_state_xcb::engine_state_xcb(const windowing_engine_config &config) : m_config(config) {
+        KAT_PROFILE_ZONE("engine_state_xcb::engine_state_xcb");
+        connection = xcb_connect(nullptr, &screen_id);
+        if (xcb_connection_has_error(connection)) {
+            SPDLOG_ERROR("Can't connect to the X server");
+            screen = nullptr;
+            root = XCB_WINDOW_NONE;
+            m_app_exit = true;
+            return;
+        }
+
+        const xcb_setup_t* setup = xcb_get_setup(connection);
+        auto roots = xcb_setup_roots_iterator(setup);
+        for (int i = 0 ; i < screen_id ; i++) {
+            xcb_screen_next(&roots);
+        }
+        screen = roots.data;
+        root = screen->root;
+
+        // Everything startup needs goes out before waiting on any of it. The RandR extension query is the only
+        // reply we have to block on, the rest are answered in the same round trip.
+        xcb_prefetch_extension_data(connection, &xcb_randr_id);
+
+        std::array<xcb_intern_atom_cookie_t, std::size(atom_names)> atom_cookies;
+        for (std::size_t i = 0 ; i < atom_cookies.size() ; i++) {
+            atom_cookies[i] = xcb_intern_atom(connection, 0, static_cast<uint16_t>(std::strlen(atom_names[i].first)), atom_names[i].first);
+        }
+
+        auto keyboard_cookie = xcb_get_keyboard_mapping(connection, setup->min_keycode, setup->max_keycode - setup->min_keycode + 1);
+        auto resources_cookie = xcb_get_property(connection, 0, root, XCB_ATOM_RESOURCE_MANAGER, XCB_ATOM_STRING, 0, whole_property);
+
+        // RESOURCE_MANAGER changes are how Xft.dpi updates reach us
+        uint32_t root_events = XCB_EVENT_MASK_PROPERTY_CHANGE;
+        xcb_change_window_attributes(connection, root, XCB_CW_EVENT_MASK, &root_events);
+
+        const auto* randr = xcb_get_extension_data(connection, &xcb_randr_id);
+        xcb_randr_query_version_cookie_t randr_version_cookie{};
+        if (randr && randr->present) {
+            m_randr_event_base = randr->first_event;
+            // the server holds 1.2+ requests to the version we announce, the answer says whether GetMonitors exists
+            randr_version_cookie = xcb_randr_query_version(connection, 1, 5);
+            xcb_randr_select_input(connection, root, XCB_RANDR_NOTIFY_MASK_SCREEN_CHANGE | XCB_RANDR_NOTIFY_MASK_CRTC_CHANGE | XCB_RANDR_NOTIFY_MASK_OUTPUT_CHANGE);
+        } else {
+            SPDLOG_WARN("The X server has no RandR, monitors can't be enumerated");
+        }
+
+        for (std::size_t i = 0 ; i < atom_cookies.size() ; i++) {
+            reply_ptr<xcb_intern_atom_reply_t> reply(xcb_intern_atom_reply(connection, atom_cookies[i], nullptr));
+            if (reply) {
+                atoms.*atom_names[i].second = reply->atom;
+            }
+        }
+
+        if (m_randr_event_base >= 0) {
+            reply_ptr<xcb_randr_query_version_reply_t> version(xcb_randr_query_version_reply(connection, randr_version_cookie, nullptr));
+            if (version) {
+                m_randr_version = { version->major_version, version->minor_version };
+            }
+            if (m_randr_version < std::pair<uint32_t, uint32_t>{1, 3}) {
+                SPDLOG_WARN("The X server only has RandR {}.{}, monitors can't be enumerated before 1.3", m_randr_version.first, m_randr_version.second);
+            } else if (m_randr_version < std::pair<uint32_t, uint32_t>{1, 5}) {
+                SPDLOG_INFO("The X server has RandR {}.{} without monitors, reporting one per output", m_randr_version.first, m_randr_version.second);
+            }
+        }
+
+        reply_ptr<xcb_get_keyboard_mapping_reply_t> keyboard(xcb_get_keyboard_mapping_reply(connection, keyboard_cookie, nullptr));
+        load_keysyms(keyboard.get());
+
+        reply_ptr<xcb_get_property_reply_t> resources(xcb_get_property_reply(connection, resources_cookie, nullptr));
+        m_xft_dpi = parse_xft_dpi(resources.get());
+
+        SPDLOG_DEBUG("Connected to X server over XCB");
+        SPDLOG_DEBUG("Using Default Screen (#{})", screen_id);
+        SPDLOG_DEBUG("Screen Virtual Size: {} x {}", screen->width_in_pixels, screen->height_in_pixels);
+    }
+
+    engine_state_xcb::~engine_state_xcb() {
+        std::free(m_peeked_event);
+        xcb_disconnect(connection);
+        SPDLOG_DEBUG("Closed Display");
+    }
+
+    void engine_state_xcb::setup(const std::shared_ptr<windowing_engine> &engine) {
+        m_engine = engine;
+
+        if (m_config.raw_mouse_input) {
+            SPDLOG_WARN("Raw mouse input is only implemented by the Xlib backend");
+        }
+    }
+
+    glm::vec2 engine_state_xcb::dpi() const {
+        float d = xft_dpi().value_or(KAT_BASE_DPI);
+        return {d, d};
+    }
+
+    glm::vec2 engine_state_xcb::scale() const {
+        return kat::window::conv_dpi_to_scale(dpi());
+    }
+
+    std::optional<float> engine_state_xcb::xft_dpi() const {
+        return m_xft_dpi;
+    }
+
+    std::vector<std::shared_ptr<monitor>> engine_state_xcb::monitors() const {
+        if (!m_monitors_enumerated) {
+            m_monitors = enumerate_monitors();
+            m_monitors_enumerated = true;
+            m_monitors_generation++;
+        }
+
+        return { m_monitors.begin(), m_monitors.end() };
+    }
+
+    uint64_t engine_state_xcb::monitors_generation() const {
+        return m_monitors_generation;
+    }
+
+    std::vector<std::shared_ptr<monitor_xcb>> engine_state_xcb::enumerate_monitors() const {
+        KAT_PROFILE_ZONE("engine_state_xcb::enumerate_monitors");
+        std::vector<std::shared_ptr<monitor_xcb>> monitors;
+        if (m_randr_event_base < 0 || m_randr_version < std::pair<uint32_t, uint32_t>{1, 3}) return monitors;
+        bool has_monitors = m_randr_version >= std::pair<uint32_t, uint32_t>{1, 5};
+
+        // round trip 1: the monitor list (the primary output before 1.5) and the screen resources
+        xcb_randr_get_monitors_cookie_t monitors_cookie{};
+        xcb_randr_get_output_primary_cookie_t primary_cookie{};
+        if (has_monitors) {
+            monitors_cookie = xcb_randr_get_monitors(connection, root, 1);
+        } else {
+            primary_cookie = xcb_randr_get_output_primary(connection, root);
+        }
+        auto resources_cookie = xcb_randr_get_screen_resources_current(connection, root);
+
+        reply_ptr<xcb_randr_get_monitors_reply_t> monitors_reply;
+        xcb_randr_output_t primary_output = XCB_NONE;
+        if (has_monitors) {
+            monitors_reply.reset(xcb_randr_get_monitors_reply(connection, monitors_cookie, nullptr));
+        } else if (reply_ptr<xcb_randr_get_output_primary_reply_t> primary{xcb_randr_get_output_primary_reply(connection, primary_cookie, nullptr)}) {
+            primary_output = primary->output;
+        }
+        reply_ptr<xcb_randr_get_screen_resources_current_reply_t> resources(xcb_randr_get_screen_resources_current_reply(connection, resources_cookie, nullptr));
+        if ((has_monitors && !monitors_reply) || !resources) return monitors;
+
+        // round trip 2: every crtc and every output that is part of a monitor, all in flight at once
+        std::span<const xcb_randr_crtc_t> crtcs(xcb_randr_get_screen_resources_current_crtcs(resources.get()),
+                                                xcb_randr_get_screen_resources_current_crtcs_length(resources.get()));
+        std::vector<xcb_randr_get_crtc_info_cookie_t> crtc_cookies;
+        crtc_cookies.reserve(crtcs.size());
+        for (auto crtc : crtcs) {
+            crtc_cookies.push_back(xcb_randr_get_crtc_info(connection, crtc, resources->config_timestamp));
+        }
+
+        struct pending_output {
+            // null before RandR 1.5, the output's crtc stands in for the monitor then
+            const xcb_randr_monitor_info_t* monitor;
+            xcb_randr_output_t output;
+            xcb_randr_get_output_info_cookie_t cookie;
+        };
+        std::vector<pending_output> outputs;
+        if (has_monitors) {
+            for (auto it = xcb_randr_get_monitors_monitors_iterator(monitors_reply.get()) ; it.rem ; xcb_randr_monitor_info_next(&it)) {
+                auto* ids = xcb_randr_monitor_info_outputs(it.data);
+                for (int i = 0 ; i < xcb_randr_monitor_info_outputs_length(it.data) ; i++) {
+                    outputs.push_back({ it.data, ids[i], xcb_randr_get_output_info(connection, ids[i], resources->config_timestamp) });
+                }
+            }
+        } else {
+            auto* ids = xcb_randr_get_screen_resources_current_outputs(resources.get());
+            for (int i = 0 ; i < xcb_randr_get_screen_resources_current_outputs_length(resources.get()) ; i++) {
+                outputs.push_back({ nullptr, ids[i], xcb_randr_get_output_info(connection, ids[i], resources->config_timestamp) });
+            }
+        }
+
+        std::vector<reply_ptr<xcb_randr_get_crtc_info_reply_t>> crtc_infos;
+        crtc_infos.reserve(crtcs.size());
+        for (auto cookie : crtc_cookies) {
+            crtc_infos.emplace_back(xcb_randr_get_crtc_info_reply(connection, cookie, nullptr));
+        }
+
+        std::span<const xcb_randr_mode_info_t> modes(xcb_randr_get_screen_resources_current_modes(resources.get()),
+                                                     xcb_randr_get_screen_resources_current_modes_length(resources.get()));
+
+        for (const auto& pending : outputs) {
+            reply_ptr<xcb_randr_get_output_info_reply_t> output_info(xcb_randr_get_output_info_reply(connection, pending.cookie, nullptr));
+            if (!output_info || output_info->connection == XCB_RANDR_CONNECTION_DISCONNECTED) continue;
+
+            const xcb_randr_get_crtc_info_reply_t* crtc_info = nullptr;
+            auto crtc = std::find(crtcs.begin(), crtcs.end(), output_info->crtc);
+            if (output_info->crtc != XCB_NONE && crtc != crtcs.end()) {
+                crtc_info = crtc_infos[crtc - crtcs.begin()].get();
+            }
+
+            // the crtc's geometry replaces the monitor's in monitor_xcb, only the primary flag has to be made up
+            xcb_randr_monitor_info_t from_crtc{};
+            const auto* monitor_info = pending.monitor;
+            if (!monitor_info) {
+                // an output without a crtc isn't lit, GetMonitors wouldn't list it either
+                if (!crtc_info) continue;
+                from_crtc.primary = pending.output == primary_output;
+                monitor_info = &from_crtc;
+            }
+
+            monitors.push_back(std::make_shared<monitor_xcb>(const_cast<engine_state_xcb*>(this), *monitor_info, pending.output,
+                                                             *output_info, crtc_info, modes));
+        }
+
+        SPDLOG_DEBUG("Enumerated {} monitors from {} outputs and {} crtcs", monitors.size(), outputs.size(), crtcs.size());
+        return monitors;
+    }
+
+    void engine_state_xcb::process_events() {
+        // nothing we send goes out until the buffer is flushed
+        xcb_flush(connection);
+
+        uint64_t timestamp = event_timestamp_now();
+        while (auto* event = next_event()) {
+            handle_event(event, timestamp);
+            std::free(event);
+        }
+
+        if (!m_app_exit && xcb_connection_has_error(connection)) {
+            SPDLOG_ERROR("Lost the connection to the X server");
+            m_app_exit = true;
+        }
+    }
+
+    xcb_generic_event_t* engine_state_xcb::next_event() {
+        if (m_peeked_event) {
+            return std::exchange(m_peeked_event, nullptr);
+        }
+        return xcb_poll_for_event(connection);
+    }
+
+    void engine_state_xcb::send_root_message(xcb_window_t window, xcb_atom_t type, std::array<uint32_t, 5> data) {
+        xcb_client_message_event_t event{};
+        event.response_type = XCB_CLIENT_MESSAGE;
+        event.format = 32;
+        event.window = window;
+        event.type = type;
+        std::copy(data.begin(), data.end(), event.data.data32);
+        xcb_send_event(connection, 0, root, XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY | XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT,
+                       reinterpret_cast<const char*>(&event));
+    }
+
+    void engine_state_xcb::send_wm_state(xcb_window_t window, bool add, xcb_atom_t first, xcb_atom_t second) {
+        // _NET_WM_STATE_ADD / _NET_WM_STATE_REMOVE, source indication 1 is a normal application
+        send_root_message(window, atoms.net_wm_state, { add ? 1u : 0u, first, second, 1, 0 });
+    }
+
+    bool engine_state_xcb::answer_ping(const xcb_client_message_event_t &event) {
+        if (event.type != atoms.wm_protocols || event.data.data32[0] != atoms.net_wm_ping) {
+            return false;
+        }
+
+        xcb_client_message_event_t reply = event;
+        reply.response_type = XCB_CLIENT_MESSAGE;
+        reply.window = root;
+        xcb_send_event(connection, 0, root, XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY | XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT,
+                       reinterpret_cast<const char*>(&reply));
+        xcb_flush(connection);
+        return true;
+    }
+
+    void engine_state_xcb::load_keysyms(xcb_get_keyboard_mapping_reply_t *reply) {
+        if (!reply) return;
+
+        const xcb_setup_t* setup = xcb_get_setup(connection);
+        const auto* syms = xcb_get_keyboard_mapping_keysyms(reply);
+        int per_keycode = reply->keysyms_per_keycode;
+        int max_keycode = std::min<int>(setup->max_keycode, static_cast<int>(m_keysyms.size()) - 1);
+
+        m_keysyms.fill(XCB_NO_SYMBOL);
+        for (int keycode = setup->min_keycode ; keycode <= max_keycode ; keycode++) {
+            const auto* row = syms + static_cast<std::ptrdiff_t>(keycode - setup->min_keycode) * per_keycode;
+            uint32_t sym = row[0];
+            if (per_keycode == 1 || row[1] == XCB_NO_SYMBOL) {
+                sym = lower_keysym(sym);
+            }
+            m_keysyms[keycode] = sym;
+        }
+        SPDLOG_DEBUG("Loaded keyboard mapping for keycodes {}-{}", setup->min_keycode, max_keycode);
+    }
+
+    void engine_state_xcb::request_keysyms() {
+        const xcb_setup_t* setup = xcb_get_setup(connection);
+        auto cookie = xcb_get_keyboard_mapping(connection, setup->min_keycode, setup->max_keycode - setup->min_keycode + 1);
+        reply_ptr<xcb_get_keyboard_mapping_reply_t> reply(xcb_get_keyboard_mapping_reply(connection, cookie, nullptr));
+        load_keysyms(reply.get());
+    }
+
+    uint16_t make_key_modifiers_xcb(uint16_t state) {
+        uint16_t mods = key_modifier_none;
+        if (state & XCB_MOD_MASK_SHIFT) mods |= key_modifier_shift;
+        if (state & XCB_MOD_MASK_CONTROL) mods |= key_modifier_control;
+        if (state & XCB_MOD_MASK_1) mods |= key_modifier_alt;
+        if (state & XCB_MOD_MASK_4) mods |= key_modifier_super;
+        return mods;
+    }
+
+    bool make_mouse_button_xcb(uint8_t button, mouse_button &out) {
+        switch (button) {
+            case XCB_BUTTON_INDEX_1: out = mouse_button::left; return true;
+            case XCB_BUTTON_INDEX_2: out = mouse_button::middle; return true;
+            case XCB_BUTTON_INDEX_3: out = mouse_button::right; return true;
+            case 8: out = mouse_button::x1; return true;
+            case 9: out = mouse_button::x2; return true;
+            default: return false;
+        }
+    }
+
+    void engine_state_xcb::handle_key(const xcb_key_press_event_t &event, bool down, bool repeat, uint64_t timestamp) {
+        auto ev = make_event(down ? event_type::key_down : event_type::key_up, event.event, timestamp);
+        // X keycodes are evdev codes offset by 8 on every server that still matters
+        ev.key.scancode = event.detail >= 8 ? event.detail - 8 : 0;
+        ev.key.keycode = m_keysyms[event.detail];
+        ev.key.modifiers = make_key_modifiers_xcb(event.state);
+        ev.key.repeat = repeat;
+        m_keys_down[event.detail] = down;
+        m_events.push(ev);
+    }
+
+    void engine_state_xcb::handle_event(const xcb_generic_event_t *event, uint64_t timestamp) {
+        switch (event->response_type & ~0x80) {
+            case XCB_KEY_PRESS: {
+                const auto& ke = *reinterpret_cast<const xcb_key_press_event_t*>(event);
+                handle_key(ke, true, m_keys_down[ke.detail], timestamp);
+                break;
+            }
+            case XCB_KEY_RELEASE: {
+                // Without XKB's detectable auto-repeat a held key arrives as release/press pairs with the same
+                // timestamp. The press is normally in the same packet, so looking at what's already read is enough.
+                const auto& ke = *reinterpret_cast<const xcb_key_release_event_t*>(event);
+                m_peeked_event = xcb_poll_for_queued_event(connection);
+                if (m_peeked_event && (m_peeked_event->response_type & ~0x80) == XCB_KEY_PRESS) {
+                    const auto& next = *reinterpret_cast<const xcb_key_press_event_t*>(m_peeked_event);
+                    if (next.detail == ke.detail && next.time == ke.time && next.event == ke.event) {
+                        handle_key(next, true, true, timestamp);
+                        std::free(std::exchange(m_peeked_event, nullptr));
+                        break;
+                    }
+                }
+                handle_key(ke, false, false, timestamp);
+                break;
+            }
+            case XCB_BUTTON_PRESS:
+            case XCB_BUTTON_RELEASE: {
+                const auto& be = *reinterpret_cast<const xcb_button_press_event_t*>(event);
+                bool press = (event->response_type & ~0x80) == XCB_BUTTON_PRESS;
+                if (be.detail >= XCB_BUTTON_INDEX_4 && be.detail <= 7) {
+                    // wheel clicks come in as press/release pairs, only the press is interesting
+                    if (press) {
+                        auto ev = make_event(event_type::mouse_scroll, be.event, timestamp);
+                        ev.mouse_scroll.y = be.detail == XCB_BUTTON_INDEX_4 ? 1.f : be.detail == XCB_BUTTON_INDEX_5 ? -1.f : 0.f;
+                        ev.mouse_scroll.x = be.detail == 6 ? -1.f : be.detail == 7 ? 1.f : 0.f;
+                        m_events.push(ev);
+                    }
+                    break;
+                }
+
+                mouse_button button;
+                if (!make_mouse_button_xcb(be.detail, button)) break;
+
+                auto ev = make_event(press ? event_type::mouse_button_down : event_type::mouse_button_up, be.event, timestamp);
+                ev.mouse_button.button = button;
+                ev.mouse_button.x = be.event_x;
+                ev.mouse_button.y = be.event_y;
+                m_events.push(ev);
+                break;
+            }
+            case XCB_MOTION_NOTIFY: {
+                const auto& me = *reinterpret_cast<const xcb_motion_notify_event_t*>(event);
+                auto ev = make_event(event_type::mouse_move, me.event, timestamp);
+                ev.mouse_move.x = me.event_x;
+                ev.mouse_move.y = me.event_y;
+                m_events.push(ev);
+                break;
+            }
+            case XCB_CONFIGURE_NOTIFY: {
+                const auto& ce = *reinterpret_cast<const xcb_configure_notify_event_t*>(event);
+                auto* window = m_windows.find(ce.window);
+                if (!window) break;
+
+                auto [resized, moved] = window->handle_configure(ce);
+                if (resized) {
+                    auto ev = make_event(event_type::resize, ce.window, timestamp);
+                    ev.resize.width = ce.width;
+                    ev.resize.height = ce.height;
+                    m_events.push(ev);
+                }
+
+                if (moved) {
+                    auto position = window->position();
+                    auto ev = make_event(event_type::move, ce.window, timestamp);
+                    ev.move.x = position.x;
+                    ev.move.y = position.y;
+                    m_events.push(ev);
+                }
+                break;
+            }
+            case XCB_REPARENT_NOTIFY: {
+                const auto& re = *reinterpret_cast<const xcb_reparent_notify_event_t*>(event);
+                if (auto* window = m_windows.find(re.window)) {
+                    window->handle_reparent(re);
+                }
+                break;
+            }
+            case XCB_FOCUS_IN:
+            case XCB_FOCUS_OUT: {
+                const auto& fe = *reinterpret_cast<const xcb_focus_in_event_t*>(event);
+                // ignore the focus shuffling caused by keyboard grabs
+                if (fe.mode == XCB_NOTIFY_MODE_NORMAL || fe.mode == XCB_NOTIFY_MODE_WHILE_GRABBED) {
+                    bool gained = (event->response_type & ~0x80) == XCB_FOCUS_IN;
+                    m_events.push(make_event(gained ? event_type::focus_gained : event_type::focus_lost, fe.event, timestamp));
+                }
+                break;
+            }
+            case XCB_CLIENT_MESSAGE: {
+                const auto& cm = *reinterpret_cast<const xcb_client_message_event_t*>(event);
+                if (answer_ping(cm)) break;
+                if (cm.type == atoms.wm_protocols && cm.data.data32[0] == atoms.wm_delete_window) {
+                    m_events.push(make_event(event_type::close_requested, cm.window, timestamp));
+                    m_app_exit = true;
+                    SPDLOG_INFO("Exit");
+                }
+                break;
+            }
+            case XCB_MAPPING_NOTIFY: {
+                const auto& me = *reinterpret_cast<const xcb_mapping_notify_event_t*>(event);
+                if (me.request == XCB_MAPPING_KEYBOARD) {
+                    request_keysyms();
+                }
+                break;
+            }
+            case XCB_PROPERTY_NOTIFY: {
+                const auto& pe = *reinterpret_cast<const xcb_property_notify_event_t*>(event);
+                if (pe.window == root && pe.atom == XCB_ATOM_RESOURCE_MANAGER) {
+                    handle_resource_manager_change(timestamp);
+                }
+                break;
+            }
+            default: {
+                int type = event->response_type & ~0x80;
+                if (m_randr_event_base >= 0 && (type == m_randr_event_base + XCB_RANDR_SCREEN_CHANGE_NOTIFY || type == m_randr_event_base + XCB_RANDR_NOTIFY)) {
+                    handle_randr_event(timestamp);
+                }
+                break;
+            }
+        }
+    }
+
+    void engine_state_xcb::handle_randr_event(uint64_t timestamp) {
+        // Re-enumerating costs two round trips whatever changed, so rather than patching monitors one event at a
+        // time the whole list is refetched the next time someone asks. A burst of RandR events is reported once.
+        if (!m_monitors_enumerated) return;
+
+        m_monitors_enumerated = false;
+        m_monitors_generation++;
+        auto ev = make_event(event_type::monitor_changed, 0, timestamp);
+        ev.monitor.monitor = 0;
+        ev.monitor.change = monitor_change::configuration;
+        m_events.push(ev);
+    }
+
+    void engine_state_xcb::handle_resource_manager_change(uint64_t timestamp) {
+        auto cookie = xcb_get_property(connection, 0, root, XCB_ATOM_RESOURCE_MANAGER, XCB_ATOM_STRING, 0, whole_property);
+        reply_ptr<xcb_get_property_reply_t> reply(xcb_get_property_reply(connection, cookie, nullptr));
+        auto new_dpi = parse_xft_dpi(reply.get());
+
+        if (new_dpi != m_xft_dpi) {
+            m_xft_dpi = new_dpi;
+            // monitor DPI depends on it
+            m_monitors_generation++;
+            auto current = dpi();
+            auto ev = make_event(event_type::dpi_changed, 0, timestamp);
+            ev.dpi.x = current.x;
+            ev.dpi.y = current.y;
+            m_events.push(ev);
+            SPDLOG_DEBUG("Xft.dpi changed to {}", current.x);
+        }
+    }
+
+    ::kat::window::video_mode make_video_mode_xcb(const xcb_randr_mode_info_t &mode_info, uint8_t depth) {
+        ::kat::window::video_mode mode{};
+
+        mode.timing.dot_clock = mode_info.dot_clock;
+        mode.timing.htotal = mode_info.htotal;
+        mode.timing.vtotal = mode_info.vtotal;
+        mode.timing.interlaced = (mode_info.mode_flags & XCB_RANDR_MODE_FLAG_INTERLACE) != 0;
+        mode.timing.double_scan = (mode_info.mode_flags & XCB_RANDR_MODE_FLAG_DOUBLE_SCAN) != 0;
+        mode.refresh_rate = mode.timing.refresh_rate();
+        mode.resolution = { mode_info.width, mode_info.height };
+        mode.depth = make_display_depth_xcb(depth);
+
+        return mode;
+    }
+
+    monitor_xcb::monitor_xcb(engine_state_xcb *platform, const xcb_randr_monitor_info_t &monitor_info, xcb_randr_output_t output,
+                             const xcb_randr_get_output_info_reply_t &output_info, const xcb_randr_get_crtc_info_reply_t *crtc_info,
+                             std::span<const xcb_randr_mode_info_t> modes) : m_platform(platform), m_output(output), m_crtc(output_info.crtc) {
+        auto* name = reinterpret_cast<const char*>(xcb_randr_get_output_info_name(&output_info));
+        m_name.assign(name, static_cast<std::size_t>(xcb_randr_get_output_info_name_length(&output_info)));
+        m_physical_size = { output_info.mm_width, output_info.mm_height };
+        m_is_primary = monitor_info.primary;
+        m_position = { monitor_info.x, monitor_info.y };
+        m_size = { monitor_info.width, monitor_info.height };
+
+        auto find_mode = [&](xcb_randr_mode_t id) {
+            return std::find_if(modes.begin(), modes.end(), [id](const xcb_randr_mode_info_t& m) { return m.id == id; });
+        };
+
+        const auto* mode_ids = xcb_randr_get_output_info_modes(&output_info);
+        int mode_count = xcb_randr_get_output_info_modes_length(&output_info);
+        m_video_modes.reserve(mode_count);
+        for (int i = 0 ; i < mode_count ; i++) {
+            auto mode = find_mode(mode_ids[i]);
+            if (mode != modes.end()) {
+                m_video_modes.push_back(make_video_mode_xcb(*mode, platform->screen->root_depth));
+            }
+        }
+        sort_video_modes(m_video_modes);
+
+        if (crtc_info) {
+            auto mode = find_mode(crtc_info->mode);
+            if (mode != modes.end()) {
+                m_video_mode = make_video_mode_xcb(*mode, platform->screen->root_depth);
+                keep_video_mode(m_video_modes, m_video_mode);
+            }
+            m_position = { crtc_info->x, crtc_info->y };
+            m_size = { crtc_info->width, crtc_info->height };
+        }
+    }
+
+    glm::vec2 monitor_xcb::dpi() const {
+        // an explicit Xft.dpi is what every other X client renders with, so it wins over the EDID size
+        if (auto xft = m_platform->xft_dpi()) {
+            return { *xft, *xft };
+        }
+
+        if (m_physical_size.x == 0 || m_physical_size.y == 0) {
+            // projectors and some virtual outputs report no physical size
+            return { KAT_BASE_DPI, KAT_BASE_DPI };
+        }
+
+        return glm::vec2(m_size) / (glm::vec2(m_physical_size) / 25.4f);
+    }
+
+    glm::vec2 monitor_xcb::scale() const {
+        return kat::window::conv_dpi_to_scale(dpi());
+    }
+
+    glm::uvec2 monitor_xcb::physical_size() const {
+        return m_physical_size;
+    }
+
+    glm::uvec2 monitor_xcb::size() const {
+        return m_size;
+    }
+
+    glm::ivec2 monitor_xcb::position() const {
+        return m_position;
+    }
+
+    std::string_view monitor_xcb::name() const {
+        return m_name;
+    }
+
+    bool monitor_xcb::is_primary() const {
+        return m_is_primary;
+    }
+
+    ::kat::window::video_mode monitor_xcb::video_mode() const {
+        return m_video_mode;
+    }
+
+    std::span<const ::kat::window::video_mode> monitor_xcb::video_modes() const {
+        return m_video_modes;
+    }
+
+    const ::kat::window::video_mode* monitor_xcb::closest_video_mode(const video_mode_request &request) const {
+        return find_closest_video_mode(m_video_modes, request);
+    }
+
+    uint64_t monitor_xcb::id() const {
+        return m_output;
+    }
+
+    xcb_randr_output_t monitor_xcb::get_output() const {
+        return m_output;
+    }
+
+    xcb_randr_crtc_t monitor_xcb::get_crtc() const {
+        return m_crtc;
+    }
+}
+
+namespace kat::window {
+    xcb::window_xcb::window_xcb(windowing_engine &engine, std::string_view title_, glm::uvec2 size_, glm::ivec2 position_) : m_windowing_engine(&engine), m_size(size_), m_position(position_) {
+        KAT_PROFILE_ZONE("window_xcb::window_xcb");
+        auto* platform = engine.platform_as<engine_state_xcb>();
+
+        uint32_t event_mask = XCB_EVENT_MASK_STRUCTURE_NOTIFY | XCB_EVENT_MASK_KEY_PRESS | XCB_EVENT_MASK_KEY_RELEASE |
+                              XCB_EVENT_MASK_BUTTON_PRESS | XCB_EVENT_MASK_BUTTON_RELEASE | XCB_EVENT_MASK_POINTER_MOTION |
+                              XCB_EVENT_MASK_FOCUS_CHANGE | XCB_EVENT_MASK_EXPOSURE;
+
+        m_window = xcb_generate_id(platform->connection);
+        xcb_create_window(platform->connection, XCB_COPY_FROM_PARENT, m_window, platform->root,
+                          static_cast<int16_t>(position_.x), static_cast<int16_t>(position_.y),
+                          static_cast<uint16_t>(size_.x), static_cast<uint16_t>(size_.y), 0,
+                          XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_COPY_FROM_PARENT, XCB_CW_EVENT_MASK, &event_mask);
+
+        title(title_);
+        xcb_atom_t protocols[] = { platform->atoms.wm_delete_window, platform->atoms.net_wm_ping };
+        xcb_change_property(platform->connection, XCB_PROP_MODE_REPLACE, m_window, platform->atoms.wm_protocols, XCB_ATOM_ATOM, 32, 2, protocols);
+        xcb_map_window(platform->connection, m_window);
+        xcb_flush(platform->connection);
+    }
+
+    xcb::window_xcb::~window_xcb() {
+        auto* platform = m_windowing_engine->platform_as<engine_state_xcb>();
+        xcb_destroy_window(platform->connection, m_window);
+        xcb_flush(platform->connection);
+    }
+
+    std::string xcb::window_xcb::title() const {
+        return m_title;
+    }
+
+    void xcb::window_xcb::title(std::string_view new_title) {
+        if (new_title == m_title && m_title_set) return;
+        m_title = new_title;
+        m_title_set = true;
+
+        auto* platform = m_windowing_engine->platform_as<engine_state_xcb>();
+        auto length = static_cast<uint32_t>(m_title.size());
+
+        // EWMH window managers show the UTF-8 _NET_WM_NAME, WM_NAME is only there for the ones that predate it
+        xcb_change_property(platform->connection, XCB_PROP_MODE_REPLACE, m_window, platform->atoms.net_wm_name, platform->atoms.utf8_string, 8, length, m_title.data());
+        xcb_change_property(platform->connection, XCB_PROP_MODE_REPLACE, m_window, platform->atoms.net_wm_icon_name, platform->atoms.utf8_string, 8, length, m_title.data());
+        xcb_change_property(platform->connection, XCB_PROP_MODE_REPLACE, m_window, XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 8, length, m_title.data());
+        xcb_flush(platform->connection);
+    }
+
+    glm::vec2 xcb::window_xcb::dpi() const {
+        return m_windowing_engine->platform_as<engine_state_xcb>()->dpi();
+    }
+
+    glm::vec2 xcb::window_xcb::scale() const {
+        return m_windowing_engine->platform_as<engine_state_xcb>()->scale();
+    }
+
+    glm::uvec2 xcb::window_xcb::size() const {
+        return m_size;
+    }
+
+    glm::ivec2 xcb::window_xcb::position() const {
+        return m_position;
+    }
+
+    void xcb::window_xcb::size(glm::uvec2 new_size) {
+        auto* platform = m_windowing_engine->platform_as<engine_state_xcb>();
+        uint32_t values[] = { new_size.x, new_size.y };
+        xcb_configure_window(platform->connection, m_window, XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT, values);
+        xcb_flush(platform->connection);
+    }
+
+    void xcb::window_xcb::position(glm::ivec2 new_position) {
+        auto* platform = m_windowing_engine->platform_as<engine_state_xcb>();
+        uint32_t values[] = { static_cast<uint32_t>(new_position.x), static_cast<uint32_t>(new_position.y) };
+        xcb_configure_window(platform->connection, m_window, XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y, values);
+        xcb_flush(platform->connection);
+    }
+
+    void xcb::window_xcb::sync_geometry() {
+        auto* platform = m_windowing_engine->platform_as<engine_state_xcb>();
+        auto geometry_cookie = xcb_get_geometry(platform->connection, m_window);
+        auto translate_cookie = xcb_translate_coordinates(platform->connection, m_window, platform->root, 0, 0);
+
+        xcb::reply_ptr<xcb_get_geometry_reply_t> geometry(xcb_get_geometry_reply(platform->connection, geometry_cookie, nullptr));
+        xcb::reply_ptr<xcb_translate_coordinates_reply_t> translated(xcb_translate_coordinates_reply(platform->connection, translate_cookie, nullptr));
+        if (geometry) {
+            m_size = { geometry->width, geometry->height };
+        }
+        if (translated) {
+            m_position = { translated->dst_x, translated->dst_y };
+        }
+    }
+
+    std::pair<bool, bool> xcb::window_xcb::handle_configure(const xcb_configure_notify_event_t &event) {
+        glm::uvec2 new_size = { event.width, event.height };
+        bool resized = new_size != m_size;
+        m_size = new_size;
+
+        // Once a window manager has reparented us, real ConfigureNotify coordinates are relative to its frame.
+        // ICCCM requires it to send a synthetic event with root coordinates whenever we move, so only trust those.
+        bool synthetic = (event.response_type & 0x80) != 0;
+        bool moved = false;
+        if (synthetic || !m_reparented) {
+            glm::ivec2 new_position = { event.x, event.y };
+            moved = new_position != m_position;
+            m_position = new_position;
+        }
+
+        return { resized, moved };
+    }
+
+    void xcb::window_xcb::handle_reparent(const xcb_reparent_notify_event_t &event) {
+        m_reparented = event.parent != m_windowing_engine->platform_as<engine_state_xcb>()->root;
+    }
+
+    bool xcb::window_xcb::decorated() const {
+        return m_decorated;
+    }
+
+    void xcb::window_xcb::decorated(bool new_mode) {
+        if (new_mode == m_decorated) return;
+        m_decorated = new_mode;
+
+        // flags, functions, decorations, input mode, status
+        auto* platform = m_windowing_engine->platform_as<engine_state_xcb>();
+        uint32_t hints[5] = { xcb::mwm_hints_decorations, 0, m_decorated ? xcb::mwm_decor_all : 0, 0, 0 };
+        xcb_change_property(platform->connection, XCB_PROP_MODE_REPLACE, m_window, platform->atoms.motif_wm_hints,
+                            platform->atoms.motif_wm_hints, 32, 5, hints);
+        xcb_flush(platform->connection);
+    }
+
+    fullscreen_mode xcb::window_xcb::fullscreen() const {
+        return m_fullscreen;
+    }
+
+    void xcb::window_xcb::fullscreen(fullscreen_mode new_mode) {
+        auto* platform = m_windowing_engine->platform_as<engine_state_xcb>();
+
+        if (new_mode == fullscreen_mode::exclusive) {
+            uint32_t bypass = 1;
+            xcb_change_property(platform->connection, XCB_PROP_MODE_REPLACE, m_window, platform->atoms.net_wm_bypass_compositor,
+                                XCB_ATOM_CARDINAL, 32, 1, &bypass);
+        } else {
+            xcb_delete_property(platform->connection, m_window, platform->atoms.net_wm_bypass_compositor);
+        }
+
+        bool was_fullscreen = m_fullscreen != fullscreen_mode::windowed;
+        bool is_fullscreen = new_mode != fullscreen_mode::windowed;
+        if (was_fullscreen != is_fullscreen) {
+            platform->send_wm_state(m_window, is_fullscreen, platform->atoms.net_wm_state_fullscreen);
+        }
+
+        m_fullscreen = new_mode;
+        xcb_flush(platform->connection);
+    }
+
+    void xcb::window_xcb::restore() {
+        auto* platform = m_windowing_engine->platform_as<engine_state_xcb>();
+        if (m_fullscreen != fullscreen_mode::windowed) {
+            fullscreen(fullscreen_mode::windowed);
+        }
+
+        platform->send_wm_state(m_window, false, platform->atoms.net_wm_state_maximized_vert, platform->atoms.net_wm_state_maximized_horz);
+        // mapping an iconified window is how ICCCM says to bring it back
+        uint32_t stack_mode = XCB_STACK_MODE_ABOVE;
+        xcb_map_window(platform->connection, m_window);
+        xcb_configure_window(platform->connection, m_window, XCB_CONFIG_WINDOW_STACK_MODE, &stack_mode);
+        xcb_flush(platform->connection);
+    }
+
+    void xcb::window_xcb::maximize() {
+        auto* platform = m_windowing_engine->platform_as<engine_state_xcb>();
+        platform->send_wm_state(m_window, true, platform->atoms.net_wm_state_maximized_vert, platform->atoms.net_wm_state_maximized_horz);
+        xcb_flush(platform->connection);
+    }
+
+    void xcb::window_xcb::minimize() {
+        // what XIconifyWindow sends
+        auto* platform = m_windowing_engine->platform_as<engine_state_xcb>();
+        platform->send_root_message(m_window, platform->atoms.wm_change_state, { xcb::iconic_state, 0, 0, 0, 0 });
+        xcb_flush(platform->connection);
+    }
+
+    void xcb::window_xcb::show() {
+        xcb_map_window(m_windowing_engine->platform_as<engine_state_xcb>()->connection, m_window);
+        xcb_flush(m_windowing_engine->platform_as<engine_state_xcb>()->connection);
+    }
+
+    void xcb::window_xcb::hide() {
+        xcb_unmap_window(m_windowing_engine->platform_as<engine_state_xcb>()->connection, m_window);
+        xcb_flush(m_windowing_engine->platform_as<engine_state_xcb>()->connection);
+    }
+
+    xcb_window_t xcb::window_xcb::platform_handle() const {
+        return m_window;
+    }
+
+    uint64_t xcb::window_xcb::native_handle() const {
+        return m_window;
+    }
+}
+#endif
@@ -0,0 +1,271 @@
+#pragma once
+
+#include "kat/cfg.hpp"
+
+#ifdef KATWINDOW_TARGET_XCB
+
+#include "kat/window/utils.hpp"
+#include "kat/window/events.hpp"
+#include "kat/window/platform.hpp"
+
+#include <xcb/xcb.h>
+#include <xcb/randr.h>
+#include <vector>
+#include <memory>
+#include <glm/glm.hpp>
+#include <string_view>
+#include <string>
+#include <bitset>
+#include <array>
+#include <utility>
+#include <optional>
+#include <span>
+
+namespace kat::window {
+    struct windowing_engine;
+
+    namespace xcb {
+        class monitor_xcb;
+        class window_xcb;
+
+        uint16_t make_key_modifiers_xcb(uint16_t state);
+
+        /**
+         * Core button number to mouse_button. False for wheel and unknown buttons.
+         */
+        bool make_mouse_button_xcb(uint8_t button, mouse_button& out);
+
+        ::kat::window::video_mode make_video_mode_xcb(const xcb_randr_mode_info_t& mode_info, uint8_t depth);
+
+        /**
+         * Every atom the engine uses. Interned while the display is opened, in the same round trip as the rest
+         * of the startup queries.
+         */
+        struct atom_table_xcb {
+            xcb_atom_t wm_protocols = XCB_ATOM_NONE;
+            xcb_atom_t wm_delete_window = XCB_ATOM_NONE;
+            xcb_atom_t wm_change_state = XCB_ATOM_NONE;
+            xcb_atom_t net_wm_ping = XCB_ATOM_NONE;
+            xcb_atom_t net_wm_name = XCB_ATOM_NONE;
+            xcb_atom_t net_wm_icon_name = XCB_ATOM_NONE;
+            xcb_atom_t net_wm_state = XCB_ATOM_NONE;
+            xcb_atom_t net_wm_state_fullscreen = XCB_ATOM_NONE;
+            xcb_atom_t net_wm_state_maximized_vert = XCB_ATOM_NONE;
+            xcb_atom_t net_wm_state_maximized_horz = XCB_ATOM_NONE;
+            xcb_atom_t net_wm_bypass_compositor = XCB_ATOM_NONE;
+            xcb_atom_t motif_wm_hints = XCB_ATOM_NONE;
+            xcb_atom_t utf8_string = XCB_ATOM_NONE;
+        };
+
+        /**
+         * Platform state for talking to the X server through XCB.
+         *
+         * Xlib waits for the reply of every request before it returns, so N outputs cost N round trips. Here
+         * requests are all sent first and their replies collected afterwards: opening the display is one round trip
+         * (atoms, RandR version, keyboard mapping and RESOURCE_MANAGER together) and enumerating monitors is two
+         * however many outputs there are, which is what matters on SSH-forwarded and other remote displays.
+         */
+        struct engine_state_xcb final : public platform_state_base<window_xcb> {
+            xcb_connection_t* connection;
+            int screen_id;
+            xcb_screen_t* screen;
+            xcb_window_t root;
+
+            atom_table_xcb atoms;
+
+            mutable std::vector<std::shared_ptr<monitor_xcb>> m_monitors;
+            mutable bool m_monitors_enumerated = false;
+            mutable uint64_t m_monitors_generation = 0;
+            std::weak_ptr<windowing_engine> m_engine;
+
+            explicit engine_state_xcb(const windowing_engine_config& config);
+            ~engine_state_xcb();
+
+            engine_state_xcb(const engine_state_xcb&) = delete;
+            engine_state_xcb& operator=(const engine_state_xcb&) = delete;
+
+            /**
+             * Xft.dpi from RESOURCE_MANAGER, or KAT_BASE_DPI when it isn't set. Fetched with the startup requests
+             * and refreshed when the property changes.
+             */
+            [[nodiscard]] glm::vec2 dpi() const;
+            [[nodiscard]] glm::vec2 scale() const;
+            [[nodiscard]] std::optional<float> xft_dpi() const;
+
+            /**
+             * Enumerated on first use, and again after RandR reports a change.
+             */
+            [[nodiscard]] std::vector<std::shared_ptr<monitor>> monitors() const override;
+            [[nodiscard]] uint64_t monitors_generation() const override;
+
+            void setup(const std::shared_ptr<windowing_engine>& engine) override;
+
+            void process_events() override;
+
+            /**
+             * Asks the window manager to add or remove up to two _NET_WM_STATE atoms on a mapped window.
+             */
+            void send_wm_state(xcb_window_t window, bool add, xcb_atom_t first, xcb_atom_t second = XCB_ATOM_NONE);
+
+            /**
+             * Sends a client message to the root window the way EWMH/ICCCM requests to the window manager go.
+             */
+            void send_root_message(xcb_window_t window, xcb_atom_t type, std::array<uint32_t, 5> data);
+
+        private:
+            /**
+             * One monitor per RandR 1.5 monitor. Servers older than that get one per lit output instead, RandR 1.3
+             * is the least this needs.
+             */
+            std::vector<std::shared_ptr<monitor_xcb>> enumerate_monitors() const;
+
+            void handle_event(const xcb_generic_event_t* event, uint64_t timestamp);
+            void handle_key(const xcb_key_press_event_t& event, bool down, bool repeat, uint64_t timestamp);
+            void handle_randr_event(uint64_t timestamp);
+            void handle_resource_manager_change(uint64_t timestamp);
+            bool answer_ping(const xcb_client_message_event_t& event);
+
+            /**
+             * Rebuilds m_keysyms from a GetKeyboardMapping reply.
+             */
+            void load_keysyms(xcb_get_keyboard_mapping_reply_t* reply);
+            void request_keysyms();
+
+            xcb_generic_event_t* next_event();
+
+            windowing_engine_config m_config;
+
+            int m_randr_event_base = -1;
+            // what the server agreed to, major and minor
+            std::pair<uint32_t, uint32_t> m_randr_version{0, 0};
+
+            std::optional<float> m_xft_dpi;
+
+            // events read ahead while telling auto-repeat apart from real releases
+            xcb_generic_event_t* m_peeked_event = nullptr;
+            std::bitset<256> m_keys_down;
+            // unshifted keysym per keycode, refreshed on MappingNotify
+            std::array<uint32_t, 256> m_keysyms{};
+        };
+
+        class monitor_xcb final : public ::kat::window::monitor {
+        public:
+            monitor_xcb(engine_state_xcb* platform, const xcb_randr_monitor_info_t& monitor_info, xcb_randr_output_t output,
+                        const xcb_randr_get_output_info_reply_t& output_info, const xcb_randr_get_crtc_info_reply_t* crtc_info,
+                        std::span<const xcb_randr_mode_info_t> modes);
+
+            [[nodiscard]] glm::vec2 dpi() const override;
+            [[nodiscard]] glm::vec2 scale() const override;
+
+            [[nodiscard]] glm::uvec2 physical_size() const override;
+            [[nodiscard]] glm::uvec2 size() const override;
+            [[nodiscard]] glm::ivec2 position() const override;
+
+            [[nodiscard]] std::string_view name() const override;
+
+            [[nodiscard]] bool is_primary() const override;
+
+            [[nodiscard]] ::kat::window::video_mode video_mode() const override;
+            /**
+             * Sorted and deduplicated, see sort_video_modes().
+             */
+            [[nodiscard]] std::span<const ::kat::window::video_mode> video_modes() const override;
+            [[nodiscard]] const ::kat::window::video_mode* closest_video_mode(const video_mode_request& request) const override;
+
+            [[nodiscard]] uint64_t id() const override;
+
+            [[nodiscard]] xcb_randr_output_t get_output() const;
+            [[nodiscard]] xcb_randr_crtc_t get_crtc() const;
+
+        private:
+            engine_state_xcb* m_platform;
+            xcb_randr_output_t m_output;
+            xcb_randr_crtc_t m_crtc;
+            glm::uvec2 m_physical_size, m_size;
+            glm::ivec2 m_position;
+            std::string m_name;
+            bool m_is_primary;
+            std::vector<::kat::window::video_mode> m_video_modes;
+            ::kat::window::video_mode m_video_mode{};
+        };
+
+        class window_xcb final : public ::kat::window::window {
+        public:
+            /**
+             * Use windowing_engine::create_window(), the engine owns its windows and destroys them before itself.
+             */
+            window_xcb(windowing_engine& engine, std::string_view title_, glm::uvec2 size_, glm::ivec2 position_);
+            ~window_xcb();
+
+            window_xcb(const window_xcb&) = delete;
+            window_xcb& operator=(const window_xcb&) = delete;
+
+            /**
+             * The last title set through this window, kept locally rather than read back from _NET_WM_NAME.
+             */
+            [[nodiscard]] std::string title() const override;
+            void title(std::string_view new_title) override;
+
+            [[nodiscard]] glm::vec2 dpi() const override;
+            [[nodiscard]] glm::vec2 scale() const override;
+
+            /**
+             * Answered from a cache kept current by ConfigureNotify, like window_x11.
+             */
+            [[nodiscard]] glm::uvec2 size() const override;
+            [[nodiscard]] glm::ivec2 position() const override;
+
+            void size(glm::uvec2 new_size) override;
+            void position(glm::ivec2 new_position) override;
+
+            /**
+             * Refreshes the cached geometry from the server. Both requests are in flight together, one round trip.
+             */
+            void sync_geometry();
+
+            /**
+             * Applies a ConfigureNotify to the geometry cache. Returns which of size/position actually changed.
+             */
+            std::pair<bool, bool> handle_configure(const xcb_configure_notify_event_t& event);
+            void handle_reparent(const xcb_reparent_notify_event_t& event);
+
+            [[nodiscard]] bool decorated() const override;
+            void decorated(bool new_mode) override;
+
+            [[nodiscard]] fullscreen_mode fullscreen() const override;
+
+            /**
+             * Through _NET_WM_STATE_FULLSCREEN. exclusive also sets _NET_WM_BYPASS_COMPOSITOR; mode switching is
+             * only implemented by the Xlib backend.
+             */
+            void fullscreen(fullscreen_mode new_mode) override;
+            // no mode switching here, the monitor overload stays the default that refuses
+            using ::kat::window::window::fullscreen;
+
+            void restore() override;
+            void maximize() override;
+            void minimize() override;
+
+            void show() override;
+            void hide() override;
+
+            [[nodiscard]] xcb_window_t platform_handle() const;
+            [[nodiscard]] uint64_t native_handle() const override;
+
+        private:
+            windowing_engine* m_windowing_engine;
+            xcb_window_t m_window;
+            std::string m_title;
+            bool m_title_set = false;
+            bool m_decorated = true;
+
+            glm::uvec2 m_size;
+            glm::ivec2 m_position;
+            bool m_reparented = false;
+
+            fullscreen_mode m_fullscreen = fullscreen_mode::windowed;
+        };
+    }
+}
+
+#endif
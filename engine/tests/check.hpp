@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdio>
+
+namespace kat::tests {
+    inline int failures = 0;
+}
+
+/**
+ * Reports a failed condition and keeps going, so one run lists every broken case. Tests return
+ * kat::tests::failures from main, which is what ctest looks at.
+ */
+#define KAT_CHECK(condition)                                                                            \
+    do {                                                                                                \
+        if (!(condition)) {                                                                             \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);          \
+            ::kat::tests::failures++;                                                                   \
+        }                                                                                               \
+    } while (false)
@@ -0,0 +1,77 @@
+#include "check.hpp"
+
+#include "kat/window/window.hpp"
+#include "kat/window/headless/platform_headless.hpp"
+#include "kat/window/headless/framebuffer_headless.hpp"
+
+#include <chrono>
+#include <vector>
+
+using namespace kat::window;
+
+int main() {
+    windowing_engine_config config;
+    config.backend = "headless";
+
+    auto engine = windowing_engine::create(config);
+    KAT_CHECK(engine->active_backend().name == "headless");
+
+    auto* platform = engine->platform_as<headless::engine_state_headless>();
+    platform->fixed_clock(std::chrono::milliseconds(16));
+
+    auto handle = engine->create_window("test", {64, 32}, {0, 0});
+    auto* window = static_cast<headless::window_headless*>(engine->get_window(handle));
+    KAT_CHECK(window != nullptr);
+    if (!window) return kat::tests::failures;
+
+    // creating the window reports it focused, get that out of the way first
+    engine->process_events();
+    event e;
+    while (engine->poll_event(e)) {}
+
+    // injected events come back from poll_event on the frame they were scheduled for, in order
+    platform->inject_key(window->native_handle(), 30, true);
+    platform->inject_key(window->native_handle(), 30, false, key_modifier_shift, 1);
+    platform->inject_close(window->native_handle(), 2);
+
+    std::vector<std::vector<event>> frames;
+    while (!engine->is_app_exit() && frames.size() < 5) {
+        engine->process_events();
+        auto& frame = frames.emplace_back();
+        while (engine->poll_event(e)) frame.push_back(e);
+    }
+
+    KAT_CHECK(frames.size() == 3);
+    if (frames.size() == 3) {
+        KAT_CHECK(frames[0].size() == 1 && frames[0][0].type == event_type::key_down && frames[0][0].key.scancode == 30);
+        KAT_CHECK(frames[1].size() == 1 && frames[1][0].type == event_type::key_up && frames[1][0].key.modifiers == key_modifier_shift);
+        KAT_CHECK(frames[2].size() == 1 && frames[2][0].type == event_type::close_requested);
+        // one fixed step per frame
+        KAT_CHECK(frames[1][0].timestamp - frames[0][0].timestamp == 16'000'000);
+        KAT_CHECK(frames[0][0].window == window->native_handle());
+    }
+
+    // what a framebuffer presents is what contents() reads back
+    headless::framebuffer_headless framebuffer(*window);
+    auto size = framebuffer.size();
+    auto stride = framebuffer.stride();
+    auto pixels = framebuffer.pixels();
+    for (uint32_t y = 0 ; y < size.y ; y++) {
+        for (uint32_t x = 0 ; x < size.x ; x++) pixels[y * stride + x] = (y << 8) | x;
+    }
+    framebuffer.present();
+
+    KAT_CHECK(window->presented_frames() == 1);
+    KAT_CHECK(window->contents_size() == glm::uvec2(64, 32));
+    auto contents = window->contents();
+    KAT_CHECK(contents.size() >= std::size_t(size.x) * size.y);
+    if (contents.size() >= std::size_t(size.x) * size.y) {
+        bool same = true;
+        for (uint32_t y = 0 ; y < size.y ; y++) {
+            for (uint32_t x = 0 ; x < size.x ; x++) same &= contents[y * stride + x] == ((y << 8) | x);
+        }
+        KAT_CHECK(same);
+    }
+
+    return kat::tests::failures;
+}
@@ -0,0 +1,66 @@
+#include "check.hpp"
+
+#include "kat/window/utils.hpp"
+
+using namespace kat::window;
+
+namespace {
+    void fractions() {
+        rational_refresh_rate ntsc{60000, 1001};
+
+        KAT_CHECK(ntsc != (rational_refresh_rate{60, 1}));
+        KAT_CHECK((ntsc == rational_refresh_rate{120000, 2002}));
+        KAT_CHECK(ntsc.rounded() == 60);
+        KAT_CHECK(ntsc.hz() > 59.94 && ntsc.hz() < 59.9401);
+        KAT_CHECK(ntsc.period().count() == 16'683'333);
+
+        KAT_CHECK((rational_refresh_rate{60, 1}.period().count() == 16'666'667));
+        KAT_CHECK((rational_refresh_rate{144, 1}.period().count() == 6'944'444));
+
+        // unknown rates
+        KAT_CHECK((rational_refresh_rate{0, 1}.period().count() == 0));
+        KAT_CHECK((rational_refresh_rate{60, 0}.hz() == 0.0));
+        KAT_CHECK((rational_refresh_rate{60, 0}.rounded() == 0));
+    }
+
+    void timings() {
+        // CEA 1080p60
+        mode_timing p60{ 148'500'000, 2200, 1125 };
+        KAT_CHECK((p60.refresh_rate() == rational_refresh_rate{60, 1}));
+        KAT_CHECK(p60.refresh_rate().denominator == 1);
+
+        // a whole-Hz dot clock can't hit 1000/1001 exactly, but it must not collapse into 60 either
+        mode_timing p5994{ 148'351'648, 2200, 1125 };
+        KAT_CHECK(p5994.refresh_rate() != (rational_refresh_rate{60, 1}));
+        KAT_CHECK(p5994.refresh_rate().rounded() == 60);
+        // with the exact NTSC clock the fraction is exact too
+        KAT_CHECK((mode_timing{ 148'500'000 * 1000ull, 2200 * 1001, 1125 }.refresh_rate() == rational_refresh_rate{60000, 1001}));
+
+        // 1080i scans two fields per frame
+        mode_timing i60{ 74'250'000, 2200, 1125, true };
+        KAT_CHECK((i60.refresh_rate() == rational_refresh_rate{60, 1}));
+
+        // double scan draws every line twice
+        mode_timing dbl{ 25'175'000, 800, 525, false, true };
+        KAT_CHECK((dbl.refresh_rate() == rational_refresh_rate{25'175'000, 840'000}));
+
+        // no dot clock or no totals means unknown, not a division by zero
+        KAT_CHECK((mode_timing{}.refresh_rate() == rational_refresh_rate{0, 1}));
+        KAT_CHECK((mode_timing{ 148'500'000, 0, 1125 }.refresh_rate().numerator == 0));
+    }
+
+    void periods() {
+        video_mode mode{};
+        KAT_CHECK(refresh_period(mode).count() == 16'666'667);
+
+        mode.refresh_rate = {60000, 1001};
+        KAT_CHECK(refresh_period(mode).count() == 16'683'333);
+    }
+}
+
+int main() {
+    fractions();
+    timings();
+    periods();
+    return kat::tests::failures;
+}
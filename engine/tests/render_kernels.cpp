@@ -0,0 +1,89 @@
+#include "check.hpp"
+
+#include "kat/render/kernels.hpp"
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace kat::render;
+
+namespace {
+    // covers empty spans, spans shorter than one vector and every tail length after the vector loops
+    constexpr std::size_t max_count = 67;
+    // so spans also start off vector alignment
+    constexpr std::size_t max_offset = 7;
+
+    std::vector<uint32_t> random_pixels(std::mt19937& rng, std::size_t count) {
+        std::vector<uint32_t> pixels(count);
+        for (auto& pixel : pixels) pixel = rng();
+        return pixels;
+    }
+
+    void scalar_matches_reference(std::mt19937& rng) {
+        const auto& scalar = scalar_kernels();
+
+        auto dst = random_pixels(rng, max_count);
+        auto src = random_pixels(rng, max_count);
+        // the edges of the alpha range are where rounding mistakes show
+        src[0] &= 0x00ffffff;
+        src[1] |= 0xff000000;
+
+        auto expected = dst;
+        for (std::size_t i = 0 ; i < max_count ; i++) expected[i] = detail::blend_pixel(dst[i], src[i]);
+
+        scalar.blend(dst.data(), src.data(), max_count);
+        KAT_CHECK(dst == expected);
+    }
+
+    void matches_scalar(const kernel_table& kernels, std::mt19937& rng) {
+        const auto& scalar = scalar_kernels();
+        std::string isa(to_string(kernels.isa));
+
+        for (std::size_t offset = 0 ; offset <= max_offset ; offset++) {
+            for (std::size_t count = 0 ; count <= max_count ; count++) {
+                auto base = random_pixels(rng, offset + count + max_offset);
+                auto src = random_pixels(rng, offset + count);
+                uint32_t color = rng();
+
+                auto expected = base, actual = base;
+                scalar.fill(expected.data() + offset, count, color);
+                kernels.fill(actual.data() + offset, count, color);
+                if (expected != actual) {
+                    std::fprintf(stderr, "%s fill differs at offset %zu count %zu\n", isa.c_str(), offset, count);
+                }
+                KAT_CHECK(expected == actual);
+
+                expected = base, actual = base;
+                scalar.blend(expected.data() + offset, src.data() + offset, count);
+                kernels.blend(actual.data() + offset, src.data() + offset, count);
+                if (expected != actual) {
+                    std::fprintf(stderr, "%s blend differs at offset %zu count %zu\n", isa.c_str(), offset, count);
+                }
+                KAT_CHECK(expected == actual);
+
+                expected = base, actual = base;
+                scalar.blend_solid(expected.data() + offset, count, color);
+                kernels.blend_solid(actual.data() + offset, count, color);
+                if (expected != actual) {
+                    std::fprintf(stderr, "%s blend_solid differs at offset %zu count %zu\n", isa.c_str(), offset, count);
+                }
+                KAT_CHECK(expected == actual);
+            }
+        }
+    }
+}
+
+int main() {
+    std::mt19937 rng(0x6b6174);
+
+    scalar_matches_reference(rng);
+
+    for (const auto* kernels : { sse2_kernels(), avx2_kernels() }) {
+        if (!kernels || !is_supported(kernels->isa)) continue;
+        std::printf("checking %s against scalar\n", std::string(to_string(kernels->isa)).c_str());
+        matches_scalar(*kernels, rng);
+    }
+    return kat::tests::failures;
+}
@@ -0,0 +1,121 @@
+#include "check.hpp"
+
+#include "kat/render/software_renderer.hpp"
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace kat::render;
+
+namespace {
+    constexpr glm::uvec2 target_size{12, 8};
+    // wider than the target so writes past a row's end show up in the padding
+    constexpr uint32_t target_stride = 16;
+    constexpr uint32_t padding = 0xdeadbeef;
+
+    constexpr uint32_t black = rgba(0, 0, 0);
+    constexpr uint32_t blue = rgba(0, 0, 255);
+    constexpr uint32_t red = rgba(255, 0, 0);
+    constexpr uint32_t green = rgba(0, 255, 0);
+    constexpr uint32_t half_white = rgba(255, 255, 255, 128);
+    // half_white over black
+    constexpr uint32_t grey = rgba(128, 128, 128);
+
+    uint32_t color_of(char c) {
+        switch (c) {
+            case 'B': return blue;
+            case 'R': return red;
+            case 'G': return green;
+            case 'w': return grey;
+            default: return black;
+        }
+    }
+
+    std::vector<uint32_t> make_target() {
+        return std::vector<uint32_t>(static_cast<std::size_t>(target_stride) * target_size.y, padding);
+    }
+
+    bool matches(const std::vector<uint32_t>& pixels, const std::vector<std::string_view>& golden, std::string_view what, kernel_isa isa) {
+        bool same = true;
+        for (uint32_t y = 0 ; y < target_size.y ; y++) {
+            for (uint32_t x = 0 ; x < target_stride ; x++) {
+                uint32_t expected = x < target_size.x ? color_of(golden[y][x]) : padding;
+                uint32_t actual = pixels[y * target_stride + x];
+                if (actual != expected) {
+                    std::fprintf(stderr, "%s (%s): pixel %u,%u is %08x, expected %08x\n", std::string(what).c_str(),
+                                 std::string(to_string(isa)).c_str(), x, y, actual, expected);
+                    same = false;
+                }
+            }
+        }
+        return same;
+    }
+
+    void scene(const software_renderer& renderer) {
+        auto pixels = make_target();
+        surface target(pixels.data(), target_size, target_stride);
+
+        renderer.clear(target, black);
+
+        // clipped on the top and left
+        std::vector<uint32_t> square(9, blue);
+        renderer.blit(target, const_surface(square.data(), {3, 3}, 3), {-1, -1});
+
+        // clipped on the bottom and right
+        renderer.fill_rect(target, {9, 5}, {10, 10}, red);
+
+        renderer.fill_triangle(target, {2, 2}, {10, 2}, {2, 6}, green);
+
+        // transparent source pixels leave the target alone
+        std::vector<uint32_t> overlay{ half_white, rgba(255, 255, 255, 0) };
+        renderer.blend(target, const_surface(overlay.data(), {2, 1}, 2), {5, 7});
+
+        KAT_CHECK(matches(pixels, {
+            "BB..........",
+            "BB..........",
+            "..GGGGGGG...",
+            "..GGGGG.....",
+            "..GGG.......",
+            "..G......RRR",
+            ".........RRR",
+            ".....w...RRR",
+        }, "scene", renderer.isa()));
+    }
+
+    // Two translucent triangles sharing a diagonal: every pixel of the rectangle they make up is blended exactly
+    // once, never twice and never skipped.
+    void shared_edge(const software_renderer& renderer) {
+        auto pixels = make_target();
+        surface target(pixels.data(), target_size, target_stride);
+
+        renderer.clear(target, black);
+        renderer.fill_triangle(target, {2, 2}, {10, 2}, {2, 6}, half_white);
+        renderer.fill_triangle(target, {10, 2}, {10, 6}, {2, 6}, half_white);
+
+        KAT_CHECK(matches(pixels, {
+            "............",
+            "............",
+            "..wwwwwwww..",
+            "..wwwwwwww..",
+            "..wwwwwwww..",
+            "..wwwwwwww..",
+            "............",
+            "............",
+        }, "shared_edge", renderer.isa()));
+    }
+}
+
+int main() {
+    for (auto isa : { kernel_isa::scalar, kernel_isa::sse2, kernel_isa::avx2 }) {
+        if (!is_supported(isa)) continue;
+
+        software_renderer renderer(isa);
+        KAT_CHECK(renderer.isa() == isa);
+
+        scene(renderer);
+        shared_edge(renderer);
+    }
+    return kat::tests::failures;
+}
@@ -0,0 +1,136 @@
+#include "check.hpp"
+
+#include "kat/window/utils.hpp"
+
+#include <vector>
+
+using namespace kat::window;
+
+namespace {
+    video_mode make_mode(uint32_t width, uint32_t height, uint64_t numerator, uint64_t denominator = 1, uint32_t bits = 8) {
+        video_mode mode{};
+        mode.resolution = {width, height};
+        mode.refresh_rate = {numerator, denominator};
+        mode.depth = {bits, bits, bits};
+        return mode;
+    }
+
+    void sorting() {
+        std::vector<video_mode> modes{
+            make_mode(1920, 1080, 60),
+            make_mode(1280, 720, 60),
+            make_mode(1920, 1080, 60000, 1001),
+            make_mode(1920, 1080, 59940, 1000), // another way of writing 59.94
+            make_mode(1920, 1080, 5994, 100),   // 59.94, not quite 60000/1001
+            make_mode(1920, 1080, 60),
+            make_mode(1920, 1080, 144),
+        };
+        sort_video_modes(modes);
+
+        KAT_CHECK(modes.size() == 4);
+        if (modes.size() != 4) return;
+
+        KAT_CHECK(modes[0].resolution == glm::uvec2(1280, 720));
+        KAT_CHECK(modes[1].resolution == glm::uvec2(1920, 1080));
+        // near-identical rates collapse into the lowest, 59.94 and 60 don't
+        KAT_CHECK((modes[1].refresh_rate == rational_refresh_rate{5994, 100}));
+        KAT_CHECK((modes[2].refresh_rate == rational_refresh_rate{60, 1}));
+        KAT_CHECK((modes[3].refresh_rate == rational_refresh_rate{144, 1}));
+    }
+
+    void interlaced_kept_apart() {
+        auto interlaced = make_mode(1920, 1080, 60);
+        interlaced.timing.interlaced = true;
+
+        std::vector<video_mode> modes{ interlaced, make_mode(1920, 1080, 60) };
+        sort_video_modes(modes);
+
+        KAT_CHECK(modes.size() == 2);
+        if (modes.size() != 2) return;
+        KAT_CHECK(!modes[0].timing.interlaced);
+        KAT_CHECK(modes[1].timing.interlaced);
+    }
+
+    void current_mode_kept() {
+        auto current = make_mode(1920, 1080, 5995, 100);
+        std::vector<video_mode> modes{
+            make_mode(1920, 1080, 5994, 100),
+            current,
+            make_mode(1920, 1080, 60),
+            make_mode(1280, 720, 60),
+        };
+        sort_video_modes(modes);
+        KAT_CHECK(modes.size() == 3);
+
+        // the variant the monitor is in replaces the one it was merged into, in place
+        keep_video_mode(modes, current);
+        KAT_CHECK(modes.size() == 3);
+        if (modes.size() != 3) return;
+        KAT_CHECK(modes[1] == current);
+        KAT_CHECK((modes[2].refresh_rate == rational_refresh_rate{60, 1}));
+
+        keep_video_mode(modes, current);
+        KAT_CHECK(modes.size() == 3);
+
+        // a mode the table doesn't have at all is added in order
+        auto missing = make_mode(1600, 900, 60);
+        keep_video_mode(modes, missing);
+        KAT_CHECK(modes.size() == 4);
+        if (modes.size() != 4) return;
+        KAT_CHECK(modes[1] == missing);
+    }
+
+    void closest() {
+        std::vector<video_mode> modes{
+            make_mode(1280, 720, 60),
+            make_mode(1920, 1080, 60000, 1001),
+            make_mode(1920, 1080, 60),
+            make_mode(1920, 1080, 144),
+            make_mode(1920, 1080, 60, 1, 10),
+            make_mode(2560, 1440, 60),
+        };
+        sort_video_modes(modes);
+
+        KAT_CHECK(find_closest_video_mode({}, {}) == nullptr);
+
+        // nothing asked for: largest resolution, then fastest rate
+        auto* mode = find_closest_video_mode(modes, {});
+        KAT_CHECK(mode && mode->resolution == glm::uvec2(2560, 1440));
+
+        video_mode_request request{};
+        request.resolution = {1920, 1080};
+        mode = find_closest_video_mode(modes, request);
+        KAT_CHECK(mode && (mode->refresh_rate == rational_refresh_rate{144, 1}));
+
+        request.refresh_rate = {60000, 1001};
+        mode = find_closest_video_mode(modes, request);
+        KAT_CHECK(mode && (mode->refresh_rate == rational_refresh_rate{60000, 1001}));
+
+        request.refresh_rate = {60, 1};
+        request.bits_per_pixel = 24;
+        mode = find_closest_video_mode(modes, request);
+        KAT_CHECK(mode && (mode->refresh_rate == rational_refresh_rate{60, 1}) && mode->depth.red == 8);
+
+        request.bits_per_pixel = 0;
+        mode = find_closest_video_mode(modes, request);
+        KAT_CHECK(mode && mode->depth.red == 10);
+
+        // no exact match: nearest in area
+        request = {};
+        request.resolution = {1700, 1000};
+        mode = find_closest_video_mode(modes, request);
+        KAT_CHECK(mode && mode->resolution == glm::uvec2(1920, 1080));
+
+        request.resolution = {640, 480};
+        mode = find_closest_video_mode(modes, request);
+        KAT_CHECK(mode && mode->resolution == glm::uvec2(1280, 720));
+    }
+}
+
+int main() {
+    sorting();
+    interlaced_kept_apart();
+    current_mode_kept();
+    closest();
+    return kat::tests::failures;
+}
@@ -1,7 +1,10 @@
 #include "game/game.hpp"
 #include "spdlog/spdlog.h"
 
-#include <kat/window/window.hpp>
+#include <kat/engine.hpp>
+#include <kat/core/frame_pacer.hpp>
+#include <kat/input/keyboard.hpp>
+#include <kat/input/gamepad.hpp>
 
 #include <spdlog/cfg/env.h>
 
@@ -11,72 +14,106 @@
 int main() {
     spdlog::cfg::load_env_levels();
 
-    std::shared_ptr<kat::window::windowing_engine> windowing_engine = kat::window::windowing_engine::create();
+    std::shared_ptr<kat::engine> engine = kat::engine::create();
+    std::shared_ptr<kat::window::windowing_engine> windowing_engine = engine->windowing;
+    if (windowing_engine->is_app_exit()) {
+        SPDLOG_ERROR("No windowing system to run on");
+        return EXIT_FAILURE;
+    }
 
-    auto monitors = windowing_engine->monitors();
+    auto monitors = windowing_engine->monitor_infos();
 
     printf("Found %zu monitors\n", monitors.size());
     int i = 0;
     for (const auto& mon : monitors) {
-        printf("Monitor #%d: %s\n", i, mon->name().data());
-        printf("  Size: %d x %d\n", mon->size().x, mon->size().y);
-        printf("  Physical Size: %d x %d\n", mon->physical_size().x, mon->physical_size().y);
-        printf("  Position: %d x %d\n", mon->position().x, mon->position().y);
-        printf("  Dpi: %f x %f\n", mon->dpi().x, mon->dpi().y);
-        printf("  Scale: %f x %f\n", mon->scale().x, mon->scale().y);
-        printf("  Primary: %s\n", mon->is_primary() ? "true" : "false");
+        printf("Monitor #%d: %s\n", i, mon.name().data());
+        printf("  Size: %d x %d\n", mon.size.x, mon.size.y);
+        printf("  Physical Size: %d x %d\n", mon.physical_size.x, mon.physical_size.y);
+        printf("  Position: %d x %d\n", mon.position.x, mon.position.y);
+        printf("  Dpi: %f x %f\n", mon.dpi.x, mon.dpi.y);
+        printf("  Scale: %f x %f\n", mon.scale.x, mon.scale.y);
+        printf("  Primary: %s\n", mon.primary ? "true" : "false");
         printf("  Video Modes:\n");
-        kat::window::video_mode current = mon->video_mode();
-        auto video_modes = mon->video_modes();
-        for (const auto& vm : video_modes) {
-            if (vm == current) {
-                printf("    %d x %d @ %d [%d,%d,%d]*\n", vm.resolution.x, vm.resolution.y, vm.refresh_rate, vm.depth.red, vm.depth.green, vm.depth.blue);
+        for (const auto& vm : windowing_engine->video_modes(mon)) {
+            if (vm == mon.current_mode) {
+                printf("    %d x %d @ %.3f [%d,%d,%d]*\n", vm.resolution.x, vm.resolution.y, vm.refresh_rate.hz(), vm.depth.red, vm.depth.green, vm.depth.blue);
             } else {
-                printf("    %d x %d @ %d [%d,%d,%d]\n", vm.resolution.x, vm.resolution.y, vm.refresh_rate, vm.depth.red, vm.depth.green, vm.depth.blue);
+                printf("    %d x %d @ %.3f [%d,%d,%d]\n", vm.resolution.x, vm.resolution.y, vm.refresh_rate.hz(), vm.depth.red, vm.depth.green, vm.depth.blue);
             }
         }
     }
 
 
-    auto window = std::make_shared<kat::window::window>(windowing_engine, "hello!", glm::uvec2{800, 800}, glm::ivec2(100, 100));
+    auto window_handle = windowing_engine->create_window("hello!", glm::uvec2{800, 800}, glm::ivec2(100, 100));
+    auto* window = windowing_engine->get_window(window_handle);
+
+    auto pace_to_monitor = [&](kat::core::frame_pacer& pacer) {
+        if (auto mon = windowing_engine->monitor_for(*window)) {
+            pacer.period(kat::window::refresh_period(mon->current_mode));
+        }
+    };
+
+    kat::core::frame_pacer pacer(std::chrono::milliseconds(16));
+    pace_to_monitor(pacer);
+
+    kat::input::keyboard keyboard;
+    kat::input::gamepads gamepads;
 
     while (!windowing_engine->is_app_exit()) {
         windowing_engine->process_events();
+        keyboard.begin_frame();
+        gamepads.begin_frame();
+
+        kat::window::event event{};
+        while (windowing_engine->poll_event(event)) {
+            keyboard.handle_event(event);
+            switch (event.type) {
+                case kat::window::event_type::resize:
+                    SPDLOG_DEBUG("Resized to {} x {}", event.resize.width, event.resize.height);
+                    break;
+                case kat::window::event_type::move:
+                case kat::window::event_type::monitor_changed:
+                    pace_to_monitor(pacer);
+                    break;
+                case kat::window::event_type::close_requested:
+                    SPDLOG_INFO("Close requested");
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        kat::input::gamepad_event pad_event{};
+        while (engine->gamepads->poll(pad_event)) {
+            gamepads.handle_event(pad_event);
+        }
+
+        using kat::input::key;
+        if (keyboard.pressed(key::escape)) {
+            SPDLOG_INFO("Closing!");
+            break;
+        } else if (keyboard.pressed(key::space)) {
+            auto size = window->size();
+            auto pos = window->position();
+            SPDLOG_INFO("{} x {} @ {}, {}", size.x, size.y, pos.x, pos.y);
+        } else if (keyboard.pressed(key::s)) {
+            window->size({800, 600});
+        } else if (keyboard.pressed(key::w)) {
+            window->size({600, 800});
+        } else if (keyboard.pressed(key::a)) {
+            window->position(window->position() + glm::ivec2(-100, 0));
+        } else if (keyboard.pressed(key::d)) {
+            window->position(window->position() + glm::ivec2(100, 0));
+        }
+
+        pacer.wait();
     }
 
+    const auto& stats = pacer.stats();
+    SPDLOG_INFO("{} frames, {} missed, average {:.3f} ms, worst lateness {:.3f} ms", stats.frames, stats.missed_frames,
+                std::chrono::duration<double, std::milli>(stats.average_frame_time).count(),
+                std::chrono::duration<double, std::milli>(stats.worst_lateness).count());
 
-//    XEvent event;
-//
-//    auto escape_kc = XKeysymToKeycode(windowing_engine->platform->display, XK_Escape);
-//    auto space_kc = XKeysymToKeycode(windowing_engine->platform->display, XK_space);
-//    auto s_kc = XKeysymToKeycode(windowing_engine->platform->display, XK_s);
-//    auto w_kc = XKeysymToKeycode(windowing_engine->platform->display, XK_w);
-//    auto a_kc = XKeysymToKeycode(windowing_engine->platform->display, XK_a);
-//    auto d_kc = XKeysymToKeycode(windowing_engine->platform->display, XK_d);
-//
-//
-//    while (true) {
-//        XNextEvent(windowing_engine->platform->display, &event);
-//        if (event.type == KeyPress) {
-//            auto keycode = event.xkey.keycode;
-//            if (keycode == escape_kc) {
-//                std::cout << "Closing!" << std::endl;
-//                break;
-//            } else if (keycode == space_kc) {
-//                auto size = window->size();
-//                auto pos = window->position();
-//                SPDLOG_INFO("{} x {} @ {}, {}", size.x, size.y, pos.x, pos.y);
-//            } else if (keycode == s_kc) {
-//                window->size({800, 600});
-//            } else if (keycode == w_kc) {
-//                window->size({600, 800});
-//            } else if (keycode == a_kc) {
-//                window->position(window->position() + glm::ivec2(-100, 0));
-//            } else if (keycode == d_kc) {
-//                window->position(window->position() + glm::ivec2(100, 0));
-//            }
-//        }
-//    }
 
     return EXIT_SUCCESS;
 }
\ No newline at end of file